@@ -10,11 +10,13 @@
 #include "Body.h"
 #include "DebugDraw.h"
 #include "Physics.h"
+#include "ShapeGrid.h"
+#include "ShapeCompound.h"
 
 namespace Framework
 {
 
-	Body::Body()
+	Body::Body(Physics * world)
 	{
 		Position = Vec2(0,0);
     Rotation = 0;
@@ -29,13 +31,24 @@ namespace Framework
 		Friction = 0.0f;
 		Restitution = 0.0f;
 		IsStatic = false;
+		IsKinematic = false;
+		HasKinematicTarget = false;
+		MovedToTarget = false;
+		KinematicTargetRotation = 0.0f;
+		IsSensor = false;
+		World = world;
+		ContactCount = 0;
+		LodActive = true;
+		LodLag = 0;
+		IslandIndex = 0;
 		AccumulatedForce = Vec2(0,0);
 	}
 
 	Body::~Body()
 	{
 		delete BodyShape;
-    PHYSICS->RemoveBody(this);
+    if( World )
+      World->RemoveBody(this);
 	}
 
 	void Body::Integrate(float dt)
@@ -43,6 +56,12 @@ namespace Framework
 		//Do not integrate static bodies
 		if(IsStatic) return;
 
+		if(IsKinematic)
+		{
+			IntegrateKinematic(dt);
+			return;
+		}
+
 		//Store prev position
 		PrevPosition = Position;
 
@@ -50,7 +69,7 @@ namespace Framework
 		Position = Position + Velocity * dt; //acceleration term is small
 
 		//Determine the acceleration
-		Acceleration = PHYSICS->Gravity;
+		Acceleration = World->Gravity;
 		Vec2 newAcceleration = AccumulatedForce * InvMass + Acceleration;
 
 		//Integrate the velocity
@@ -65,20 +84,76 @@ namespace Framework
     
 
 		//Clamp to velocity max for numerical stability
-		if ( Dot(Velocity, Velocity) > PHYSICS->MaxVelocitySq )
+		if ( Dot(Velocity, Velocity) > World->MaxVelocitySq )
 		{
 			Normalize(Velocity);
-			Velocity = Velocity * PHYSICS->MaxVelocity;
+			Velocity = Velocity * World->MaxVelocity;
 		}
 
 		//Clear the force
 		AccumulatedForce = Vec2(0,0);
 	}
 
+	void Body::IntegrateKinematic(float dt)
+	{
+		PrevPosition = Position;
+
+		//Derive the velocity needed to reach the target pose this step so
+		//contacts (friction) see the real motion of the body
+		if(HasKinematicTarget)
+		{
+			Velocity = (KinematicTargetPosition - Position) / dt;
+			AngularVelocity = (KinematicTargetRotation - Rotation) / dt;
+			HasKinematicTarget = false;
+			MovedToTarget = true;
+		}
+
+		//Kinematic bodies ignore gravity, forces and damping
+		Position = Position + Velocity * dt;
+		Rotation = Rotation + AngularVelocity * dt;
+		AccumulatedForce = Vec2(0,0);
+	}
+
+	void Body::IntegrateVelocity(float dt)
+	{
+		if(!IsDynamic()) return;
+
+		Acceleration = World->Gravity;
+		Vec2 newAcceleration = AccumulatedForce * InvMass + Acceleration;
+		Velocity = Velocity + newAcceleration * dt;
+
+		Velocity *= std::pow(Damping, dt);
+		AngularVelocity *= std::pow(Damping, dt);
+
+		if ( Dot(Velocity, Velocity) > World->MaxVelocitySq )
+		{
+			Normalize(Velocity);
+			Velocity = Velocity * World->MaxVelocity;
+		}
+	}
+
+	void Body::IntegratePosition(float dt)
+	{
+		if(!IsDynamic()) return;
+
+		//Uses the velocity the solver just produced (semi-implicit Euler)
+		Position = Position + Velocity * dt;
+		Rotation = Rotation + AngularVelocity * dt;
+	}
+
 	void Body::PublishResults()
 	{
 		tx->Position = Position;
     tx->Rotation = Rotation;
+
+		//A target moves the body for one step only, without a new one it
+		//stays where the target put it
+		if(MovedToTarget)
+		{
+			Velocity = Vec2(0,0);
+			AngularVelocity = 0.0f;
+			MovedToTarget = false;
+		}
 	}
 
   Vec2 Body::GetBodyPointFromWorldPoint(Vec2Param worldPoint)
@@ -112,7 +187,13 @@ namespace Framework
 	{
 
 
-		if(  IsStatic )
+		if( IsSensor )
+		{
+			//Green
+			Drawer::Instance.SetColor( Vec4(0,1,0,1) );
+			BodyShape->Draw();
+		}
+		else if(  IsStatic )
 		{
 			//White
 			Drawer::Instance.SetColor( Vec4(1,1,1,1) );
@@ -120,6 +201,12 @@ namespace Framework
 			//Draw the shape of the object
 			BodyShape->Draw();
 		}
+		else if( IsKinematic )
+		{
+			//Blue
+			Drawer::Instance.SetColor( Vec4(0,0,1,1) );
+			BodyShape->Draw();
+		}
 		else
 		{		
 			//Red
@@ -146,11 +233,20 @@ namespace Framework
 		//Get the starting position
 		Position = tx->Position;
 
-		//Add this body to the body list
-		PHYSICS->Bodies.push_back(this);
+		//Add this body to the body list of its world
+		ErrorIf( World == NULL , "Body was created without a physics world." );
+		World->AddBody(this);
 
+		//Kinematic objects have infinite mass like static objects
+		//but are still integrated
+		if( IsKinematic )
+		{
+			IsStatic = false;
+			InvMass = 0.0f;
+			InvInertia = 0.0f;
+		}
 		//If density is zero, object is interpreted to be static
-		if( Density > 0.0f )
+		else if( Density > 0.0f )
 		{			
 			IsStatic = false;
       //Compute the mass and inertia from the density and shape. Density is
@@ -159,8 +255,18 @@ namespace Framework
       //with larger objects weighing more.
       float mass,inertia;
       BodyShape->ComputeMassAndInertia(Density,mass,inertia);
-			InvMass = 1.0f / mass;
-      InvInertia = 1.0f / inertia;
+      //Shapes that can not move (grids) have no mass at any density
+      if( mass > 0.0f )
+      {
+        InvMass = 1.0f / mass;
+        InvInertia = 1.0f / inertia;
+      }
+      else
+      {
+        IsStatic = true;
+        InvMass = 0.0f;
+        InvInertia = 0.0f;
+      }
 		}
 		else
 		{
@@ -174,13 +280,30 @@ namespace Framework
 
 	void Body::Serialize(ISerializer& stream)
 	{
-		StreamRead(stream,Density);
+		//The density field may be the word Kinematic instead of a number
+		std::string densityValue;
+		StreamRead(stream,densityValue);
+		if( densityValue == "Kinematic" )
+		{
+			IsKinematic = true;
+			Density = 0.0f;
+		}
+		else
+			Density = (float)atof(densityValue.c_str());
+
 		StreamRead(stream,Friction);
 		StreamRead(stream,Restitution);
 
 		std::string shapeName;
 		StreamRead(stream,shapeName);
 
+		//Sensor before the shape name marks the body as a sensor
+		if( shapeName == "Sensor" )
+		{
+			IsSensor = true;
+			StreamRead(stream,shapeName);
+		}
+
 		if( shapeName == "Circle" )
 		{
 			ShapeCircle * shape = new ShapeCircle();
@@ -195,6 +318,23 @@ namespace Framework
 			this->BodyShape  = shape;
 		}
 
+		//Tile grids and heightfields for level geometry
+		if( shapeName == "Grid" || shapeName == "Heightfield" )
+		{
+			ShapeGrid * shape = new ShapeGrid();
+			shape->IsHeightfield = shapeName == "Heightfield";
+			shape->Serialize(stream);
+			this->BodyShape = shape;
+		}
+
+		//Several circles and boxes on one body
+		if( shapeName == "Compound" )
+		{
+			ShapeCompound * shape = new ShapeCompound();
+			shape->Serialize(stream);
+			this->BodyShape = shape;
+		}
+
 	}
 
 	void Body::AddForce(Vec2Param force)
@@ -212,4 +352,12 @@ namespace Framework
 	{
 		Velocity = v;
 	}
+
+	void Body::SetKinematicTarget(Vec2Param position, float rotation)
+	{
+		ErrorIf(!IsKinematic,"Only kinematic bodies can be moved to a target.");
+		KinematicTargetPosition = position;
+		KinematicTargetRotation = rotation;
+		HasKinematicTarget = true;
+	}
 }
@@ -13,20 +13,32 @@
 
 namespace Framework
 {
+	class Physics;
+
 	///Body Component provides basic point physics dynamics including mass, 
 	///velocity, forces, acceleration, and collision resolution.
 	///Component will modify transform component attributes every frame.
 	class Body : public GameComponent
 	{
 	public:
-		Body();
+		///The body joins the world when it is initialized.
+		explicit Body(Physics * world);
 		~Body();
 
 		void AddForce(Vec2Param force);
 		void Integrate(float dt);
+		void IntegrateKinematic(float dt);
+		//Split integration used by substepping. Forces are kept until the
+		//end of the step so every substep sees them.
+		void IntegrateVelocity(float dt);
+		void IntegratePosition(float dt);
 		void SetPosition(Vec2Param);
 		void SetVelocity(Vec2Param);
+		//Move a kinematic body to the given pose over the next step
+		void SetKinematicTarget(Vec2Param position, float rotation);
 		void PublishResults();
+		//Dynamic bodies are the only bodies moved by forces and contacts
+		bool IsDynamic(){return !IsStatic && !IsKinematic;}
 
     Vec2 GetBodyPointFromWorldPoint(Vec2Param worldPoint);
     Vec2 GetWorldPointFromBodyPoint(Vec2Param bodyPoint);
@@ -62,6 +74,30 @@ namespace Framework
 		Shape * BodyShape;
 		//Static object are immovable fixed objects
 		bool IsStatic;
+		//Kinematic objects are moved by their velocity or a target pose
+		//but have infinite mass so contacts and forces do not affect them
+		bool IsKinematic;
+		bool HasKinematicTarget;
+		//The velocity was derived from a target this step and is cleared
+		//once the step is published so the body stops at the target
+		bool MovedToTarget;
+		//Sensors only detect overlaps and send SensorEnter/SensorExit
+		//messages. They never generate contacts or impulses.
+		bool IsSensor;
+		Vec2 KinematicTargetPosition;
+		float KinematicTargetRotation;
+		//Number of contacts the body had in the last step
+		unsigned ContactCount;
+		//The physics world this body belongs to. Given when the body is
+		//created (see Physics::CreateObject) and may only be changed
+		//before Initialize.
+		Physics * World;
+		//Simulation level of detail (see Physics::StepLod). Only active
+		//bodies are integrated and solved in a pass. LodLag is the number
+		//of base steps the body is behind the rest of the world.
+		bool LodActive;
+		unsigned LodLag;
+		unsigned IslandIndex;
 
 
 	};
@@ -0,0 +1,182 @@
+///////////////////////////////////////////////////////////////////////////////////////
+//
+//	BroadPhase.cpp
+//
+//	Authors: Chris Peters
+//	Copyright 2011, Digipen Institute of Technology
+//
+///////////////////////////////////////////////////////////////////////////////////////
+#include "Precompiled.h"
+#include "BroadPhase.h"
+#include "Body.h"
+#include <algorithm>
+
+namespace Framework
+{
+	BroadPhase::BroadPhase()
+	{
+		CellSize = 64.0f;
+		MaxCellsPerBody = 64;
+	}
+
+	unsigned BroadPhase::HashCell(int x, int y)
+	{
+		//Large primes spread neighboring cells across the hash space.
+		//Collisions only cost extra bounds tests, never missed pairs.
+		return (unsigned)x * 73856093u ^ (unsigned)y * 19349663u;
+	}
+
+	int BroadPhase::CellCoordinate(float value)
+	{
+		return (int)floor(value / CellSize);
+	}
+
+	void BroadPhase::Build(ObjectLinkList<Body>& bodies, float margin, bool activeOnly)
+	{
+		Proxies.clear();
+		Entries.clear();
+		LargeProxies.clear();
+
+		//Proxies are stored in body list order so sorting by proxy
+		//index reproduces the order of the body list
+		for(ObjectLinkList<Body>::iterator it=bodies.begin();it!=bodies.end();++it)
+		{
+			if( activeOnly && it->IsDynamic() && !it->LodActive )
+				continue;
+			Proxy proxy;
+			proxy.ProxyBody = it;
+			proxy.Bounds = it->BodyShape->ComputeAabb();
+			proxy.Bounds.Min -= Vec2(margin,margin);
+			proxy.Bounds.Max += Vec2(margin,margin);
+			Proxies.push_back(proxy);
+		}
+
+		for(unsigned i=0;i<Proxies.size();++i)
+		{
+			Aabb& bounds = Proxies[i].Bounds;
+			int minX = CellCoordinate(bounds.Min.x);
+			int minY = CellCoordinate(bounds.Min.y);
+			int maxX = CellCoordinate(bounds.Max.x);
+			int maxY = CellCoordinate(bounds.Max.y);
+
+			//Huge bodies like the ground would fill too many cells
+			unsigned cellCount = (maxX - minX + 1) * (maxY - minY + 1);
+			if( cellCount > MaxCellsPerBody )
+			{
+				LargeProxies.push_back(i);
+				continue;
+			}
+
+			for(int y=minY;y<=maxY;++y)
+			{
+				for(int x=minX;x<=maxX;++x)
+				{
+					CellEntry entry;
+					entry.Cell = HashCell(x,y);
+					entry.ProxyIndex = i;
+					Entries.push_back(entry);
+				}
+			}
+		}
+
+		//Sorting groups the entries of each cell together
+		std::sort(Entries.begin(), Entries.end());
+	}
+
+	void BroadPhase::FindPairs(BodyPairArray& pairs)
+	{
+		//Pairs are collected as (lower index, higher index) keys so
+		//pairs found in several cells can be removed by sorting.
+		//The vector is kept between calls to reuse its memory.
+		std::vector<unsigned long long>& keys = PairKeys;
+		keys.clear();
+
+		unsigned runStart = 0;
+		while( runStart < Entries.size() )
+		{
+			unsigned runEnd = runStart + 1;
+			while( runEnd < Entries.size() && Entries[runEnd].Cell == Entries[runStart].Cell )
+				++runEnd;
+
+			for(unsigned a=runStart;a<runEnd;++a)
+			{
+				unsigned indexA = Entries[a].ProxyIndex;
+				for(unsigned b=a+1;b<runEnd;++b)
+				{
+					unsigned indexB = Entries[b].ProxyIndex;
+					if( Proxies[indexA].Bounds.Overlaps(Proxies[indexB].Bounds) )
+						keys.push_back( (unsigned long long)indexA << 32 | indexB );
+				}
+			}
+			runStart = runEnd;
+		}
+
+		//Large proxies are tested against everything
+		for(unsigned l=0;l<LargeProxies.size();++l)
+		{
+			unsigned large = LargeProxies[l];
+			for(unsigned i=0;i<Proxies.size();++i)
+			{
+				if( i == large ) continue;
+				if( Proxies[large].Bounds.Overlaps(Proxies[i].Bounds) )
+				{
+					unsigned indexA = std::min(large,i);
+					unsigned indexB = std::max(large,i);
+					keys.push_back( (unsigned long long)indexA << 32 | indexB );
+				}
+			}
+		}
+
+		std::sort(keys.begin(), keys.end());
+		keys.erase( std::unique(keys.begin(), keys.end()) , keys.end() );
+
+		pairs.clear();
+		for(unsigned i=0;i<keys.size();++i)
+		{
+			BodyPair pair;
+			pair.Bodies[0] = Proxies[(unsigned)(keys[i] >> 32)].ProxyBody;
+			pair.Bodies[1] = Proxies[(unsigned)(keys[i] & 0xFFFFFFFF)].ProxyBody;
+			pair.Cache = NULL;
+			pairs.push_back(pair);
+		}
+	}
+
+	void BroadPhase::Query(const Aabb& box, std::vector<Body*>& results)
+	{
+		QueryScratch.clear();
+
+		int minX = CellCoordinate(box.Min.x);
+		int minY = CellCoordinate(box.Min.y);
+		int maxX = CellCoordinate(box.Max.x);
+		int maxY = CellCoordinate(box.Max.y);
+
+		for(int y=minY;y<=maxY;++y)
+		{
+			for(int x=minX;x<=maxX;++x)
+			{
+				//Binary search for the first entry in the cell
+				CellEntry key;
+				key.Cell = HashCell(x,y);
+				key.ProxyIndex = 0;
+				std::vector<CellEntry>::iterator it = std::lower_bound(Entries.begin(), Entries.end(), key);
+				for(;it!=Entries.end() && it->Cell == key.Cell;++it)
+				{
+					if( Proxies[it->ProxyIndex].Bounds.Overlaps(box) )
+						QueryScratch.push_back(it->ProxyIndex);
+				}
+			}
+		}
+
+		for(unsigned l=0;l<LargeProxies.size();++l)
+		{
+			if( Proxies[LargeProxies[l]].Bounds.Overlaps(box) )
+				QueryScratch.push_back(LargeProxies[l]);
+		}
+
+		std::sort(QueryScratch.begin(), QueryScratch.end());
+		QueryScratch.erase( std::unique(QueryScratch.begin(), QueryScratch.end()) , QueryScratch.end() );
+
+		for(unsigned i=0;i<QueryScratch.size();++i)
+			results.push_back(Proxies[QueryScratch[i]].ProxyBody);
+	}
+}
@@ -0,0 +1,69 @@
+///////////////////////////////////////////////////////////////////////////////////////
+///
+///	\file BroadPhase.h
+///	Spatial hash grid used to find candidate collision pairs and to answer
+///	region queries without testing every body.
+///
+///	Authors: Chris Peters
+///	Copyright 2011, Digipen Institute of Technology
+///
+///////////////////////////////////////////////////////////////////////////////////////
+#pragma once //Makes sure this header is only included once
+
+#include "Collision.h"
+#include "NarrowPhase.h"
+
+namespace Framework
+{
+	///Uniform grid of hashed cells. Bodies are inserted into every cell their
+	///bounds touch. The grid is rebuilt from scratch each step, which is cheap
+	///since it is just a sort of (cell,body) entries.
+	class BroadPhase
+	{
+	public:
+		BroadPhase();
+
+		///Rebuild the grid from the current body positions. Bounds are grown
+		///by the margin. If activeOnly is set dynamic bodies that are not
+		///LodActive are left out.
+		void Build(ObjectLinkList<Body>& bodies, float margin = 0.0f, bool activeOnly = false);
+		///Find all pairs of bodies whose bounds overlap. Pairs are returned
+		///in the same order as the N^2 loop over the body list would.
+		void FindPairs(BodyPairArray& pairs);
+		///Find all bodies whose bounds overlap the box, in body list order.
+		void Query(const Aabb& box, std::vector<Body*>& results);
+
+		///Size of a grid cell in world units.
+		float CellSize;
+		///Bodies covering more cells than this are kept out of the grid
+		///and tested against everything instead.
+		unsigned MaxCellsPerBody;
+
+	private:
+		struct Proxy
+		{
+			Body * ProxyBody;
+			Aabb Bounds;
+		};
+
+		struct CellEntry
+		{
+			unsigned Cell;
+			unsigned ProxyIndex;
+			bool operator<(const CellEntry& other) const
+			{
+				if( Cell != other.Cell ) return Cell < other.Cell;
+				return ProxyIndex < other.ProxyIndex;
+			}
+		};
+
+		unsigned HashCell(int x, int y);
+		int CellCoordinate(float value);
+
+		std::vector<Proxy> Proxies;
+		std::vector<CellEntry> Entries;
+		std::vector<unsigned> LargeProxies;
+		std::vector<unsigned> QueryScratch;
+		std::vector<unsigned long long> PairKeys;
+	};
+}
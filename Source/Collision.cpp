@@ -10,6 +10,8 @@
 #include "Collision.h"
 #include "Physics.h"
 #include "DebugDraw.h"
+#include "ShapeGrid.h"
+#include "ShapeCompound.h"
 
 namespace Framework
 {
@@ -31,6 +33,19 @@ namespace Framework
 			return false;
 	}
 
+	bool ShapeCircle::TestSegment(Vec2 start, Vec2 end)
+	{
+		return SegmentCircle(start, end, body->Position, Radius);
+	}
+
+	Aabb ShapeCircle::ComputeAabb()
+	{
+		Aabb box;
+		box.Min = body->Position - Vec2(Radius,Radius);
+		box.Max = body->Position + Vec2(Radius,Radius);
+		return box;
+	}
+
   void ShapeCircle::ComputeMassAndInertia(float density, float& mass, float& inertia)
   {
     float radiusSquared = Radius * Radius;
@@ -64,6 +79,28 @@ namespace Framework
 		return false;
 	}
 
+	bool ShapeAAB::TestSegment(Vec2 start, Vec2 end)
+	{
+		Mat2 rot;
+		rot.BuildRotation(body->Rotation);
+		Vec2 axes[2];
+		rot.GetBases(axes[0],axes[1]);
+		return SegmentBox(start, end, body->Position, Extents, axes);
+	}
+
+	Aabb ShapeAAB::ComputeAabb()
+	{
+		//The world extents of a rotated box are the absolute
+		//values of its axes scaled by the local extents
+		float c = fabs(cos(body->Rotation));
+		float s = fabs(sin(body->Rotation));
+		Vec2 half( c * Extents.x + s * Extents.y , s * Extents.x + c * Extents.y );
+		Aabb box;
+		box.Min = body->Position - half;
+		box.Max = body->Position + half;
+		return box;
+	}
+
   void ShapeAAB::ComputeMassAndInertia(float density, float& mass, float& inertia)
   {
     float width = Extents.x;
@@ -76,7 +113,7 @@ namespace Framework
 
 	/////////////////////Collsion Detection Functions////////////////////
 
-	bool DetectCollisionCircleCircle(Body*a, Body*b, Manifold* m)
+	bool DetectCollisionCircleCircle(Body*a, Body*b, Manifold* m, SatCache* /*cache*/)
 	{
     ShapeCircle* circleA = (ShapeCircle*)a->BodyShape;
     Vec2 circleAPos = a->Position;
@@ -89,7 +126,7 @@ namespace Framework
     return CircleCirlce(circleAPos,circleARadius,circleBPos,circleBRadius,m);
 	}
 
-	bool  DetectCollisionAABoxAABox(Body*a, Body*b, Manifold* m)
+	bool  DetectCollisionAABoxAABox(Body*a, Body*b, Manifold* m, SatCache* cache)
 	{
     ShapeAAB* boxA = (ShapeAAB*)a->BodyShape;
     ShapeAAB* boxB = (ShapeAAB*)b->BodyShape;
@@ -108,12 +145,12 @@ namespace Framework
     boxBRot.GetBases(boxBAxes[0],boxBAxes[1]);
 
 
-    return BoxBox(boxAPos,boxAHalfExtents,boxAAxes,boxBPos,boxBHalfExtents,boxBAxes,m);
+    return BoxBox(boxAPos,boxAHalfExtents,boxAAxes,boxBPos,boxBHalfExtents,boxBAxes,m,cache);
 	}
 
 
 	//Auxiliary
-	bool  DetectCollisionBoxCircle(Body*a, Body*b, Manifold* m)
+	bool  DetectCollisionBoxCircle(Body*a, Body*b, Manifold* m, SatCache* /*cache*/)
 	{
     ShapeCircle* circle = (ShapeCircle*)b->BodyShape;
     Vec2 circlePos = b->Position;
@@ -129,34 +166,189 @@ namespace Framework
     return BoxCircle(boxPos,boxHalfExtents,boxAxes,circlePos,circleRadius,m);
 	}
 
-  bool  DetectCollisionCircleAABox(Body*a, Body*b, Manifold* m)
+  bool  DetectCollisionCircleAABox(Body*a, Body*b, Manifold* m, SatCache* /*cache*/)
 	{
     //since we swapped the shape ordering we have to swap the normal direction too
-    if(DetectCollisionBoxCircle(b,a,m))
+    if(DetectCollisionBoxCircle(b,a,m,NULL))
     {
-      m->Normal *= -1;
+      if(m != NULL)
+        m->Normal *= -1;
       return true;
     }
     return false;
 	}
 
 
+	unsigned DetectCollisionGridCircle(Body*a, Body*b, Manifold* manifolds, unsigned maxManifolds)
+	{
+		ShapeGrid* grid = (ShapeGrid*)a->BodyShape;
+		ShapeCircle* circle = (ShapeCircle*)b->BodyShape;
+		return grid->CollideCircle(b->Position, circle->Radius, manifolds, maxManifolds);
+	}
+
+	unsigned DetectCollisionGridBox(Body*a, Body*b, Manifold* manifolds, unsigned maxManifolds)
+	{
+		ShapeGrid* grid = (ShapeGrid*)a->BodyShape;
+		ShapeAAB* box = (ShapeAAB*)b->BodyShape;
+		Mat2 boxRot;
+		boxRot.BuildRotation(b->Rotation);
+		Vec2 boxAxes[2];
+		boxRot.GetBases(boxAxes[0],boxAxes[1]);
+		return grid->CollideBox(b->Position, box->Extents, boxAxes, manifolds, maxManifolds);
+	}
+
+	unsigned DetectCollisionGridGrid(Body*a, Body*b, Manifold* manifolds, unsigned maxManifolds)
+	{
+		//Grids are static and never collide with each other
+		return 0;
+	}
+
+	//Run a test with the bodies swapped and swap the results back
+	static unsigned SwapManifolds(Manifold* manifolds, unsigned count)
+	{
+		if( manifolds == NULL )
+			return count;
+		for(unsigned i=0;i<count;++i)
+		{
+			manifolds[i].Normal *= -1;
+			for(unsigned p=0;p<manifolds[i].PointCount;++p)
+				std::swap(manifolds[i].Points[p].Points[0], manifolds[i].Points[p].Points[1]);
+		}
+		return count;
+	}
+
+	unsigned DetectCollisionCircleGrid(Body*a, Body*b, Manifold* manifolds, unsigned maxManifolds)
+	{
+		return SwapManifolds(manifolds, DetectCollisionGridCircle(b,a,manifolds,maxManifolds));
+	}
+
+	unsigned DetectCollisionBoxGrid(Body*a, Body*b, Manifold* manifolds, unsigned maxManifolds)
+	{
+		return SwapManifolds(manifolds, DetectCollisionGridBox(b,a,manifolds,maxManifolds));
+	}
+
+	//A body's shape as a part for the compound tests
+	static void GetBodyPart(Body* body, ShapePart& part)
+	{
+		part.Id = body->BodyShape->Id;
+		part.Center = body->Position;
+		Mat2 rot;
+		rot.BuildRotation(body->Rotation);
+		rot.GetBases(part.Axes[0],part.Axes[1]);
+		part.Radius = 0.0f;
+		part.Extents = Vec2(0,0);
+		if( part.Id == Shape::SidCircle )
+			part.Radius = ((ShapeCircle*)body->BodyShape)->Radius;
+		else
+			part.Extents = ((ShapeAAB*)body->BodyShape)->Extents;
+	}
+
+	unsigned DetectCollisionCompoundShape(Body*a, Body*b, Manifold* manifolds, unsigned maxManifolds)
+	{
+		ShapePart part;
+		GetBodyPart(b, part);
+		return ((ShapeCompound*)a->BodyShape)->CollidePart(part, manifolds, maxManifolds);
+	}
+
+	unsigned DetectCollisionShapeCompound(Body*a, Body*b, Manifold* manifolds, unsigned maxManifolds)
+	{
+		return SwapManifolds(manifolds, DetectCollisionCompoundShape(b,a,manifolds,maxManifolds));
+	}
+
+	unsigned DetectCollisionCompoundCompound(Body*a, Body*b, Manifold* manifolds, unsigned maxManifolds)
+	{
+		//Each child of b is found in the tree of a
+		ShapeCompound* compoundA = (ShapeCompound*)a->BodyShape;
+		ShapeCompound* compoundB = (ShapeCompound*)b->BodyShape;
+		unsigned written = 0;
+		for(unsigned i=0;i<compoundB->Children.size() && (manifolds == NULL || written < maxManifolds);++i)
+		{
+			ShapePart part;
+			compoundB->GetPart(i, part);
+			unsigned count = compoundA->CollidePart(part, manifolds ? manifolds + written : NULL, maxManifolds - written);
+			if( manifolds == NULL && count > 0 )
+				return 1;
+			written += count;
+		}
+		return written;
+	}
+
+	unsigned DetectCollisionCompoundGrid(Body*a, Body*b, Manifold* manifolds, unsigned maxManifolds)
+	{
+		return ((ShapeCompound*)a->BodyShape)->CollideGrid((ShapeGrid*)b->BodyShape, manifolds, maxManifolds);
+	}
+
+	unsigned DetectCollisionGridCompound(Body*a, Body*b, Manifold* manifolds, unsigned maxManifolds)
+	{
+		return SwapManifolds(manifolds, DetectCollisionCompoundGrid(b,a,manifolds,maxManifolds));
+	}
+
 	CollsionDatabase::CollsionDatabase()
 	{
+		for(unsigned a=0;a<Shape::SidNumberOfShapes;++a)
+		{
+			for(unsigned b=0;b<Shape::SidNumberOfShapes;++b)
+			{
+				CollsionRegistry[a][b] = NULL;
+				MultiRegistry[a][b] = NULL;
+			}
+		}
+
 		//Register collision tests for all the shape types
 		RegisterCollsionTest( Shape::SidCircle , Shape::SidCircle , DetectCollisionCircleCircle );
 		RegisterCollsionTest( Shape::SidBox , Shape::SidBox , DetectCollisionAABoxAABox );
 		RegisterCollsionTest( Shape::SidCircle , Shape::SidBox , DetectCollisionCircleAABox );
 		RegisterCollsionTest( Shape::SidBox , Shape::SidCircle , DetectCollisionBoxCircle );
+
+		//Grids can touch a body on several faces at once
+		RegisterMultiCollsionTest( Shape::SidGrid , Shape::SidCircle , DetectCollisionGridCircle );
+		RegisterMultiCollsionTest( Shape::SidGrid , Shape::SidBox , DetectCollisionGridBox );
+		RegisterMultiCollsionTest( Shape::SidCircle , Shape::SidGrid , DetectCollisionCircleGrid );
+		RegisterMultiCollsionTest( Shape::SidBox , Shape::SidGrid , DetectCollisionBoxGrid );
+		RegisterMultiCollsionTest( Shape::SidGrid , Shape::SidGrid , DetectCollisionGridGrid );
+
+		//Compounds test their children with the basic tests
+		RegisterMultiCollsionTest( Shape::SidCompound , Shape::SidCircle , DetectCollisionCompoundShape );
+		RegisterMultiCollsionTest( Shape::SidCompound , Shape::SidBox , DetectCollisionCompoundShape );
+		RegisterMultiCollsionTest( Shape::SidCircle , Shape::SidCompound , DetectCollisionShapeCompound );
+		RegisterMultiCollsionTest( Shape::SidBox , Shape::SidCompound , DetectCollisionShapeCompound );
+		RegisterMultiCollsionTest( Shape::SidCompound , Shape::SidCompound , DetectCollisionCompoundCompound );
+		RegisterMultiCollsionTest( Shape::SidCompound , Shape::SidGrid , DetectCollisionCompoundGrid );
+		RegisterMultiCollsionTest( Shape::SidGrid , Shape::SidCompound , DetectCollisionGridCompound );
 	}
 
-  bool CollsionDatabase::GenerateContacts(Body* bodyA, Body* bodyB, Manifold* m)
+  bool CollsionDatabase::GenerateContacts(Body* bodyA, Body* bodyB, Manifold* m, SatCache* cache)
   {
-    return (*CollsionRegistry[bodyA->BodyShape->Id][bodyB->BodyShape->Id])(bodyA,bodyB,m);
+    MultiCollisionTest multiTest = MultiRegistry[bodyA->BodyShape->Id][bodyB->BodyShape->Id];
+    if(multiTest != NULL)
+      return (*multiTest)(bodyA,bodyB,m,m ? 1 : 0) != 0;
+    return (*CollsionRegistry[bodyA->BodyShape->Id][bodyB->BodyShape->Id])(bodyA,bodyB,m,cache);
+  }
+
+  unsigned CollsionDatabase::GenerateManifolds(Body* bodyA, Body* bodyB, Manifold* manifolds, unsigned maxManifolds, SatCache* cache)
+  {
+    MultiCollisionTest multiTest = MultiRegistry[bodyA->BodyShape->Id][bodyB->BodyShape->Id];
+    if(multiTest != NULL)
+      return (*multiTest)(bodyA,bodyB,manifolds,maxManifolds);
+    return GenerateContacts(bodyA,bodyB,manifolds,cache) ? 1 : 0;
+  }
+
+  bool CollsionDatabase::TestOverlap(Body* bodyA, Body* bodyB)
+  {
+    MultiCollisionTest multiTest = MultiRegistry[bodyA->BodyShape->Id][bodyB->BodyShape->Id];
+    if(multiTest != NULL)
+      return (*multiTest)(bodyA,bodyB,NULL,0) != 0;
+    //Passing no manifold makes the tests skip computing contact data
+    return (*CollsionRegistry[bodyA->BodyShape->Id][bodyB->BodyShape->Id])(bodyA,bodyB,NULL,NULL);
   }
 
   void CollsionDatabase::RegisterCollsionTest(Shape::ShapeId a , Shape::ShapeId b, CollisionTest test)
   {
     CollsionRegistry[a][b] = test;
   }
+
+  void CollsionDatabase::RegisterMultiCollsionTest(Shape::ShapeId a , Shape::ShapeId b, MultiCollisionTest test)
+  {
+    MultiRegistry[a][b] = test;
+  }
 }
\ No newline at end of file
@@ -18,6 +18,18 @@ namespace Framework
 {
 	class Body;
 
+	///Axis aligned bounding box in world space.
+	struct Aabb
+	{
+		Vec2 Min;
+		Vec2 Max;
+		bool Overlaps(const Aabb& other) const
+		{
+			return Min.x <= other.Max.x && other.Min.x <= Max.x &&
+			       Min.y <= other.Max.y && other.Min.y <= Max.y;
+		}
+	};
+
 	///Base Shape class
 	class Shape
 	{
@@ -26,13 +38,23 @@ namespace Framework
 		{
 			SidCircle,
 			SidBox,
+			SidGrid,
+			SidCompound,
 			SidNumberOfShapes
 		};
 		ShapeId Id;
 		Body * body;
 		Shape( ShapeId pid ) : Id(pid) {};
+		///Shapes are deleted through this class by their body.
+		virtual ~Shape(){}
 		virtual void Draw()=0;
 		virtual bool TestPoint(Vec2)=0;
+		///Does the segment from start to end touch the shape?
+		virtual bool TestSegment(Vec2 start, Vec2 end)=0;
+		///Bounds of the shape at the body's current position.
+		virtual Aabb ComputeAabb()=0;
+    ///Mass and inertia at a density. Shapes that can not move return a
+    ///mass of zero, which makes the body static.
     virtual void ComputeMassAndInertia(float density, float& mass, float& inertia) = 0;
 	};
 
@@ -44,6 +66,8 @@ namespace Framework
 		float Radius;
 		virtual void Draw();
 		virtual bool TestPoint(Vec2);
+		virtual bool TestSegment(Vec2 start, Vec2 end);
+		virtual Aabb ComputeAabb();
     virtual void ComputeMassAndInertia(float density, float& mass, float& inertia);
 	};
 
@@ -55,21 +79,37 @@ namespace Framework
 		Vec2 Extents;
 		virtual void Draw();
 		virtual bool TestPoint(Vec2);
+		virtual bool TestSegment(Vec2 start, Vec2 end);
+		virtual Aabb ComputeAabb();
     virtual void ComputeMassAndInertia(float density, float& mass, float& inertia);
 	};
 
 	class ContactSet;
-	typedef bool (*CollisionTest)(Body* bodyA, Body* bodyB, Manifold* m);
+	typedef bool (*CollisionTest)(Body* bodyA, Body* bodyB, Manifold* m, SatCache* cache);
+	///Test for shapes made of many parts that can touch a body in several
+	///directions at once. Returns the number of manifolds written. With no
+	///manifolds it only tests for overlap and returns 1 if there is one.
+	typedef unsigned (*MultiCollisionTest)(Body* bodyA, Body* bodyB, Manifold* manifolds, unsigned maxManifolds);
 
 	///The collision database provides collision detection between shape types.
 	class CollsionDatabase
 	{
 	public:	
 		CollsionDatabase();
+		///Most manifolds one pair can produce.
+		enum { MaxManifolds = 8 };
 		CollisionTest CollsionRegistry[Shape::SidNumberOfShapes][Shape::SidNumberOfShapes];
+		MultiCollisionTest MultiRegistry[Shape::SidNumberOfShapes][Shape::SidNumberOfShapes];
 
-    bool GenerateContacts(Body* bodyA, Body* bodyB, Manifold* m);
+    ///The cache is optional and only used by tests that support it.
+    bool GenerateContacts(Body* bodyA, Body* bodyB, Manifold* m, SatCache* cache = NULL);
+    ///Generate all the manifolds of a pair. Single manifold tests
+    ///produce at most one. Returns the number written.
+    unsigned GenerateManifolds(Body* bodyA, Body* bodyB, Manifold* manifolds, unsigned maxManifolds, SatCache* cache = NULL);
+    ///Boolean only test used by sensors.
+    bool TestOverlap(Body* bodyA, Body* bodyB);
     void RegisterCollsionTest(Shape::ShapeId a , Shape::ShapeId b, CollisionTest test);
+    void RegisterMultiCollsionTest(Shape::ShapeId a , Shape::ShapeId b, MultiCollisionTest test);
 	};
 
 }
\ No newline at end of file
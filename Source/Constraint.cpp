@@ -81,7 +81,10 @@ namespace Framework
   Constraint::Constraint() 
   { 
     Valid = true; 
+    SolvedDirectly = false;
     MaxForce = PositiveMax();
+    Bodies[0] = NULL;
+    Bodies[1] = NULL;
   }
 
   Constraint::~Constraint()
@@ -95,6 +98,16 @@ namespace Framework
     Bodies[1] = body2;
   }
 
+  bool Constraint::IsActive()
+  {
+    for(unsigned int i = 0; i < 2; ++i)
+    {
+      if(Bodies[i] && Bodies[i]->IsDynamic() && Bodies[i]->LodActive)
+        return true;
+    }
+    return false;
+  }
+
   void Constraint::ApplyConstraintImpulse(Jacobian& jacobian, float impulseMagnitude)
   {
     //The resultant impulse is the magnitude to apply while the jacobian is the direction.
@@ -51,11 +51,24 @@ namespace Framework
 
     virtual void Update(float dt) = 0;
     virtual void SolveIteration(float dt) = 0;
+    ///Sticks can be solved exactly by the direct tree solver.
+    virtual bool IsStick() { return false; }
+    ///Substepping: scale the impulse kept from the last substep, apply it
+    ///and make it the start of this substep's accumulated impulse.
+    virtual void WarmStart(float /*scale*/) {}
+    ///Forget the impulse accumulated so far.
+    virtual void ClearImpulse() {}
+    ///Queue debug lines for the constraint. Only called by the world's
+    ///DebugDraw, never while the world steps.
+    virtual void DebugDraw() {}
 
     void SetBodies(Body* body1, Body* body2);
     void ApplyConstraintImpulse(Jacobian& jacobian, float impulseMagnitude);
     float CalculateJV(Jacobian& Jacobian, ConstraintVelocity& velocities);
     float CalculateEffectiveMass(Jacobian& jacobian);
+    ///False when none of the bodies are being simulated this pass (see
+    ///Physics level of detail).
+    bool IsActive();
 
     //Linked list Nodes
     Constraint * Next;
@@ -64,6 +77,9 @@ namespace Framework
   protected:
     friend class ConstraintSolver;
     bool Valid;
+    ///Set by the solver when the constraint is part of a tree that is
+    ///solved directly instead of iteratively.
+    bool SolvedDirectly;
     float MaxForce;
     Body* Bodies[2];
   };
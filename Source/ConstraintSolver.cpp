@@ -1,6 +1,8 @@
 #include "Precompiled.h"
 
 #include "ConstraintSolver.h"
+#include "Body.h"
+#include <map>
 
 namespace Framework
 {
@@ -8,6 +10,7 @@ namespace Framework
   ConstraintSolver::ConstraintSolver()
   {
     IterationCount = 15;
+    LastSubstep = 0.0f;
   }
 
   ConstraintSolver::~ConstraintSolver()
@@ -29,18 +32,11 @@ namespace Framework
     }
   }
 
-  void ConstraintSolver::ClearContacts()
+  void ConstraintSolver::SetContacts(ContactArray& contacts)
   {
-    NumberOfContacts = 0;
-  }
-
-  void ConstraintSolver::AddContact(BodyManifold* contact)
-  {
-    ErrorIf(NumberOfContacts==MaxContacts,"Maximum number of contacts reached. There is too many colliding objects in the simulation.");
-    ContactConstraint& contactConstraint = contactArray[NumberOfContacts];
-    ++NumberOfContacts;
-
-    contactConstraint.Set(contact);
+    ContactConstraints.resize(contacts.size());
+    for(unsigned int i = 0; i < contacts.size(); ++i)
+      ContactConstraints[i].Set(&contacts[i]);
   }
 
   void ConstraintSolver::AddConstraint(Constraint* constraint)
@@ -72,9 +68,38 @@ namespace Framework
     }
   }
 
+  void ConstraintSolver::DebugDraw()
+  {
+    ConstraintIterator end = Constraints.end();
+    for(ConstraintIterator c = Constraints.begin(); c != end; ++c)
+      c->DebugDraw();
+  }
+
+  void ConstraintSolver::GetConnectedPairs(BodyPairArray& pairs)
+  {
+    ConstraintIterator start = Constraints.begin();
+    ConstraintIterator end = Constraints.end();
+    for(; start != end; ++start)
+    {
+      if(start->Bodies[0] && start->Bodies[1])
+      {
+        BodyPair pair;
+        pair.Bodies[0] = start->Bodies[0];
+        pair.Bodies[1] = start->Bodies[1];
+        pair.Cache = NULL;
+        pairs.push_back(pair);
+      }
+    }
+  }
+
   void ConstraintSolver::Solve(float dt)
   {
+    //Without warm starting every step starts from no impulse, which also
+    //keeps the clamps bounding the impulse of this step alone
+    ClearImpulses();
     Update(dt);
+    BuildTrees();
+    FactorTrees();
     WarmStart(dt);
     //This solver is iterative, that means it takes several full iterations
     //over the entire set to converge to a correct answer.
@@ -82,6 +107,67 @@ namespace Framework
       SolveIteration(dt);
   }
 
+  void ConstraintSolver::BeginSubsteps()
+  {
+    //Impulses left by a step that was solved another way are stale
+    if(LastSubstep == 0.0f)
+      ClearImpulses();
+
+    //Which sticks form trees does not change during a step
+    BuildTrees();
+  }
+
+  void ConstraintSolver::SkipSubsteps()
+  {
+    LastSubstep = 0.0f;
+  }
+
+  void ConstraintSolver::SolveSubstep(float h)
+  {
+    //The bodies moved in the last substep so the jacobians and biases
+    //are rebuilt.
+    Update(h);
+    FactorTrees();
+
+    //A single iteration is far from converged, so each substep starts
+    //from the impulses of the one before. Impulses grow with the time
+    //they act over, so they are rescaled to this substep's length. They
+    //also hold the position correction of the last substep, which is
+    //applied again by this substep's bias, so only part of them is kept.
+    const float warmStartFraction = 0.8f;
+    float scale = LastSubstep > 0.0f ? warmStartFraction * h / LastSubstep : 0.0f;
+    LastSubstep = h;
+    WarmStartSubstep(scale);
+    SolveIteration(h);
+  }
+
+  void ConstraintSolver::WarmStartSubstep(float scale)
+  {
+    //Applying the old impulse and keeping it as the accumulated impulse
+    //means the clamps in SolveIteration bound the total impulse of this
+    //substep alone. Contacts can not pull in one substep to cancel a push
+    //from an earlier one.
+    ConstraintIterator start = Constraints.begin();
+    ConstraintIterator end = Constraints.end();
+    for(; start != end; ++start)
+    {
+      if(!start->SolvedDirectly && start->IsActive())
+        start->WarmStart(scale);
+    }
+
+    for(unsigned int i = 0; i < ContactConstraints.size(); ++i)
+      ContactConstraints[i].WarmStart(scale);
+  }
+
+  void ConstraintSolver::ClearImpulses()
+  {
+    ConstraintIterator start = Constraints.begin();
+    ConstraintIterator end = Constraints.end();
+    for(; start != end; ++start)
+      start->ClearImpulse();
+    LastSubstep = 0.0f;
+  }
+
   void ConstraintSolver::Update(float dt)
   {
     //first we need to update all of the constraints.
@@ -89,10 +175,13 @@ namespace Framework
     ConstraintIterator start = Constraints.begin();
     ConstraintIterator end = Constraints.end();
     for(; start != end; ++start)
-      start->Update(dt);
+    {
+      if(start->IsActive())
+        start->Update(dt);
+    }
 
-    for(unsigned int i = 0; i < NumberOfContacts; ++i)
-      contactArray[i].Update(dt);
+    for(unsigned int i = 0; i < ContactConstraints.size(); ++i)
+      ContactConstraints[i].Update(dt);
   }
 
   void ConstraintSolver::WarmStart(float dt)
@@ -110,9 +199,419 @@ namespace Framework
     ConstraintIterator start = Constraints.begin();
     ConstraintIterator end = Constraints.end();
     for(; start != end; ++start)
-      start->SolveIteration(dt);
+    {
+      if(!start->SolvedDirectly && start->IsActive())
+        start->SolveIteration(dt);
+    }
+
+    for(unsigned int i = 0; i < ContactConstraints.size(); ++i)
+      ContactConstraints[i].SolveIteration(dt);
+
+    //The trees are solved exactly given the velocities left by the
+    //contacts, so chains stay rigid while still reacting to contacts
+    SolveTrees();
+  }
+
+  /*Direct solver for trees of sticks (Baraff, "Linear-Time Dynamics using
+    Lagrange Multipliers"). Instead of solving J * M^-1 * J^T * lambda = r,
+    which is dense when bodies have several sticks, we solve the larger but
+    sparse system
+      [ M  J^T ] [ y      ]   [  0 ]
+      [ J   0  ] [ lambda ] = [ -r ]
+    whose graph has a node per body and per stick. If that graph is a tree,
+    eliminating the nodes leaves first never creates new non zeros, so the
+    factorization and the solve are both O(n). The root must be a body or a
+    stick with a single dynamic body since a stick's diagonal block is zero
+    until its children are eliminated.
+  */
+
+  void ConstraintSolver::GetStickRow(StickConstraint* stick, Body* body, float* row)
+  {
+    //The part of the stick's jacobian that acts on the body
+    Jacobian& jacobian = stick->StickJacobian;
+    if(stick->Bodies[0] == body)
+    {
+      row[0] = jacobian.Linear1.x;
+      row[1] = jacobian.Linear1.y;
+      row[2] = jacobian.Angular1;
+    }
+    else
+    {
+      row[0] = jacobian.Linear2.x;
+      row[1] = jacobian.Linear2.y;
+      row[2] = jacobian.Angular2;
+    }
+  }
+
+  void ConstraintSolver::BuildTrees()
+  {
+    TreeNodes.clear();
+    GraphSticks.clear();
+    GraphBodies.clear();
+
+    //Only unbreakable sticks can be solved exactly
+    ConstraintIterator start = Constraints.begin();
+    ConstraintIterator end = Constraints.end();
+    for(; start != end; ++start)
+    {
+      start->SolvedDirectly = false;
+      if(start->IsStick() && start->MaxForce == PositiveMax() && start->IsActive())
+        GraphSticks.push_back((StickConstraint*)&*start);
+    }
+
+    //Static and kinematic bodies are not nodes, they just end the tree
+    unsigned stickCount = GraphSticks.size();
+    std::map<Body*,unsigned> bodyNodes;
+    for(unsigned int s = 0; s < stickCount; ++s)
+    {
+      for(unsigned int k = 0; k < 2; ++k)
+      {
+        Body* body = GraphSticks[s]->Bodies[k];
+        if(body->InvMass != 0.0f && bodyNodes.find(body) == bodyNodes.end())
+        {
+          bodyNodes[body] = stickCount + GraphBodies.size();
+          GraphBodies.push_back(body);
+        }
+      }
+    }
+
+    unsigned nodeCount = stickCount + GraphBodies.size();
+    Adjacency.resize(nodeCount);
+    for(unsigned int i = 0; i < nodeCount; ++i)
+      Adjacency[i].clear();
+
+    for(unsigned int s = 0; s < stickCount; ++s)
+    {
+      Body* body0 = GraphSticks[s]->Bodies[0];
+      Body* body1 = GraphSticks[s]->Bodies[1];
+      for(unsigned int k = 0; k < 2; ++k)
+      {
+        Body* body = GraphSticks[s]->Bodies[k];
+        if(body->InvMass == 0.0f || (k == 1 && body0 == body1))
+          continue;
+        unsigned bodyNode = bodyNodes[body];
+        Adjacency[s].push_back(bodyNode);
+        Adjacency[bodyNode].push_back(s);
+      }
+    }
+
+    Visited.assign(nodeCount, false);
+    for(unsigned int s = 0; s < stickCount; ++s)
+    {
+      if(!Visited[s])
+        AddTree(s);
+    }
+  }
+
+  bool ConstraintSolver::AddTree(unsigned start)
+  {
+    unsigned stickCount = GraphSticks.size();
+
+    //Collect the connected group of sticks and bodies
+    GraphOrder.clear();
+    GraphOrder.push_back(start);
+    Visited[start] = true;
+    for(unsigned int i = 0; i < GraphOrder.size(); ++i)
+    {
+      std::vector<unsigned>& neighbors = Adjacency[GraphOrder[i]];
+      for(unsigned int n = 0; n < neighbors.size(); ++n)
+      {
+        if(!Visited[neighbors[n]])
+        {
+          Visited[neighbors[n]] = true;
+          GraphOrder.push_back(neighbors[n]);
+        }
+      }
+    }
+
+    //Check that the group is a tree that can be rooted
+    unsigned degreeSum = 0;
+    unsigned leafSticks = 0;
+    int root = -1;
+    for(unsigned int i = 0; i < GraphOrder.size(); ++i)
+    {
+      unsigned node = GraphOrder[i];
+      unsigned degree = Adjacency[node].size();
+      degreeSum += degree;
+      if(node < stickCount)
+      {
+        if(degree == 0)
+          return false;
+        if(degree == 1)
+        {
+          ++leafSticks;
+          root = node;
+        }
+      }
+      else if(GraphBodies[node - stickCount]->InvInertia == 0.0f)
+      {
+        //The system needs the inertia itself, not its inverse
+        return false;
+      }
+    }
+
+    //Loops and groups pinned in more than one place are left to the
+    //iterative solver
+    if(degreeSum / 2 != GraphOrder.size() - 1 || leafSticks > 1)
+      return false;
+
+    if(root == -1)
+    {
+      for(unsigned int i = 0; i < GraphOrder.size() && root == -1; ++i)
+      {
+        if(GraphOrder[i] >= stickCount)
+          root = GraphOrder[i];
+      }
+    }
+
+    //Order the nodes outward from the root. GraphParent holds the
+    //position of each node's parent in GraphOrder.
+    GraphOrder.clear();
+    GraphParent.clear();
+    GraphOrder.push_back(root);
+    GraphParent.push_back(-1);
+    for(unsigned int i = 0; i < GraphOrder.size(); ++i)
+    {
+      int parentNode = GraphParent[i] == -1 ? -1 : (int)GraphOrder[GraphParent[i]];
+      std::vector<unsigned>& neighbors = Adjacency[GraphOrder[i]];
+      for(unsigned int n = 0; n < neighbors.size(); ++n)
+      {
+        if((int)neighbors[n] != parentNode)
+        {
+          GraphOrder.push_back(neighbors[n]);
+          GraphParent.push_back(i);
+        }
+      }
+    }
+
+    //Store the nodes children first, so in reverse order
+    unsigned base = TreeNodes.size();
+    unsigned count = GraphOrder.size();
+    for(unsigned int r = 0; r < count; ++r)
+    {
+      unsigned i = count - 1 - r;
+      unsigned node = GraphOrder[i];
+      TreeNode treeNode;
+      treeNode.Parent = GraphParent[i] == -1 ? -1 : int(base + count - 1 - GraphParent[i]);
+      if(node < stickCount)
+      {
+        treeNode.Stick = GraphSticks[node];
+        treeNode.NodeBody = NULL;
+        treeNode.Stick->SolvedDirectly = true;
+      }
+      else
+      {
+        treeNode.Stick = NULL;
+        treeNode.NodeBody = GraphBodies[node - stickCount];
+      }
+      TreeNodes.push_back(treeNode);
+    }
+
+    return true;
+  }
+
+  //Returns false if the matrix is singular (or not finite)
+  static bool Invert3x3(const float* m, float* inverse)
+  {
+    float c00 = m[4] * m[8] - m[5] * m[7];
+    float c01 = m[5] * m[6] - m[3] * m[8];
+    float c02 = m[3] * m[7] - m[4] * m[6];
+    float det = m[0] * c00 + m[1] * c01 + m[2] * c02;
+    if(!(fabs(det) > 0.0f))
+      return false;
+    float invDet = 1.0f / det;
+    inverse[0] = c00 * invDet;
+    inverse[1] = (m[2] * m[7] - m[1] * m[8]) * invDet;
+    inverse[2] = (m[1] * m[5] - m[2] * m[4]) * invDet;
+    inverse[3] = c01 * invDet;
+    inverse[4] = (m[0] * m[8] - m[2] * m[6]) * invDet;
+    inverse[5] = (m[2] * m[3] - m[0] * m[5]) * invDet;
+    inverse[6] = c02 * invDet;
+    inverse[7] = (m[1] * m[6] - m[0] * m[7]) * invDet;
+    inverse[8] = (m[0] * m[4] - m[1] * m[3]) * invDet;
+    return true;
+  }
+
+  void ConstraintSolver::FactorTrees()
+  {
+    //Fill in the blocks of the system
+    for(unsigned int i = 0; i < TreeNodes.size(); ++i)
+    {
+      TreeNode& node = TreeNodes[i];
+      for(unsigned int k = 0; k < 9; ++k)
+        node.D[k] = 0.0f;
+
+      if(node.NodeBody)
+      {
+        node.D[0] = 1.0f / node.NodeBody->InvMass;
+        node.D[4] = 1.0f / node.NodeBody->InvMass;
+        node.D[8] = 1.0f / node.NodeBody->InvInertia;
+      }
+
+      if(node.Parent != -1)
+      {
+        TreeNode& parent = TreeNodes[node.Parent];
+        if(node.NodeBody)
+          GetStickRow(parent.Stick, node.NodeBody, node.J);
+        else
+          GetStickRow(node.Stick, parent.NodeBody, node.J);
+      }
+    }
+
+    //Eliminate the nodes children first, folding each one into its parent.
+    //The nodes of each tree end with its root.
+    unsigned int treeStart = 0;
+    unsigned int kept = 0;
+    bool singular = false;
+    for(unsigned int i = 0; i < TreeNodes.size(); ++i)
+    {
+      if(!singular)
+        singular = !EliminateNode(TreeNodes[i]);
+      if(TreeNodes[i].Parent != -1)
+        continue;
+
+      //A zero pivot means the pose is degenerate and the sticks do not
+      //constrain the bodies independently. The tree is left to the
+      //iterative solver for the rest of the step.
+      if(singular)
+      {
+        for(unsigned int n = treeStart; n <= i; ++n)
+        {
+          if(TreeNodes[n].Stick)
+            TreeNodes[n].Stick->SolvedDirectly = false;
+        }
+      }
+      else
+      {
+        //Move the tree down over the ones that were dropped
+        int shift = int(treeStart - kept);
+        for(unsigned int n = treeStart; n <= i; ++n)
+        {
+          TreeNode& node = TreeNodes[n - shift];
+          node = TreeNodes[n];
+          if(node.Parent != -1)
+            node.Parent -= shift;
+        }
+        kept += i + 1 - treeStart;
+      }
+      treeStart = i + 1;
+      singular = false;
+    }
+    TreeNodes.resize(kept);
+  }
+
+  bool ConstraintSolver::EliminateNode(TreeNode& node)
+  {
+    if(node.NodeBody)
+    {
+      if(!Invert3x3(node.D, node.DInv))
+        return false;
+    }
+    else
+    {
+      if(!(fabs(node.D[0]) > 0.0f))
+        return false;
+      node.DInv[0] = 1.0f / node.D[0];
+    }
+
+    if(node.Parent == -1)
+      return true;
+
+    TreeNode& parent = TreeNodes[node.Parent];
+    float* J = node.J;
+    if(node.NodeBody)
+    {
+      //Body under a stick: J is a column, the stick's block is a scalar
+      float scaled[3];
+      for(unsigned int r = 0; r < 3; ++r)
+        scaled[r] = node.DInv[r * 3 + 0] * J[0] + node.DInv[r * 3 + 1] * J[1] + node.DInv[r * 3 + 2] * J[2];
+      parent.D[0] -= J[0] * scaled[0] + J[1] * scaled[1] + J[2] * scaled[2];
+      for(unsigned int r = 0; r < 3; ++r)
+        J[r] = scaled[r];
+    }
+    else
+    {
+      //Stick under a body: J is a row, the body's block is 3x3
+      for(unsigned int r = 0; r < 3; ++r)
+        for(unsigned int c = 0; c < 3; ++c)
+          parent.D[r * 3 + c] -= J[r] * J[c] * node.DInv[0];
+      for(unsigned int r = 0; r < 3; ++r)
+        J[r] *= node.DInv[0];
+    }
+    return true;
+  }
+
+
+  void ConstraintSolver::SolveTrees()
+  {
+    if(TreeNodes.empty())
+      return;
 
-    for(unsigned int i = 0; i < NumberOfContacts; ++i)
-      contactArray[i].SolveIteration(dt);
+    //The right hand side is zero for bodies and the velocity error for sticks
+    for(unsigned int i = 0; i < TreeNodes.size(); ++i)
+    {
+      TreeNode& node = TreeNodes[i];
+      node.X[0] = node.X[1] = node.X[2] = 0.0f;
+      if(node.Stick)
+      {
+        StickConstraint* stick = node.Stick;
+        ConstraintVelocity velocities;
+        velocities.Set(stick->Bodies[0],stick->Bodies[1]);
+        node.X[0] = stick->CalculateJV(stick->StickJacobian,velocities) + stick->Bias;
+      }
+    }
+
+    //Forward substitution, children into parents
+    for(unsigned int i = 0; i < TreeNodes.size(); ++i)
+    {
+      TreeNode& node = TreeNodes[i];
+      if(node.Parent == -1)
+        continue;
+      TreeNode& parent = TreeNodes[node.Parent];
+      if(node.NodeBody)
+        parent.X[0] -= node.J[0] * node.X[0] + node.J[1] * node.X[1] + node.J[2] * node.X[2];
+      else
+      {
+        for(unsigned int r = 0; r < 3; ++r)
+          parent.X[r] -= node.J[r] * node.X[0];
+      }
+    }
+
+    //Back substitution, parents into children
+    for(int i = int(TreeNodes.size()) - 1; i >= 0; --i)
+    {
+      TreeNode& node = TreeNodes[i];
+      if(node.NodeBody)
+      {
+        float x[3] = { node.X[0], node.X[1], node.X[2] };
+        for(unsigned int r = 0; r < 3; ++r)
+          node.X[r] = node.DInv[r * 3 + 0] * x[0] + node.DInv[r * 3 + 1] * x[1] + node.DInv[r * 3 + 2] * x[2];
+      }
+      else
+        node.X[0] *= node.DInv[0];
+
+      if(node.Parent == -1)
+        continue;
+      TreeNode& parent = TreeNodes[node.Parent];
+      if(node.NodeBody)
+      {
+        for(unsigned int r = 0; r < 3; ++r)
+          node.X[r] -= node.J[r] * parent.X[0];
+      }
+      else
+        node.X[0] -= node.J[0] * parent.X[0] + node.J[1] * parent.X[1] + node.J[2] * parent.X[2];
+    }
+
+    //The stick nodes now hold the impulses that satisfy every stick at once
+    for(unsigned int i = 0; i < TreeNodes.size(); ++i)
+    {
+      TreeNode& node = TreeNodes[i];
+      if(node.Stick)
+      {
+        float lambda = node.X[0];
+        node.Stick->AccumulatedImpulse += lambda;
+        node.Stick->ApplyConstraintImpulse(node.Stick->StickJacobian,lambda);
+      }
+    }
   }
 }
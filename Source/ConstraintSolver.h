@@ -13,12 +13,16 @@
 #include "ContactConstraint.h"
 #include "StickConstraint.h"
 #include "MouseConstraint.h"
+#include "NarrowPhase.h"
 
 namespace Framework
 {
  
   ///An iterative impulse constraint solver based
   //upon Erin Catto's work with box2D.
+  ///Sticks that form a tree (chains, ropes, branching mobiles) are instead
+  ///solved exactly in linear time with Baraff's sparse LDL^T factorization,
+  ///so long chains do not stretch at low iteration counts.
   class ConstraintSolver
   {
   public: 
@@ -27,28 +31,82 @@ namespace Framework
     ~ConstraintSolver();
 
     void Clear();
-    void ClearContacts();
-
-    void AddContact(BodyManifold* contact);
+    ///Use the contacts for the next solve. The contacts are solved in place
+    ///so they must stay alive until Solve returns.
+    void SetContacts(ContactArray& contacts);
     void AddConstraint(Constraint* constraint);
     void RemoveConstraint(Constraint* constraint);
     void RemoveConstraintsWithBody(Body* body);
+    ///Body pairs connected by constraints, used to build islands.
+    void GetConnectedPairs(BodyPairArray& pairs);
 
     void Solve(float dt);
+
+    ///Substepping splits a step into several small steps that each run a
+    ///single iteration. Call BeginSubsteps once per step after setting the
+    ///contacts, then SolveSubstep between integrating the velocities and
+    ///the positions of every substep.
+    void BeginSubsteps();
+    void SolveSubstep(float h);
+    ///Call for every step that is not substepped so the next substepped
+    ///step does not warm start from impulses that are out of date.
+    void SkipSubsteps();
+
+    ///Queue debug lines for the joints.
+    void DebugDraw();
   private:
     void Update(float dt);
     void WarmStart(float dt);
+    void WarmStartSubstep(float scale);
+    void ClearImpulses();
     void SolveIteration(float dt);
 
+    static void GetStickRow(StickConstraint* stick, Body* body, float* row);
+    void BuildTrees();
+    bool AddTree(unsigned start);
+    void FactorTrees();
+    void SolveTrees();
+
+    // A node of a stick tree is either a dynamic body or a stick. The nodes
+    // of each tree are stored children first with the root last.
+    struct TreeNode
+    {
+      Body* NodeBody;
+      StickConstraint* Stick;
+      // Index of the parent node, -1 for the root.
+      int Parent;
+      // Block of the system between this node and its parent. After
+      // factoring it is premultiplied by the inverse of D.
+      float J[3];
+      // Diagonal block. Bodies use a full 3x3 block, sticks only D[0].
+      float D[9];
+      float DInv[9];
+      float X[3];
+    };
+    std::vector<TreeNode> TreeNodes;
+    // Invert a node's block and fold the node into its parent. Returns
+    // false on a zero pivot.
+    bool EliminateNode(TreeNode& node);
+
+    // Scratch graph used to find the trees. Sticks are graph nodes
+    // 0..n-1 and bodies follow them.
+    std::vector<StickConstraint*> GraphSticks;
+    std::vector<Body*> GraphBodies;
+    std::vector< std::vector<unsigned> > Adjacency;
+    std::vector<int> GraphParent;
+    std::vector<unsigned> GraphOrder;
+    std::vector<bool> Visited;
+
     typedef ObjectLinkList<Constraint> ConstraintList;
     typedef ConstraintList::iterator ConstraintIterator;
     ConstraintList Constraints;
     unsigned int IterationCount;
+    //Length of the last substep, zero before the first one and after a
+    //step that was not substepped.
+    float LastSubstep;
 
-    friend class Physics;
-    static const int MaxContacts = 1024;
-    ContactConstraint contactArray[MaxContacts];
-    unsigned NumberOfContacts;
+    //Per contact solver data. Kept between steps to reuse the memory.
+    std::vector<ContactConstraint> ContactConstraints;
   };
 
 }
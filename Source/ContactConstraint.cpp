@@ -30,7 +30,7 @@ namespace Framework
   */
   ContactConstraint::ContactConstraint()
   {
-    
+    ContactPoint = NULL;
   }
 
   ContactConstraint::~ContactConstraint()
@@ -40,23 +40,23 @@ namespace Framework
 
   void ContactConstraint::Set(BodyManifold* contact)
   {
-    ContactPoint = *contact;
+    ContactPoint = contact;
     Constraint::SetBodies(contact->Bodies[0],contact->Bodies[1]);
-    ContactPoint.ContactImpulse = 0;
-    ContactPoint.TangentImpulse = 0;
+    ContactPoint->ContactImpulse = 0;
+    ContactPoint->TangentImpulse = 0;
   }
 
   void ContactConstraint::Update(float dt)
   {
-    Vec2& normal = ContactPoint.Normal;
+    Vec2& normal = ContactPoint->Normal;
     //the jacobian for the normal is ( -n, -r1 x n, n, r2 x n)
-    NormalJacobian.Set(-normal,-Cross2D(ContactPoint.WorldRs[0],normal),
-                        normal, Cross2D(ContactPoint.WorldRs[1],normal));
+    NormalJacobian.Set(-normal,-Cross2D(ContactPoint->WorldRs[0],normal),
+                        normal, Cross2D(ContactPoint->WorldRs[1],normal));
 
     //the jacobian for the tangent is ( -t, -r1 x t, t, r2 x t)
     Vec2 tangent = -TangentVector(normal);
-    TangentJacobian.Set(-tangent,-Cross2D(ContactPoint.WorldRs[0],tangent),
-                         tangent, Cross2D(ContactPoint.WorldRs[1],tangent));
+    TangentJacobian.Set(-tangent,-Cross2D(ContactPoint->WorldRs[0],tangent),
+                         tangent, Cross2D(ContactPoint->WorldRs[1],tangent));
 
     //compute the effective mass for the normal (J * M^-1 * J^T)
     NormalMass = CalculateEffectiveMass(NormalJacobian);
@@ -65,51 +65,61 @@ namespace Framework
     Valid = false;
 
     //we need to add energy to the system to correct penetration.
-    NormalBias = -ContactPoint.Depth;
+    NormalBias = -ContactPoint->Depth;
     //we can also add restitution by adding energy based upon the separating velocity
     ConstraintVelocity velocity;
     velocity.Set(Bodies[0],Bodies[1]);
     float relativeVel = CalculateJV(NormalJacobian,velocity);
     if(relativeVel < -20.0f)
-      NormalBias += ContactPoint.Restitution * relativeVel;
+      NormalBias += ContactPoint->Restitution * relativeVel;
   }
 
   void ContactConstraint::SolveIteration(float dt)
   {
     ConstraintVelocity velocities;
     //get the current velocities
-    velocities.Set(ContactPoint.Bodies[0],ContactPoint.Bodies[1]);
+    velocities.Set(ContactPoint->Bodies[0],ContactPoint->Bodies[1]);
 
     //calculate -(jv + b) / (effectiveMass)
     float jv = CalculateJV(NormalJacobian,velocities);
     float lambda = -(jv + NormalBias) / NormalMass;
 
     //our clamp bounds is [0,+infinity]
-    float oldImpulse = ContactPoint.ContactImpulse;
+    float oldImpulse = ContactPoint->ContactImpulse;
     float newImpulse = Max(oldImpulse + lambda, 0);
     lambda = newImpulse - oldImpulse;
-    ContactPoint.ContactImpulse = newImpulse;
+    ContactPoint->ContactImpulse = newImpulse;
     //apply the clamped impulse
     ApplyConstraintImpulse(NormalJacobian,lambda);
 
 
     //get the newly changed velocities
-    velocities.Set(ContactPoint.Bodies[0],ContactPoint.Bodies[1]);
+    velocities.Set(ContactPoint->Bodies[0],ContactPoint->Bodies[1]);
     //calculate -(jv + b) / (effectiveMass)
     jv = CalculateJV(TangentJacobian,velocities);
     lambda = -(jv) / TangentMass;
-    float maxFriction = ContactPoint.FrictionCof * ContactPoint.ContactImpulse;
+    float maxFriction = ContactPoint->FrictionCof * ContactPoint->ContactImpulse;
 
     //We are setting static friction and dynamic friction to be equal.
     //According to physics, the max force that friction can apply is
     //bound by the normal force.
     //Therefore, we can set our bounds to be [-mu * jNormal,mu * jNormal]
-    oldImpulse = ContactPoint.TangentImpulse;
+    oldImpulse = ContactPoint->TangentImpulse;
     newImpulse = Clamp(oldImpulse + lambda, -maxFriction,maxFriction);
     lambda = newImpulse - oldImpulse;
-    ContactPoint.TangentImpulse = newImpulse;
+    ContactPoint->TangentImpulse = newImpulse;
     //apply the clamped impulse
     ApplyConstraintImpulse(TangentJacobian,lambda);
   }
 
+  void ContactConstraint::WarmStart(float scale)
+  {
+    //The friction bound depends on the normal impulse so the two are
+    //scaled together and the friction stays inside its cone
+    ContactPoint->ContactImpulse *= scale;
+    ContactPoint->TangentImpulse *= scale;
+    ApplyConstraintImpulse(NormalJacobian,ContactPoint->ContactImpulse);
+    ApplyConstraintImpulse(TangentJacobian,ContactPoint->TangentImpulse);
+  }
+
 }
@@ -26,12 +26,12 @@ namespace Framework
 
     virtual void Update(float dt);
     virtual void SolveIteration(float dt);
+    virtual void WarmStart(float scale);
 
   private:
-    friend class Physics;
-
     float NormalMass, TangentMass;
-    BodyManifold ContactPoint;
+    //The contact in the narrow phase's buffer
+    BodyManifold* ContactPoint;
     Jacobian NormalJacobian;
     Jacobian TangentJacobian;
     float NormalBias;
@@ -8,6 +8,7 @@
 
 #include "Precompiled.h"
 #include "Core.h"
+#include <algorithm>
 
 namespace Framework
 {
@@ -19,39 +20,170 @@ namespace Framework
 	{
 		LastTime = 0;
 		GameActive = true;
+		QueueArena = 0;
+		QueueHead = NULL;
+		QueueTail = NULL;
+		QueueOverflowCount = 0;
+		MessageArenas[0].Reserve(MessageArenaSize);
+		MessageArenas[1].Reserve(MessageArenaSize);
 		CORE = this; //Set the global pointer
+		TIMERS = &Timers;
 	}
 
 	CoreEngine::~CoreEngine()
 	{
-		//Nothing for the destructor to do
+		//Messages queued in the last frame are never delivered
+		while (QueueHead != NULL)
+		{
+			QueuedMessage * next = QueueHead->Next;
+			QueueHead->QueuedCopy->~Message();
+			if (QueueHead->Overflow)
+			{
+				delete [] QueueHead->Overflow;
+				delete QueueHead;
+			}
+			QueueHead = next;
+		}
 	}
 
 	void CoreEngine::Initialize()
 	{
+		//One thread per core, the main thread included
+		Jobs.Initialize(GetHardwareThreadCount());
+
 		for (unsigned i = 0; i < Systems.size(); ++i)
 			Systems[i]->Initialize();
 
+		BuildSchedule();
+		PrintSchedule();
+
     //Initialize the last time variable so our first frame
     //is "zero" seconds (and not some huge unknown number)
-    LastTime = timeGetTime();
+    LastTime = GetTimeNs();
 	}
 
   void CoreEngine::Frame()
   {
-    //Get the current time in milliseconds
-    unsigned currenttime = timeGetTime();
-    //Convert it to the time passed since the last frame (in seconds)
-    float dt = (currenttime - LastTime) / 1000.0f;
+    //Advance by the time passed since the last frame (in seconds)
+    Frame(NsToSeconds(GetTimeNs() - LastTime));
+  }
+
+  void CoreEngine::Frame(float dt)
+  {
+    //Get the current time in nanoseconds
+    TimeNs currenttime = GetTimeNs();
+    FrameTimes.AddSample(currenttime - LastTime);
     //Update the when the last update started
     LastTime = currenttime;
 
     //Update every system and tell each one how much
-    //time has passed since the last update
+    //time has passed since the last update. Systems in the same
+    //wave are updated at the same time.
+    for (unsigned w = 0; w < Schedule.size(); ++w)
+    {
+      std::vector<unsigned>& wave = Schedule[w];
+      if (wave.size() == 1)
+      {
+        Systems[wave[0]]->Update(dt);
+        continue;
+      }
+
+      JobCounter counter;
+      for (unsigned i = 0; i < wave.size(); ++i)
+      {
+        ISystem * system = Systems[wave[i]];
+        if (system->RunsOnMainThread())
+          continue;
+        SystemJobs[wave[i]].System = system;
+        SystemJobs[wave[i]].Dt = dt;
+        Jobs.Submit(UpdateSystemJob, &SystemJobs[wave[i]], &counter);
+      }
+
+      for (unsigned i = 0; i < wave.size(); ++i)
+      {
+        if (Systems[wave[i]]->RunsOnMainThread())
+          Systems[wave[i]]->Update(dt);
+      }
+
+      Jobs.Wait(&counter);
+    }
+
+    //Fire the timers that came due during this frame
+    Timers.Advance(dt);
+
+    DispatchQueuedMessages();
+
     for (unsigned i = 0; i < Systems.size(); ++i)
-      Systems[i]->Update(dt);
+      Systems[i]->EndFrame();
+
+    UpdateTimes.AddSample(GetTimeNs() - currenttime);
+
+    //Hold the frame rate if a limit is set
+    Pacer.WaitForFrameEnd(currenttime);
   }
 
+  void CoreEngine::PrintFrameTimes()
+  {
+    FrameTimes.Print("Frame time");
+    UpdateTimes.Print("Update time");
+  }
+
+  void CoreEngine::UpdateSystemJob(void* data)
+  {
+    SystemJob * job = (SystemJob*)data;
+    job->System->Update(job->Dt);
+  }
+
+	//Two systems conflict if either writes something the other uses.
+	//A broadcast runs the subscribers' SendMessage right away, so a system
+	//that broadcasts during Update conflicts with all the others. Queued
+	//messages go through the locked arena and are sent after every system
+	//updates, so queuing them is not a conflict and has no flag.
+	static bool SystemsConflict(ISystem* a, ISystem* b)
+	{
+		unsigned usesA = a->GetReads() | a->GetWrites() | SystemData::Messages;
+		unsigned usesB = b->GetReads() | b->GetWrites() | SystemData::Messages;
+		return (a->GetWrites() & usesB) != 0 || (b->GetWrites() & usesA) != 0;
+	}
+
+	void CoreEngine::BuildSchedule()
+	{
+		//A system goes in the wave after the last earlier system it
+		//conflicts with. This is the longest path through the graph of
+		//conflicts, so the number of waves is the critical path.
+		std::vector<unsigned> waveOf(Systems.size(), 0);
+		Schedule.clear();
+		for (unsigned i = 0; i < Systems.size(); ++i)
+		{
+			for (unsigned j = 0; j < i; ++j)
+			{
+				if (SystemsConflict(Systems[j], Systems[i]) && waveOf[j] + 1 > waveOf[i])
+					waveOf[i] = waveOf[j] + 1;
+			}
+			if (waveOf[i] >= Schedule.size())
+				Schedule.resize(waveOf[i] + 1);
+			Schedule[waveOf[i]].push_back(i);
+		}
+		SystemJobs.resize(Systems.size());
+	}
+
+	void CoreEngine::PrintSchedule()
+	{
+		LogPrint("System schedule: %u systems in %u waves", Systems.size(), Schedule.size());
+		for (unsigned w = 0; w < Schedule.size(); ++w)
+		{
+			std::string names;
+			for (unsigned i = 0; i < Schedule[w].size(); ++i)
+			{
+				ISystem * system = Systems[Schedule[w][i]];
+				if (i > 0) names += ", ";
+				names += system->GetName();
+				if (system->RunsOnMainThread()) names += " (main)";
+			}
+			LogPrint("  Wave %u: %s", w, names.c_str());
+		}
+	}
+
 	void CoreEngine::GameLoop()
 	{
 	
@@ -68,11 +200,88 @@ namespace Framework
 		if (message->MessageId == Mid::Quit)
 			GameActive = false;
 
-		//Send the message to every system--each
-		//system can figure out whether it cares
-		//about a given message or not
-		for (unsigned i = 0; i < Systems.size(); ++i)
-			Systems[i]->SendMessage(message);
+		//Send the message to the systems that care about it
+		std::vector<ISystem*>& subscribers = Subscribers[message->MessageId];
+		for (unsigned i = 0; i < subscribers.size(); ++i)
+			subscribers[i]->SendMessage(message);
+	}
+
+	void CoreEngine::Subscribe(Mid::MessageIdType id, ISystem* system)
+	{
+		std::vector<ISystem*>& subscribers = Subscribers[id];
+		if (std::find(subscribers.begin(), subscribers.end(), system) == subscribers.end())
+			subscribers.push_back(system);
+	}
+
+	void CoreEngine::Unsubscribe(Mid::MessageIdType id, ISystem* system)
+	{
+		std::vector<ISystem*>& subscribers = Subscribers[id];
+		subscribers.erase(std::remove(subscribers.begin(), subscribers.end(), system), subscribers.end());
+	}
+
+	void* CoreEngine::AllocateQueued(unsigned size, QueuedMessage*& entry)
+	{
+		ScratchArena& arena = MessageArenas[QueueArena];
+		unsigned mark = arena.GetMark();
+		entry = (QueuedMessage*)arena.Allocate(sizeof(QueuedMessage));
+		void * memory = entry ? arena.Allocate(size) : NULL;
+		char * overflow = NULL;
+		if (memory == NULL)
+		{
+			//Dropping a message could lose a Quit, so a full arena spills
+			//to the heap. Dispatch frees these entries.
+			arena.FreeToMark(mark);
+			entry = new QueuedMessage();
+			overflow = new char[size];
+			memory = overflow;
+			++QueueOverflowCount;
+		}
+
+		entry->QueuedCopy = NULL;
+		entry->Next = NULL;
+		entry->Overflow = overflow;
+		if (QueueTail)
+			QueueTail->Next = entry;
+		else
+			QueueHead = entry;
+		QueueTail = entry;
+		return memory;
+	}
+
+	void CoreEngine::DispatchQueuedMessages()
+	{
+		//Take this frame's queue and start a new one in the other arena
+		QueuedMessage * entry;
+		unsigned arena;
+		unsigned overflowCount;
+		{
+			ScopedLock lock(QueueLock);
+			entry = QueueHead;
+			arena = QueueArena;
+			overflowCount = QueueOverflowCount;
+			QueueHead = NULL;
+			QueueTail = NULL;
+			QueueArena = 1 - QueueArena;
+			QueueOverflowCount = 0;
+		}
+
+		if (overflowCount > 0)
+			LogPrint("Message queue arena is full, %u messages were queued on the heap.", overflowCount);
+
+		while (entry != NULL)
+		{
+			QueuedMessage * next = entry->Next;
+			BroadcastMessage(entry->QueuedCopy);
+			entry->QueuedCopy->~Message();
+			if (entry->Overflow)
+			{
+				delete [] entry->Overflow;
+				delete entry;
+			}
+			entry = next;
+		}
+
+		MessageArenas[arena].FreeToMark(0);
 	}
 
 	void CoreEngine::AddSystem(ISystem* system)
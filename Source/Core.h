@@ -9,6 +9,9 @@
 #pragma once //Makes sure this header is only included once
 
 #include "System.h"
+#include "JobSystem.h"
+#include "FrameTiming.h"
+#include "TimerWheel.h"
 
 namespace Framework
 {
@@ -23,20 +26,94 @@ namespace Framework
 		void GameLoop();
 		///Destroy all systems in reverse order that they were added.
 		void DestroySystems();
-		///Broadcasts a message to all systems.
+		///Send a message right away to every system subscribed to its id.
 		void BroadcastMessage(Message* m);
+		///Copy a message into this frame's queue. Queued messages are
+		///broadcast together at the end of the frame. Safe to call from
+		///systems updating on worker threads. The copy goes in an arena
+		///and only goes to the heap when the arena is full, but copying
+		///a message can still allocate (the file name of a FileDrop).
+		///Queued messages are never dropped.
+		template<typename MessageType>
+		void QueueMessage(const MessageType& message);
+		///Deliver messages with this id to the system. Systems only receive
+		///the messages they subscribe to, usually from Initialize.
+		void Subscribe(Mid::MessageIdType id, ISystem* system);
+		void Unsubscribe(Mid::MessageIdType id, ISystem* system);
 		///Adds a new system to the game.
 		void AddSystem(ISystem* system);
 		///Initializes all systems in the game.
 		void Initialize();
     /// Run a frame
     void Frame();
+		///Run a frame that advances the game by dt no matter how long it
+		///took. Headless runs use this so the simulation does not depend
+		///on how fast the frames run.
+		void Frame(float dt);
+		///Jobs shared by all the systems. Started before the systems are
+		///initialized so they can use it from Initialize. Also available
+		///through the global JOBS pointer.
+		JobSystem Jobs;
+		///Timers on game time, advanced by each frame's time step after
+		///the systems update. Also available through the global TIMERS pointer.
+		TimerWheel Timers;
+		///Optional frame rate limit, off by default.
+		FramePacer Pacer;
+		///Print the recent frame times and update times.
+		void PrintFrameTimes();
+		///GetTimeNs when the current frame started. Input read after it
+		///is left for the next frame.
+		TimeNs GetFrameStartTime(){return LastTime;}
 
   private:
+		///Group the systems into waves. Systems in a wave use no data that
+		///another system in the wave writes, so they are updated together.
+		///Waves keep the add order of systems that conflict.
+		void BuildSchedule();
+		void PrintSchedule();
+		static void UpdateSystemJob(void* data);
+		void DispatchQueuedMessages();
+
+		//Systems subscribed to each message id
+		std::vector<ISystem*> Subscribers[Mid::MessageIdCount];
+
+		//Queued messages are stored in a linked list in the frame's arena.
+		//Messages queued while the last frame's are dispatched go in the
+		//other arena for the next frame. Entries that did not fit in the
+		//arena are allocated from the heap and keep their place in the list.
+		struct QueuedMessage
+		{
+			Message * QueuedCopy;
+			QueuedMessage * Next;
+			//The copy's memory when the entry is on the heap, otherwise NULL
+			char * Overflow;
+		};
+		void* AllocateQueued(unsigned size, QueuedMessage*& entry);
+		enum { MessageArenaSize = 64 * 1024 };
+		ScratchArena MessageArenas[2];
+		unsigned QueueArena;
+		QueuedMessage * QueueHead;
+		QueuedMessage * QueueTail;
+		//Entries of the queue that are on the heap
+		unsigned QueueOverflowCount;
+		Mutex QueueLock;
+
 		//Tracks all the systems the game uses
 		std::vector<ISystem*> Systems;
+		//Indices of the systems updated in each wave
+		std::vector< std::vector<unsigned> > Schedule;
+		struct SystemJob
+		{
+			ISystem * System;
+			float Dt;
+		};
+		std::vector<SystemJob> SystemJobs;
 		//The last time the game was updated
-		unsigned LastTime;
+		TimeNs LastTime;
+		//Time between frame starts, including any pacing
+		FrameTimeHistogram FrameTimes;
+		//Time spent updating the systems
+		FrameTimeHistogram UpdateTimes;
 		//Is the game running (true) or being shut down (false)?
 		bool GameActive;
 	};
@@ -59,4 +136,13 @@ namespace Framework
 
 	//A global pointer to the instance of the core
 	extern CoreEngine* CORE;
+
+	template<typename MessageType>
+	void CoreEngine::QueueMessage(const MessageType& message)
+	{
+		ScopedLock lock(QueueLock);
+		QueuedMessage * entry = NULL;
+		void * memory = AllocateQueued(sizeof(MessageType), entry);
+		entry->QueuedCopy = new (memory) MessageType(message);
+	}
 }
\ No newline at end of file
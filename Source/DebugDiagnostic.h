@@ -9,11 +9,11 @@
 ///////////////////////////////////////////////////////////////////////////////////////
 #pragma once
 
-//Define the debug break using the MS specific or general using assembly interrupt 3
+//Define the debug break using the MS specific or the GCC/Clang builtin trap
 #ifdef _MSC_VER
 #define G_DEBUG_BREAK __debugbreak()
 #else
-#define G_DEBUG_BREAK do { __asm int 3 } while(0)
+#define G_DEBUG_BREAK __builtin_trap()
 #endif
 
 //By defining G_ENABLE_DEBUG_DIAGNOSTICS you can explicitly 
@@ -31,6 +31,10 @@
 bool SignalErrorHandler(const char * expression, const char * file,int line, const char * formatMessage = 0, ...);
 void DebugPrintHandler(const char * msg , ... );
 
+//Output that was asked for, like benchmark results and timing reports,
+//goes through the same handler but is kept in every build
+#define LogPrint(...) DebugPrintHandler( __VA_ARGS__ )
+
 #if G_ENABLE_DEBUG_DIAGNOSTICS
 
 //If diagnostics are enabled use the debug functions
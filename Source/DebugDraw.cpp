@@ -58,7 +58,7 @@ namespace Framework
 	void  Drawer::DrawCircle(Vec2 center, float radius)
 	{
 		const unsigned numberOfSegments = 16;
-		const float increment = 2.0f * (D3DX_PI) / float(numberOfSegments);
+		const float increment = 2.0f * Pi / float(numberOfSegments);
 
 		float theta = 0.0f;
 		MoveTo( center + radius * Vec2(cosf(theta), sinf(theta)) );
@@ -32,9 +32,8 @@ namespace Framework
 		///Draw a line between two points.
 		void DrawSegment(Vec2 start, Vec2 end);
 		static Drawer Instance;
-	private:
-		friend class Graphics;
-		void Flush();
+
+		///Lines drawn in the same color, drawn with one call.
 		struct LineSet
 		{
 			Vec4 Color;
@@ -46,6 +45,9 @@ namespace Framework
 			Vec3 A;
 			Vec3 B;
 		};
+	private:
+		friend class Graphics;
+		void Flush();
 
 		Vec2 WritePosition;
 		Vec4 Color;
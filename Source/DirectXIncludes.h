@@ -2,11 +2,13 @@
 ///
 ///	\file DirectXIncludes.h
 ///	Header file that includes directX and defines D3D_DEBUG_INFO in debug.
+///	Only included by the files that render, never by headless builds.
 ///
 ///	Authors: Chris Peters
 ///	Copyright 2010, Digipen Institute of Technology
 ///
 ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
 
 #if defined(_DEBUG)
 #include <DxErr.h>
@@ -27,4 +29,15 @@
 
 #include <d3d9.h>
 #include <d3dx9.h>
-#include <Xinput.h>
\ No newline at end of file
+#include <Xinput.h>
+#include "VMath.h"
+
+//The engine math types have the same layout as the D3DX types
+//so they can be handed to D3DX directly
+typedef D3DXVECTOR2 DxVec2;
+typedef D3DXVECTOR3 DxVec3;
+
+inline D3DXMATRIX* DxMat(Framework::Mat4& m) { return reinterpret_cast<D3DXMATRIX*>(&m); }
+inline const D3DXMATRIX* DxMat(const Framework::Mat4& m) { return reinterpret_cast<const D3DXMATRIX*>(&m); }
+inline const D3DXVECTOR4* DxVec(const Framework::Vec4& v) { return reinterpret_cast<const D3DXVECTOR4*>(&v); }
+inline D3DXVECTOR4* DxVec(Framework::Vec4& v) { return reinterpret_cast<D3DXVECTOR4*>(&v); }
@@ -58,8 +58,12 @@ namespace Framework
 
 			while(stream.IsGood())
 			{
-				//Read the component's name
+				//Read the component's name. Trailing whitespace leaves
+				//nothing to read so stop instead of looking up an empty name
+				componentName.clear();
 				StreamRead(stream,componentName);
+				if( componentName.empty() )
+					break;
 
 				//Find the component's creator
 				ComponentMapType::iterator it =  ComponentMap.find( componentName );
@@ -135,6 +139,12 @@ namespace Framework
 	}
 
 	void GameObjectFactory::Update(float dt)
+	{
+		//Objects are deleted by EndFrame instead, when no other
+		//system can be using them
+	}
+
+	void GameObjectFactory::EndFrame()
 	{
 		//Delete all objects in the ObjectsToBeDeleted list 
 
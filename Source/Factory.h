@@ -33,12 +33,20 @@ namespace Framework
 		///Add a GOC to the destroy list for delayed destruction.
 		void Destroy(GOC * gameObject);
 
-		///Update the factory, destroying dead objects.
+		///Update the factory. Does nothing, see EndFrame.
 		virtual void Update(float dt);
 
+		///Destroy dead objects. Their components are removed from every
+		///system, so this waits for the end of the frame.
+		virtual void EndFrame();
+
 		///Name of the system is factory.
 		virtual std::string GetName(){return "Factory";}
 
+		///Update uses nothing so the factory never holds up other systems.
+		virtual unsigned GetReads(){return 0;}
+		virtual unsigned GetWrites(){return 0;}
+
 		///Message Interface see Message.h
 		virtual void SendMessage(Message * message);
 
@@ -0,0 +1,160 @@
+///////////////////////////////////////////////////////////////////////////////////////
+//
+//	FrameTiming.cpp
+//
+//	Authors: Chris Peters
+//	Copyright 2011, Digipen Institute of Technology
+//
+///////////////////////////////////////////////////////////////////////////////////////
+#include "Precompiled.h"
+#include "FrameTiming.h"
+#include "Threading.h"
+#include <algorithm>
+#ifndef _WIN32
+#include <time.h>
+#endif
+
+namespace Framework
+{
+	TimeNs GetTimeNs()
+	{
+#ifdef _WIN32
+		static LARGE_INTEGER frequency = {0};
+		if( frequency.QuadPart == 0 )
+			QueryPerformanceFrequency(&frequency);
+
+		LARGE_INTEGER counter;
+		QueryPerformanceCounter(&counter);
+
+		//Split into whole seconds and the remainder so the
+		//multiply does not overflow
+		TimeNs ticks = counter.QuadPart;
+		TimeNs ticksPerSecond = frequency.QuadPart;
+		TimeNs seconds = ticks / ticksPerSecond;
+		TimeNs remainder = ticks % ticksPerSecond;
+		return seconds * 1000000000ULL + remainder * 1000000000ULL / ticksPerSecond;
+#else
+		timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		return TimeNs(now.tv_sec) * 1000000000ULL + TimeNs(now.tv_nsec);
+#endif
+	}
+
+	//Sleep the thread for at least the time given
+	static void SleepNs(TimeNs time)
+	{
+#ifdef _WIN32
+		Sleep( DWORD( time / 1000000ULL ) );
+#else
+		timespec wait;
+		wait.tv_sec = time_t(time / 1000000000ULL);
+		wait.tv_nsec = long(time % 1000000000ULL);
+		nanosleep(&wait, NULL);
+#endif
+	}
+
+	FramePacer::FramePacer()
+	{
+		SpinThreshold = 2000000ULL;
+		TargetFrameTime = 0;
+		TimerPeriodSet = false;
+	}
+
+	FramePacer::~FramePacer()
+	{
+#ifdef _WIN32
+		if( TimerPeriodSet )
+			timeEndPeriod(1);
+#endif
+	}
+
+	void FramePacer::SetTargetRate(float framesPerSecond)
+	{
+		TargetFrameTime = framesPerSecond > 0.0f ? TimeNs(1e9 / framesPerSecond) : 0;
+
+		//Sleep is only as fine as the system timer period
+#ifdef _WIN32
+		if( IsActive() && !TimerPeriodSet )
+		{
+			timeBeginPeriod(1);
+			TimerPeriodSet = true;
+		}
+#endif
+	}
+
+	void FramePacer::WaitForFrameEnd(TimeNs frameStart)
+	{
+		if( !IsActive() )
+			return;
+
+		TimeNs target = frameStart + TargetFrameTime;
+		for(;;)
+		{
+			TimeNs now = GetTimeNs();
+			if( now >= target )
+				break;
+			TimeNs remaining = target - now;
+			if( remaining > SpinThreshold )
+				SleepNs(remaining - SpinThreshold);
+			else
+				YieldThread();
+		}
+	}
+
+	FrameTimeHistogram::FrameTimeHistogram()
+	{
+		Next = 0;
+		Count = 0;
+	}
+
+	void FrameTimeHistogram::AddSample(TimeNs time)
+	{
+		Samples[Next] = time;
+		Next = (Next + 1) % SampleCount;
+		if( Count < SampleCount )
+			++Count;
+	}
+
+	TimeNs FrameTimeHistogram::GetPercentile(float fraction)
+	{
+		if( Count == 0 )
+			return 0;
+		Sorted.assign(Samples, Samples + Count);
+		unsigned index = unsigned(fraction * (Count - 1) + 0.5f);
+		std::nth_element(Sorted.begin(), Sorted.begin() + index, Sorted.end());
+		return Sorted[index];
+	}
+
+	TimeNs FrameTimeHistogram::GetMax()
+	{
+		TimeNs maxTime = 0;
+		for(unsigned i=0;i<Count;++i)
+			maxTime = std::max(maxTime, Samples[i]);
+		return maxTime;
+	}
+
+	void FrameTimeHistogram::Print(const char * name)
+	{
+		LogPrint("%s (%u frames): p50 %.3f ms p95 %.3f ms p99 %.3f ms max %.3f ms", name, Count,
+			NsToMilliseconds(GetPercentile(0.5f)), NsToMilliseconds(GetPercentile(0.95f)),
+			NsToMilliseconds(GetPercentile(0.99f)), NsToMilliseconds(GetMax()));
+
+		//Buckets 2ms wide, the last one holds everything slower
+		const unsigned BucketCount = 16;
+		unsigned buckets[BucketCount] = {0};
+		for(unsigned i=0;i<Count;++i)
+		{
+			unsigned bucket = unsigned(Samples[i] / 2000000ULL);
+			++buckets[std::min(bucket, BucketCount - 1)];
+		}
+		for(unsigned b=0;b<BucketCount;++b)
+		{
+			if( buckets[b] == 0 )
+				continue;
+			if( b + 1 < BucketCount )
+				LogPrint("  %2u-%2u ms: %u", b * 2, b * 2 + 2, buckets[b]);
+			else
+				LogPrint("  %2u+ ms: %u", b * 2, buckets[b]);
+		}
+	}
+}
@@ -0,0 +1,62 @@
+///////////////////////////////////////////////////////////////////////////////////////
+///
+///	\file FrameTiming.h
+///	High resolution clock, frame pacing and frame time statistics.
+///
+///	Authors: Chris Peters
+///	Copyright 2011, Digipen Institute of Technology
+///
+///////////////////////////////////////////////////////////////////////////////////////
+#pragma once //Makes sure this header is only included once
+
+namespace Framework
+{
+	///Time in nanoseconds.
+	typedef unsigned long long TimeNs;
+
+	///Monotonic time in nanoseconds since an arbitrary start.
+	TimeNs GetTimeNs();
+	inline float NsToSeconds(TimeNs time){return float(double(time) * 1e-9);}
+	inline float NsToMilliseconds(TimeNs time){return float(double(time) * 1e-6);}
+
+	///Holds frames to a fixed rate. Most of the wait is spent asleep, which
+	///is only accurate to about a millisecond, and the rest spinning.
+	class FramePacer
+	{
+	public:
+		FramePacer();
+		~FramePacer();
+		///Limit to the rate, or zero to run as fast as possible.
+		void SetTargetRate(float framesPerSecond);
+		bool IsActive(){return TargetFrameTime > 0;}
+		///Wait until one frame time has passed since the frame started.
+		void WaitForFrameEnd(TimeNs frameStart);
+		///Time left before the target at which sleeping stops and spinning
+		///starts. Larger values are more accurate and burn more CPU.
+		TimeNs SpinThreshold;
+	private:
+		TimeNs TargetFrameTime;
+		bool TimerPeriodSet;
+	};
+
+	///Keeps the last SampleCount frame times and reports their percentiles.
+	class FrameTimeHistogram
+	{
+	public:
+		FrameTimeHistogram();
+		enum { SampleCount = 1024 };
+		void AddSample(TimeNs time);
+		unsigned GetCount(){return Count;}
+		///Value below which the given fraction of the samples fall.
+		TimeNs GetPercentile(float fraction);
+		TimeNs GetMax();
+		///Print the percentiles and a histogram in 2ms buckets. Printed
+		///with LogPrint so release builds report it too.
+		void Print(const char * name);
+	private:
+		TimeNs Samples[SampleCount];
+		unsigned Next;
+		unsigned Count;
+		std::vector<TimeNs> Sorted;
+	};
+}
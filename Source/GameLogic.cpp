@@ -12,11 +12,12 @@
 
 #include "Precompiled.h"
 #include "GameLogic.h"
-#include "WindowsSystem.h"
+#include "Input.h"
 #include "Core.h"
 #include "ComponentCreator.h"
 #include "Camera.h"
 #include "TextSerialization.h"
+#include "SolverBenchmark.h"
 #include <ctime>
 
 namespace Framework
@@ -31,13 +32,18 @@ namespace Framework
 		//This macro expands into FACTORY->AddComponentCreator( "Transform" , new ComponentCreatorType<Transform>()  );
 
 		RegisterComponent(Controller);
+
+		//Input messages from the windows system. The mouse is read
+		//from the frame's input state in Update instead.
+		CORE->Subscribe(Mid::CharacterKey, this);
+		CORE->Subscribe(Mid::FileDrop, this);
 		RegisterComponent(Bomb);
 
 		const bool UseLevelFile = true;
 
 		if( UseLevelFile )
 		{
-			LoadLevelFile("Objects\\TestLevel.txt");
+			LoadLevelFile(LevelFile);
 		}
 		else
 		{
@@ -73,7 +79,7 @@ namespace Framework
 				Transform * transform = new Transform();
 				transform->Position = Vec2(0,-300);;
 				gameObject->AddComponent(CT_Transform , transform );
-				Body * body = new Body();
+				Body * body = new Body(PHYSICS);
 				body->Density = 0.0f;
 				body->Restitution = 0.3f;
 				body->Friction = 0.3f;
@@ -108,7 +114,7 @@ namespace Framework
         Transform * transform = new Transform();
         transform->Position = Vec2(0,200);
         gameObject->AddComponent(CT_Transform , transform );
-        Body * body = new Body();
+        Body * body = new Body(PHYSICS);
         body->Density = 0.0f;
         body->Restitution = 0.3f;
         body->Friction = 0.3f;
@@ -133,7 +139,7 @@ namespace Framework
         Transform * transform = new Transform();
         transform->Position = Vec2(-100,0);
         gameObject->AddComponent(CT_Transform , transform );
-        Body * body = new Body();
+        Body * body = new Body(PHYSICS);
         body->Density = 1.0f;
         body->Restitution = 0.3f;
         body->Friction = 0.3f;
@@ -158,7 +164,7 @@ namespace Framework
         Transform * transform = new Transform();
         transform->Position = Vec2(-150,-70);
         gameObject->AddComponent(CT_Transform , transform );
-        Body * body = new Body();
+        Body * body = new Body(PHYSICS);
         body->Density = 1.0f;
         body->Restitution = 0.3f;
         body->Friction = 0.3f;
@@ -197,6 +203,7 @@ namespace Framework
 		//Safe Id reference of the object the user has grabbed
 		GrabbedObjectId = 0;
     GrabConstraint = NULL;
+		LevelFile = "Objects\\TestLevel.txt";
 
 		//Set up the global pointer
 		ErrorIf(LOGIC!=NULL,"Logic already initialized");
@@ -206,11 +213,19 @@ namespace Framework
 
 	GameLogic::~GameLogic()
 	{
-    if(GrabConstraint != NULL)
-    {
-      PHYSICS->RemoveConstraint(GrabConstraint);
-      delete GrabConstraint;
-    }
+		ReleaseGrab();
+	}
+
+	void GameLogic::ReleaseGrab()
+	{
+		//If the object is gone its body already deleted the constraint
+		if(GrabConstraint != NULL && FACTORY->GetObjectWithId(GrabbedObjectId))
+		{
+			PHYSICS->RemoveConstraint(GrabConstraint);
+			delete GrabConstraint;
+		}
+		GrabConstraint = NULL;
+		GrabbedObjectId = 0;
 	}
 
 	void GameLogic::SendMessage(Message * m )
@@ -224,6 +239,9 @@ namespace Framework
 					// Cast to the derived message type
 					MessageCharacterKey * key = (MessageCharacterKey*)m;
 
+					//Objects are created where the mouse is right now
+					WorldMousePosition = GRAPHICS->ScreenToWorldSpace(GetInput().MousePosition);
+
 					//When different keys are pressed create different objects
 					std::string ObjectToCreate;
 
@@ -233,27 +251,68 @@ namespace Framework
 						ObjectToCreate = "Objects\\Box.txt";
 					else if( key->character == '3' )
 						ObjectToCreate = "Objects\\Bomb.txt";
+					else if( key->character == '4' )
+						ObjectToCreate = "Objects\\Platform.txt";
+					else if( key->character == '6' )
+						ObjectToCreate = "Objects\\Terrain.txt";
+					else if( key->character == '7' )
+						ObjectToCreate = "Objects\\Dumbbell.txt";
 
 					if( !ObjectToCreate.empty() )
 						CreateObjectAt(WorldMousePosition,0,ObjectToCreate);
 
+					//Pour a block of granular particles
+					if( key->character == '5' )
+					{
+						GranularSolver& granular = PHYSICS->Granular;
+						float spacing = granular.Radius * 2.0f;
+						for(int y=0;y<25;++y)
+							for(int x=-20;x<20;++x)
+								granular.AddParticle(WorldMousePosition + Vec2(x * spacing, y * spacing), Vec2(0,0));
+					}
+
 					//Enable Physics Debugging
 					if( key->character == ' ' )
 						PHYSICS->AdvanceStep = true;
 					if( key->character == ' ' && IsShiftHeld() )
 						PHYSICS->StepModeActive = !PHYSICS->StepModeActive;
 
-					if( key->character == 'd' )
+					//Cycle through the impulse, constraint and substepped solvers
+					if( key->character == 'c' )
 					{
-						ToggleDebugDisplay debugMessage( true );
-						CORE->BroadcastMessage( &debugMessage );
+						if( PHYSICS->ContactSolver == Physics::SolverImpulses )
+							PHYSICS->ContactSolver = Physics::SolverConstraints;
+						else if( PHYSICS->ContactSolver == Physics::SolverConstraints )
+							PHYSICS->ContactSolver = Physics::SolverSubstepped;
+						else
+							PHYSICS->ContactSolver = Physics::SolverImpulses;
 					}
 
-					if( key->character == 'f' )
+					//Compare the iterative and substepped solvers
+					if( key->character == 'b' )
 					{
-						ToggleDebugDisplay debugMessage( false );
-						CORE->BroadcastMessage( &debugMessage );
+						SolverBenchmark benchmark;
+						benchmark.RunComparison();
 					}
+
+					//Print the recent frame time percentiles
+					if( key->character == 't' )
+						CORE->PrintFrameTimes();
+
+					//Toggle a 60Hz frame limit
+					if( key->character == 'p' )
+						CORE->Pacer.SetTargetRate( CORE->Pacer.IsActive() ? 0.0f : 60.0f );
+
+					//Step bodies far from the camera at reduced rates
+					if( key->character == 'l' )
+						PHYSICS->LodEnabled = !PHYSICS->LodEnabled;
+
+					//Debug drawing changes at the end of the frame
+					if( key->character == 'd' )
+						CORE->QueueMessage( ToggleDebugDisplay( true ) );
+
+					if( key->character == 'f' )
+						CORE->QueueMessage( ToggleDebugDisplay( false ) );
 					break;
 				}
 			case Mid::FileDrop:
@@ -262,66 +321,56 @@ namespace Framework
 					LoadLevelFile(drop->FileName);
 					break;
 				}
-			case Mid::MouseMove:
-				{
-					//The mouse has moved, update the mouse's world position
-					MouseMove * mouseMove = (MouseMove*)m;
-					WorldMousePosition = GRAPHICS->ScreenToWorldSpace(mouseMove->MousePosition);
-					break;
-				}
-			case Mid::MouseButton:
+		}
+
+	};
+
+	void GameLogic::HandleMouse(const InputState& input)
+	{
+		//Converted once a frame however many times the mouse moved
+		WorldMousePosition = GRAPHICS->ScreenToWorldSpace(input.MousePosition);
+
+		//A release is handled first if the button went down again in the same frame
+		if( input.WasReleased(MouseButton::LeftMouse) && input.IsHeld(MouseButton::LeftMouse) )
+			ReleaseGrab();
+
+		if( input.WasPressed(MouseButton::LeftMouse) )
+		{
+			//On left click attempt to grab a object at the mouse cursor
+			ReleaseGrab();
+			if( GOC * goc = PHYSICS->TestPoint( WorldMousePosition ) )
+			{
+				GrabbedObjectId = goc->GetId();
+				Body* gocBody = goc->has(Body);
+				//Static and kinematic bodies can not be pulled by a constraint
+				if(gocBody && gocBody->IsDynamic())
 				{
-					MouseButton * mouse = (MouseButton*)m;
-					//Update the world mouse position
-					WorldMousePosition = GRAPHICS->ScreenToWorldSpace(mouse->MousePosition);
-					
-					if(mouse->ButtonIsPressed)
-					{
-						if( mouse->MouseButtonIndex == MouseButton::LeftMouse )
-						{
-							//On left click attempt to grab a object at the mouse cursor
-							if( GOC * goc = PHYSICS->TestPoint( WorldMousePosition ) )
-              {
-								GrabbedObjectId = goc->GetId();
-                Body* gocBody = goc->has(Body);
-                if(gocBody)
-                {
-                  GrabConstraint = new MouseConstraint();
-                  PHYSICS->AddConstraint(GrabConstraint);
-                  GrabConstraint->SetBody(goc->has(Body));
-                  GrabConstraint->SetWorldPoint(WorldMousePosition);
-                  GrabConstraint->SetTarget(WorldMousePosition);
-                }
-                
-              }
-						}
-						else if( mouse->MouseButtonIndex == MouseButton::RightMouse )
-						{
-							//On right click destroy the object at the mouse cursor
-							GOC * goc = PHYSICS->TestPoint( WorldMousePosition );
-							if( goc ) 
-								goc->Destroy();
-						}
-					}
-					else
-					{
-						//If the mouse has been release let go of the grabbed object
-						GrabbedObjectId = 0;
-            if(GrabConstraint != NULL)
-            {
-              PHYSICS->RemoveConstraint(GrabConstraint);
-              delete GrabConstraint;
-              GrabConstraint = NULL;
-            }
-					}
-					break;
+					GrabConstraint = new MouseConstraint();
+					PHYSICS->AddConstraint(GrabConstraint);
+					GrabConstraint->SetBody(gocBody);
+					GrabConstraint->SetWorldPoint(WorldMousePosition);
+					GrabConstraint->SetTarget(WorldMousePosition);
 				}
+			}
 		}
 
-	};
+		//If the mouse has been release let go of the grabbed object
+		if( input.WasReleased(MouseButton::LeftMouse) && !input.IsHeld(MouseButton::LeftMouse) )
+			ReleaseGrab();
+
+		if( input.WasPressed(MouseButton::RightMouse) )
+		{
+			//On right click destroy the object at the mouse cursor
+			GOC * goc = PHYSICS->TestPoint( WorldMousePosition );
+			if( goc ) 
+				goc->Destroy();
+		}
+	}
 
 	void GameLogic::Update(float dt)
 	{
+		HandleMouse(GetInput());
+
 		ObjectLinkList<Controller>::iterator it = Controllers.begin();
 		for(;it!=Controllers.end();++it)
 			it->Update(dt);
@@ -384,36 +433,56 @@ namespace Framework
 		}
 	}
 
+	Bomb::Bomb()
+	{
+		Armed = false;
+		FuseTimer = 0;
+	}
+
+	Bomb::~Bomb()
+	{
+		TIMERS->Cancel(FuseTimer);
+	}
+
 	void Bomb::Initialize()
 	{
-		SpawnTime = timeGetTime();
+		//Nothing is checked each frame, the timer arms the bomb when the fuse runs out
+		FuseTimer = TIMERS->Schedule(Fuse / 1000.0f, GetOwner()->GetId(), Bomb::FuseBurnt);
+	}
+
+	void Bomb::FuseBurnt(GOC* object, void* data)
+	{
+		//The timer only knows the object id, so check the object still has a bomb
+		Bomb * bomb = object->has(Bomb);
+		if( bomb )
+			bomb->Armed = true;
 	}
 
 	void Bomb::Serialize(ISerializer& stream)
 	{
 		StreamRead(stream,Fuse);
-		StreamRead(stream,SubSpawnCount);
+		StreamRead(stream,BlastRadius);
+		StreamRead(stream,BlastStrength);
 	}
 
 	void Bomb::SendMessage(Message* m)
 	{
 		if( m->MessageId == Mid::Collide )
 		{			
-			if( (int)timeGetTime() - SpawnTime > Fuse )
+			if( Armed )
 			{
 				GetOwner()->Destroy();
-				if( SubSpawnCount > 0 )
-				{			
-					Transform * transform = GetOwner()->has(Transform);
-					for(int i=-1;i<=1;++i)
-					{
-						Vec2 dir( sin( float(i)*D3DX_PI*0.3f) , cos( float(i)*D3DX_PI*0.3f) );		
-						GOC * a = FACTORY->Create("Objects\\Shrapnel.txt");
-						Body * bodyA = a->has(Body);
-						bodyA->SetVelocity(dir * 120);
-						bodyA->SetPosition(transform->Position);
-					}
-				}
+
+				//Push everything nearby in the bomb's world away from it
+				Body * body = GetOwner()->has(Body);
+				Physics * world = body && body->World ? body->World : PHYSICS;
+				RadialImpulse blast;
+				blast.Center = GetOwner()->has(Transform)->Position;
+				blast.Radius = BlastRadius;
+				blast.Strength = BlastStrength;
+				blast.Falloff = FalloffLinear;
+				blast.RequireLineOfSight = true;
+				world->ApplyRadialImpulse(blast);
 			}
 		}
 	};
@@ -422,6 +491,7 @@ namespace Framework
 	{
 		//Set the default speed
 		Speed = 50.0f;
+		body = NULL;
 	}
 
 	Controller::~Controller()
@@ -432,19 +502,28 @@ namespace Framework
 	void Controller::Initialize()
 	{ 
 		transform = GetOwner()->has(Transform);
+		body = GetOwner()->has(Body);
+		if( body && !body->IsKinematic )
+			body = NULL;
 		LOGIC->Controllers.push_back( this );
 	}
 
 	void Controller::Update(float dt)
 	{
+		Vec2 move(0,0);
 		if( IsUpHeld() )
-			transform->Position.y -= Speed * dt;
+			move.y -= Speed;
 		if( IsDownHeld() )
-			transform->Position.y += Speed * dt;
+			move.y += Speed;
 		if( IsLeftHeld() )
-			transform->Position.x += Speed * dt;
+			move.x += Speed;
 		if( IsRightHeld() )
-			transform->Position.x -= Speed * dt;
+			move.x -= Speed;
+
+		if( body )
+			body->SetVelocity(move);
+		else
+			transform->Position += move * dt;
 	}
 
 	void Controller::Serialize(ISerializer& stream)
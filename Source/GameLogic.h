@@ -13,13 +13,17 @@
 #include "Graphics.h"
 #include "Physics.h"
 #include "Engine.h"
+#include "TimerWheel.h"
 
 namespace Framework
 {
+	struct InputState;
 
 	///Sample Demo Component Movement Controller. Used
 	///to move objects around the world not under
-	///the influence of physics.
+	///the influence of physics. If the object has a kinematic
+	///body the controller drives the body's velocity instead so
+	///it still pushes and carries other bodies.
 	class Controller : public GameComponent
 	{
 	public:
@@ -29,19 +33,26 @@ namespace Framework
 		~Controller();
 		virtual void Initialize();
 		Transform * transform;
+		Body * body;
 		float Speed;
 		void Update(float dt);
 		virtual void Serialize(ISerializer& stream);
 	};
 
 	///Sample Demo Component Explosive Bomb. Explodes on contact after
-	///its fuse has counted down.
+	///its fuse has counted down. The fuse is a game time timer.
 	class Bomb : public GameComponent
 	{
 	public:
+		Bomb();
+		~Bomb();
+		///Fuse length in milliseconds.
 		int Fuse;
-		int SubSpawnCount;
-		int SpawnTime;
+		float BlastRadius;
+		float BlastStrength;
+		bool Armed;
+		TimerId FuseTimer;
+		static void FuseBurnt(GOC* object, void* data);
 		virtual void Initialize();
 		virtual void Serialize(ISerializer& stream);
 		virtual void SendMessage(Message* m);
@@ -56,9 +67,20 @@ namespace Framework
 		void Initialize();
 		void Update(float timeslice);
 		virtual std::string GetName(){return "GameLogic";}
+		///Update handles the mouse and the controllers. It picks bodies,
+		///reads the camera to place the mouse, pushes bodies and moves
+		///transforms. Keys and dropped files arrive as queued messages.
+		virtual unsigned GetReads(){return SystemData::Input | SystemData::Objects | SystemData::Bodies | SystemData::Transforms | SystemData::Sprites;}
+		virtual unsigned GetWrites(){return SystemData::Objects | SystemData::Bodies | SystemData::Transforms;}
 		virtual void SendMessage(Message *);
 		GOC * CreateObjectAt(Vec2& position,float rotation,const std::string& file);
 		void LoadLevelFile(const std::string& file);
+		///Grab, drop and destroy objects with the mouse buttons of the frame.
+		void HandleMouse(const InputState& input);
+		///Let go of the grabbed object and delete its mouse constraint.
+		void ReleaseGrab();
+		///Level loaded by Initialize. Set it before the engine is initialized.
+		std::string LevelFile;
 		unsigned GrabbedObjectId;
     MouseConstraint* GrabConstraint;
 		Vec2 WorldMousePosition;
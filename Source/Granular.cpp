@@ -0,0 +1,396 @@
+///////////////////////////////////////////////////////////////////////////////////////
+//
+//	Granular.cpp
+//
+//	Authors: Chris Peters
+//	Copyright 2011, Digipen Institute of Technology
+//
+///////////////////////////////////////////////////////////////////////////////////////
+#include "Precompiled.h"
+#include "Granular.h"
+#include "Body.h"
+#include "ShapeGrid.h"
+#include "ShapeCompound.h"
+
+namespace Framework
+{
+	GranularSolver::GranularSolver()
+	{
+		Radius = 4.0f;
+		Mass = 50.0f;
+		Iterations = 4;
+		Damping = 0.9f;
+		MinParticlesPerThread = 2048;
+		TableMask = 0;
+		CellSize = 2.0f * Radius;
+		StepTime = 0.0f;
+		ThreadCount = 1;
+	}
+
+	void GranularSolver::Initialize(unsigned threadCount)
+	{
+		ThreadCount = threadCount > 0 ? threadCount : 1;
+	}
+
+	void GranularSolver::AddParticle(Vec2Param position, Vec2Param velocity)
+	{
+		PositionX.push_back(position.x);
+		PositionY.push_back(position.y);
+		VelocityX.push_back(velocity.x);
+		VelocityY.push_back(velocity.y);
+	}
+
+	void GranularSolver::Clear()
+	{
+		PositionX.clear();
+		PositionY.clear();
+		VelocityX.clear();
+		VelocityY.clear();
+	}
+
+	void GranularSolver::PredictRange(void* data, unsigned begin, unsigned end)
+	{
+		GranularSolver& s = *(GranularSolver*)data;
+		float dt = s.StepTime;
+		for(unsigned i=begin;i<end;++i)
+		{
+			s.VelocityX[i] += s.StepGravity.x * dt;
+			s.VelocityY[i] += s.StepGravity.y * dt;
+			s.PrevX[i] = s.PositionX[i];
+			s.PrevY[i] = s.PositionY[i];
+			s.PositionX[i] += s.VelocityX[i] * dt;
+			s.PositionY[i] += s.VelocityY[i] * dt;
+		}
+	}
+
+	void GranularSolver::HashRange(void* data, unsigned begin, unsigned end)
+	{
+		GranularSolver& s = *(GranularSolver*)data;
+		for(unsigned i=begin;i<end;++i)
+		{
+			s.CellX[i] = (int)floor(s.PositionX[i] / s.CellSize);
+			s.CellY[i] = (int)floor(s.PositionY[i] / s.CellSize);
+			s.Bucket[i] = s.HashCell(s.CellX[i], s.CellY[i]);
+		}
+	}
+
+	void GranularSolver::BuildHash()
+	{
+		unsigned count = GetCount();
+
+		//At least twice as many buckets as particles keeps collisions rare
+		unsigned tableSize = 1024;
+		while( tableSize < count * 2 )
+			tableSize *= 2;
+		TableMask = tableSize - 1;
+		CellSize = 2.0f * Radius;
+
+		ParallelFor(HashRange, this, count, MinParticlesPerThread, ThreadCount);
+
+		//Counting sort of the particles by bucket
+		BucketStart.assign(tableSize + 1, 0);
+		for(unsigned i=0;i<count;++i)
+			++BucketStart[Bucket[i] + 1];
+		for(unsigned b=0;b<tableSize;++b)
+			BucketStart[b + 1] += BucketStart[b];
+
+		//BucketStart is used as the insert position and then restored
+		SortedIndex.resize(count);
+		for(unsigned i=0;i<count;++i)
+			SortedIndex[BucketStart[Bucket[i]]++] = i;
+		for(unsigned b=tableSize;b>0;--b)
+			BucketStart[b] = BucketStart[b - 1];
+		BucketStart[0] = 0;
+	}
+
+	void GranularSolver::ProjectRange(void* data, unsigned begin, unsigned end)
+	{
+		GranularSolver& s = *(GranularSolver*)data;
+		float contactDistance = 2.0f * s.Radius;
+		float contactDistanceSq = contactDistance * contactDistance;
+
+		for(unsigned i=begin;i<end;++i)
+		{
+			float px = s.PositionX[i];
+			float py = s.PositionY[i];
+			float dx = 0.0f;
+			float dy = 0.0f;
+			unsigned contacts = 0;
+
+			//Visit the 3x3 block of cells around the particle. Two cells can
+			//share a bucket so each bucket is only visited once.
+			unsigned visited[9];
+			unsigned visitedCount = 0;
+			for(int y=-1;y<=1;++y)
+			{
+				for(int x=-1;x<=1;++x)
+				{
+					unsigned bucket = s.HashCell(s.CellX[i] + x, s.CellY[i] + y);
+					bool seen = false;
+					for(unsigned v=0;v<visitedCount;++v)
+						seen = seen || visited[v] == bucket;
+					if( seen )
+						continue;
+					visited[visitedCount++] = bucket;
+
+					for(unsigned k=s.BucketStart[bucket];k<s.BucketStart[bucket + 1];++k)
+					{
+						unsigned j = s.SortedIndex[k];
+						if( j == i )
+							continue;
+						float ox = px - s.PositionX[j];
+						float oy = py - s.PositionY[j];
+						float distanceSq = ox * ox + oy * oy;
+						if( distanceSq >= contactDistanceSq || distanceSq < 0.000001f )
+							continue;
+
+						//Each particle of the pair moves half the overlap
+						float distance = sqrt(distanceSq);
+						float push = 0.5f * (contactDistance - distance) / distance;
+						dx += ox * push;
+						dy += oy * push;
+						++contacts;
+					}
+				}
+			}
+
+			//Averaging the corrections keeps particles with many
+			//neighbors from overshooting
+			if( contacts > 0 )
+			{
+				dx /= contacts;
+				dy /= contacts;
+			}
+			s.DeltaX[i] = dx;
+			s.DeltaY[i] = dy;
+		}
+	}
+
+	void GranularSolver::ApplyRange(void* data, unsigned begin, unsigned end)
+	{
+		GranularSolver& s = *(GranularSolver*)data;
+		for(unsigned i=begin;i<end;++i)
+		{
+			s.PositionX[i] += s.DeltaX[i];
+			s.PositionY[i] += s.DeltaY[i];
+		}
+	}
+
+	void GranularSolver::VelocityRange(void* data, unsigned begin, unsigned end)
+	{
+		GranularSolver& s = *(GranularSolver*)data;
+		float invDt = 1.0f / s.StepTime;
+		float damping = std::pow(s.Damping, s.StepTime);
+		for(unsigned i=begin;i<end;++i)
+		{
+			s.VelocityX[i] = (s.PositionX[i] - s.PrevX[i]) * invDt * damping;
+			s.VelocityY[i] = (s.PositionY[i] - s.PrevY[i]) * invDt * damping;
+		}
+	}
+
+	//Find how far a particle has to move to leave the body.
+	static bool ParticleBodyContact(Body* body, Vec2Param point, float radius, Vec2& normal, float& depth)
+	{
+		Vec2 offset = point - body->Position;
+
+		if( body->BodyShape->Id == Shape::SidCircle )
+		{
+			float bodyRadius = ((ShapeCircle*)body->BodyShape)->Radius;
+			float distanceSq = LengthSquared(offset);
+			float contactDistance = bodyRadius + radius;
+			if( distanceSq >= contactDistance * contactDistance || distanceSq < 0.000001f )
+				return false;
+			float distance = sqrt(distanceSq);
+			normal = offset / distance;
+			depth = contactDistance - distance;
+			return true;
+		}
+
+		if( body->BodyShape->Id == Shape::SidBox )
+		{
+			Vec2 extents = ((ShapeAAB*)body->BodyShape)->Extents;
+			Mat2 rot;
+			rot.BuildRotation(body->Rotation);
+			Vec2 axes[2];
+			rot.GetBases(axes[0],axes[1]);
+
+			//Work in the space of the box
+			Vec2 local( Dot(offset, axes[0]) , Dot(offset, axes[1]) );
+			Vec2 closest( Clamp(local.x, -extents.x, extents.x) , Clamp(local.y, -extents.y, extents.y) );
+			Vec2 localNormal;
+
+			if( closest.x == local.x && closest.y == local.y )
+			{
+				//Center is inside the box, push out the nearest face
+				float faceX = extents.x - fabs(local.x);
+				float faceY = extents.y - fabs(local.y);
+				if( faceX < faceY )
+				{
+					localNormal = Vec2(local.x < 0.0f ? -1.0f : 1.0f, 0.0f);
+					depth = faceX + radius;
+				}
+				else
+				{
+					localNormal = Vec2(0.0f, local.y < 0.0f ? -1.0f : 1.0f);
+					depth = faceY + radius;
+				}
+			}
+			else
+			{
+				Vec2 away = local - closest;
+				float distanceSq = LengthSquared(away);
+				if( distanceSq >= radius * radius )
+					return false;
+				float distance = sqrt(distanceSq);
+				localNormal = away / distance;
+				depth = radius - distance;
+			}
+
+			normal = axes[0] * localNormal.x + axes[1] * localNormal.y;
+			return true;
+		}
+
+		if( body->BodyShape->Id == Shape::SidCompound )
+		{
+			//Use the deepest of the children
+			ShapePart particle;
+			particle.Id = Shape::SidCircle;
+			particle.Center = point;
+			particle.Radius = radius;
+			Manifold manifolds[CollsionDatabase::MaxManifolds];
+			unsigned count = ((ShapeCompound*)body->BodyShape)->CollidePart(particle, manifolds, CollsionDatabase::MaxManifolds);
+			depth = 0.0f;
+			for(unsigned i=0;i<count;++i)
+			{
+				if( manifolds[i].Points[0].Depth > depth )
+				{
+					normal = manifolds[i].Normal;
+					depth = manifolds[i].Points[0].Depth;
+				}
+			}
+			return depth > 0.0f;
+		}
+
+		if( body->BodyShape->Id == Shape::SidGrid )
+		{
+			//Use the deepest of the merged grid contacts
+			Manifold manifolds[CollsionDatabase::MaxManifolds];
+			unsigned count = ((ShapeGrid*)body->BodyShape)->CollideCircle(point, radius, manifolds, CollsionDatabase::MaxManifolds);
+			depth = 0.0f;
+			for(unsigned i=0;i<count;++i)
+			{
+				for(unsigned p=0;p<manifolds[i].PointCount;++p)
+				{
+					if( manifolds[i].Points[p].Depth > depth )
+					{
+						normal = manifolds[i].Normal;
+						depth = manifolds[i].Points[p].Depth;
+					}
+				}
+			}
+			return depth > 0.0f;
+		}
+
+		return false;
+	}
+
+	void GranularSolver::CollideBody(Body* body)
+	{
+		//Particles were hashed at the start of the step, so grow the
+		//bounds by a cell to catch particles that have moved since
+		Aabb bounds = body->BodyShape->ComputeAabb();
+		float margin = Radius + CellSize;
+		int minX = (int)floor((bounds.Min.x - margin) / CellSize);
+		int minY = (int)floor((bounds.Min.y - margin) / CellSize);
+		int maxX = (int)floor((bounds.Max.x + margin) / CellSize);
+		int maxY = (int)floor((bounds.Max.y + margin) / CellSize);
+
+		float particleInvMass = 1.0f / Mass;
+		float particleShare = particleInvMass / (particleInvMass + body->InvMass);
+		float bodyShare = 1.0f - particleShare;
+
+		unsigned count = GetCount();
+		float cellCount = float(maxX - minX + 1) * float(maxY - minY + 1);
+
+		//Huge bodies cover more cells than there are particles
+		bool scanAll = cellCount > float(count);
+		int cellsX = scanAll ? 1 : maxX - minX + 1;
+		int cellsY = scanAll ? 1 : maxY - minY + 1;
+
+		for(int cy=0;cy<cellsY;++cy)
+		{
+			for(int cx=0;cx<cellsX;++cx)
+			{
+				unsigned begin = 0;
+				unsigned end = count;
+				unsigned bucket = 0;
+				if( !scanAll )
+				{
+					bucket = HashCell(minX + cx, minY + cy);
+					begin = BucketStart[bucket];
+					end = BucketStart[bucket + 1];
+				}
+
+				for(unsigned k=begin;k<end;++k)
+				{
+					unsigned i = SortedIndex[k];
+					//Skip particles from other cells that share the bucket
+					if( !scanAll && (CellX[i] != minX + cx || CellY[i] != minY + cy) )
+						continue;
+
+					Vec2 normal;
+					float depth;
+					Vec2 point(PositionX[i], PositionY[i]);
+					if( !ParticleBodyContact(body, point, Radius, normal, depth) )
+						continue;
+
+					PositionX[i] += normal.x * depth * particleShare;
+					PositionY[i] += normal.y * depth * particleShare;
+
+					if( body->InvMass > 0.0f )
+					{
+						Vec2 move = normal * (depth * bodyShare);
+						body->Position -= move;
+						body->Velocity -= move / StepTime;
+					}
+				}
+			}
+		}
+	}
+
+	void GranularSolver::Step(float dt, Vec2Param gravity, ObjectLinkList<Body>& bodies)
+	{
+		unsigned count = GetCount();
+		if( count == 0 )
+			return;
+
+		StepTime = dt;
+		StepGravity = gravity;
+		PrevX.resize(count);
+		PrevY.resize(count);
+		DeltaX.resize(count);
+		DeltaY.resize(count);
+		CellX.resize(count);
+		CellY.resize(count);
+		Bucket.resize(count);
+
+		ParallelFor(PredictRange, this, count, MinParticlesPerThread, ThreadCount);
+
+		BuildHash();
+
+		for(unsigned iteration=0;iteration<Iterations;++iteration)
+		{
+			ParallelFor(ProjectRange, this, count, MinParticlesPerThread, ThreadCount);
+			ParallelFor(ApplyRange, this, count, MinParticlesPerThread, ThreadCount);
+
+			//Bodies are few so they are done on this thread
+			for(ObjectLinkList<Body>::iterator it=bodies.begin();it!=bodies.end();++it)
+			{
+				if( !it->IsSensor )
+					CollideBody(it);
+			}
+		}
+
+		ParallelFor(VelocityRange, this, count, MinParticlesPerThread, ThreadCount);
+	}
+}
@@ -0,0 +1,91 @@
+///////////////////////////////////////////////////////////////////////////////////////
+///
+///	\file Granular.h
+///	Position based dynamics solver for very large numbers of equal sized
+///	circle particles (sand, ball pits).
+///
+///	Authors: Chris Peters
+///	Copyright 2011, Digipen Institute of Technology
+///
+///////////////////////////////////////////////////////////////////////////////////////
+#pragma once //Makes sure this header is only included once
+
+#include "VMath.h"
+#include "JobSystem.h"
+
+namespace Framework
+{
+	class Body;
+
+	///Particles are not game objects. They are stored as structure of arrays
+	///and only have a position and velocity. Each step the particles are
+	///predicted forward, put into a spatial hash and then their overlaps
+	///are projected apart for a few iterations. Each particle computes its
+	///own correction from its neighbors (Jacobi style) so the projection
+	///splits across threads without locks and gives the same result for any
+	///thread count. Particles collide with regular bodies and push dynamic
+	///bodies around.
+	class GranularSolver
+	{
+	public:
+		GranularSolver();
+
+		///Set the most jobs each pass over the particles is split into.
+		void Initialize(unsigned threadCount);
+
+		void AddParticle(Vec2Param position, Vec2Param velocity);
+		void Clear();
+		unsigned GetCount(){return PositionX.size();}
+
+		///Advance all the particles and resolve them against the bodies.
+		void Step(float dt, Vec2Param gravity, ObjectLinkList<Body>& bodies);
+
+		//Particle positions, read by graphics
+		std::vector<float> PositionX;
+		std::vector<float> PositionY;
+
+		///Radius of every particle.
+		float Radius;
+		///Mass of every particle, used against dynamic bodies.
+		float Mass;
+		///Projection iterations per step.
+		unsigned Iterations;
+		///Velocity kept per second, like Body::Damping.
+		float Damping;
+		///Particles per thread below which work is not split.
+		unsigned MinParticlesPerThread;
+
+	private:
+		void BuildHash();
+		unsigned HashCell(int x, int y){return ((unsigned)x * 73856093u ^ (unsigned)y * 19349663u) & TableMask;}
+		void CollideBody(Body* body);
+
+		static void PredictRange(void* data, unsigned begin, unsigned end);
+		static void HashRange(void* data, unsigned begin, unsigned end);
+		static void ProjectRange(void* data, unsigned begin, unsigned end);
+		static void ApplyRange(void* data, unsigned begin, unsigned end);
+		static void VelocityRange(void* data, unsigned begin, unsigned end);
+
+		std::vector<float> PrevX;
+		std::vector<float> PrevY;
+		std::vector<float> VelocityX;
+		std::vector<float> VelocityY;
+		std::vector<float> DeltaX;
+		std::vector<float> DeltaY;
+
+		//Spatial hash. Particles are counting sorted by bucket each step.
+		std::vector<int> CellX;
+		std::vector<int> CellY;
+		std::vector<unsigned> Bucket;
+		std::vector<unsigned> BucketStart;
+		std::vector<unsigned> SortedIndex;
+		unsigned TableMask;
+		float CellSize;
+
+		//Parameters of the current step for the range functions
+		float StepTime;
+		Vec2 StepGravity;
+
+		unsigned ThreadCount;
+	};
+}
@@ -0,0 +1,128 @@
+///////////////////////////////////////////////////////////////////////////////////////
+///
+///	\file GranularBenchmark.cpp
+///	Measures the granular solver against its frame budget.
+///
+///	Authors: Chris Peters
+///	Copyright 2011, Digipen Institute of Technology
+///
+///////////////////////////////////////////////////////////////////////////////////////
+#include "Precompiled.h"
+#include "GranularBenchmark.h"
+#include "Factory.h"
+#include "Transform.h"
+#include "FrameTiming.h"
+#include "Threading.h"
+#include <algorithm>
+
+namespace Framework
+{
+	//Thickness of the floor and walls around the particles
+	const float WallHalfThickness = 20.0f;
+
+	GranularBenchmark::GranularBenchmark()
+	{
+		ParticleCount = 100000;
+		StepCount = 120;
+		TimeStep = 1.0f / 60.0f;
+		ThreadCount = 0;
+	}
+
+	void GranularBenchmark::AddWall(Physics* world, Vec2Param position, Vec2Param extents)
+	{
+		GOC * object = FACTORY->CreateEmptyComposition();
+		Transform * transform = new Transform();
+		transform->Position = position;
+		object->AddComponent(CT_Transform, transform);
+
+		Body * body = new Body(world);
+		body->Density = 0.0f;
+		body->Friction = 0.6f;
+		ShapeAAB * box = new ShapeAAB();
+		box->Extents = extents;
+		body->BodyShape = box;
+		object->AddComponent(CT_Body, body);
+
+		object->Initialize();
+		Objects.push_back(object);
+	}
+
+	GranularBenchmark::Result GranularBenchmark::Run()
+	{
+		Result result;
+		result.Threads = ThreadCount > 0 ? ThreadCount : GetHardwareThreadCount();
+
+		Physics * world = new Physics();
+		world->InitializeWorld(result.Threads);
+		GranularSolver& granular = world->Granular;
+
+		//A block about four times as wide as it is tall, packed so each
+		//particle touches its neighbors, resting on the floor at zero
+		float spacing = granular.Radius * 2.0f;
+		unsigned columns = (unsigned)sqrt(ParticleCount * 4.0f) + 1;
+		unsigned rows = (ParticleCount + columns - 1) / columns;
+		float halfWidth = columns * spacing * 0.5f;
+		float height = rows * spacing;
+		for(unsigned i=0;i<ParticleCount;++i)
+		{
+			Vec2 position( (i % columns) * spacing - halfWidth + granular.Radius ,
+				(i / columns) * spacing + granular.Radius );
+			granular.AddParticle(position, Vec2(0,0));
+		}
+
+		//Floor and walls, with the walls twice as tall as the block
+		AddWall(world, Vec2(0, -WallHalfThickness), Vec2(halfWidth + WallHalfThickness * 2.0f, WallHalfThickness));
+		AddWall(world, Vec2(-halfWidth - WallHalfThickness, height), Vec2(WallHalfThickness, height));
+		AddWall(world, Vec2(halfWidth + WallHalfThickness, height), Vec2(WallHalfThickness, height));
+
+		std::vector<float> times(StepCount);
+		for(unsigned i=0;i<StepCount;++i)
+		{
+			TimeNs start = GetTimeNs();
+			world->Step(TimeStep);
+			times[i] = NsToMilliseconds(GetTimeNs() - start);
+		}
+		world->DeliverEvents();
+
+		float total = 0.0f;
+		for(unsigned i=0;i<StepCount;++i)
+			total += times[i];
+		std::sort(times.begin(), times.end());
+		result.AverageMilliseconds = StepCount > 0 ? total / StepCount : 0.0f;
+		result.P95Milliseconds = StepCount > 0 ? times[StepCount * 95 / 100] : 0.0f;
+		result.MaxMilliseconds = StepCount > 0 ? times.back() : 0.0f;
+
+		result.Escaped = 0;
+		for(unsigned i=0;i<granular.GetCount();++i)
+		{
+			if( fabs(granular.PositionX[i]) > halfWidth + granular.Radius || granular.PositionY[i] < -granular.Radius )
+				++result.Escaped;
+		}
+
+		//Leave the world now so the bodies do not reach back into it
+		//when the factory deletes the objects later
+		for(unsigned i=0;i<Objects.size();++i)
+		{
+			Body * body = Objects[i]->has(Body);
+			world->RemoveBody(body);
+			body->World = NULL;
+			FACTORY->Destroy(Objects[i]);
+		}
+		Objects.clear();
+		delete world;
+
+		return result;
+	}
+
+	void GranularBenchmark::RunAndPrint()
+	{
+		Result result = Run();
+		const float budget = 1000.0f / 60.0f;
+		LogPrint("Granular: %u particles, %u steps on %u threads: avg %.2f ms p95 %.2f ms max %.2f ms, %u escaped",
+			ParticleCount, StepCount, result.Threads, result.AverageMilliseconds, result.P95Milliseconds,
+			result.MaxMilliseconds, result.Escaped);
+		LogPrint("Granular: the average step is %.0f%% of a 60 Hz frame (%.2f ms), %s",
+			result.AverageMilliseconds / budget * 100.0f, budget,
+			result.AverageMilliseconds <= budget ? "within the goal" : "over the goal");
+	}
+}
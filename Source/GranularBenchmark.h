@@ -0,0 +1,52 @@
+///////////////////////////////////////////////////////////////////////////////////////
+///
+///	\file GranularBenchmark.h
+///	Measures the granular solver against its frame budget.
+///
+///	Authors: Chris Peters
+///	Copyright 2011, Digipen Institute of Technology
+///
+///////////////////////////////////////////////////////////////////////////////////////
+#pragma once //Makes sure this header is only included once
+
+#include "Physics.h"
+
+namespace Framework
+{
+	///Fills a walled box with a block of resting particles in a world of
+	///its own and times each step. The goal is 100,000 particles stepped
+	///at 60 Hz, so the report compares the step time with one 60 Hz frame.
+	///The particles start packed, touching their neighbors, which is the
+	///most expensive case for the projection.
+	class GranularBenchmark
+	{
+	public:
+		GranularBenchmark();
+
+		struct Result
+		{
+			///Threads the particle passes were split over.
+			unsigned Threads;
+			///Step times in milliseconds.
+			float AverageMilliseconds;
+			float P95Milliseconds;
+			float MaxMilliseconds;
+			///Particles that left the box, which should be none.
+			unsigned Escaped;
+		};
+
+		Result Run();
+		///Run and print the result against the 60 Hz budget.
+		void RunAndPrint();
+
+		unsigned ParticleCount;
+		unsigned StepCount;
+		float TimeStep;
+		///Threads the world splits its work over, zero for every core.
+		unsigned ThreadCount;
+
+	private:
+		void AddWall(Physics* world, Vec2Param position, Vec2Param extents);
+		std::vector<GOC*> Objects;
+	};
+}
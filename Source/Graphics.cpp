@@ -8,12 +8,19 @@
 ///////////////////////////////////////////////////////////////////////////////////////
 
 #include "Precompiled.h"
+
+#ifndef G_HEADLESS
+
+#include "DirectXIncludes.h"
 #include "Graphics.h"
 #include "DebugDraw.h"
 #include "VertexTypes.h"
 #include "FilePath.h"
 #include "Camera.h"
 #include "ComponentCreator.h"
+#include "Physics.h"
+#include "WindowsSystem.h"
+#include <algorithm>
 
 namespace Framework
 {
@@ -28,37 +35,51 @@ namespace Framework
 		pDevice = NULL;
 		pQuadVertexBuffer = NULL;
 		ZeroMemory(Shaders, sizeof(Shaders));
+		Pipelined = true;
+		WritePacket = 0;
+		PublishedPacket = NULL;
+		RenderingPacket = NULL;
+		RenderQuit = false;
+		ParticlesPerDraw = 8192;
+		DeviceIsLost = false;
+		ResetSucceeded = false;
 
 		ErrorIf(GRAPHICS!=NULL,"Graphics already initialized.");
 		GRAPHICS = this;
 	}
 
-	void Graphics::SetWindwProperties(HWND hWnd,int screenWidth,int screenHeight)
+	void Graphics::SetWindwProperties(void* hWnd,int screenWidth,int screenHeight)
 	{
 		HWnd = hWnd;
 		ScreenWidth = screenWidth;
 		ScreenHeight = screenHeight;
 	}
 
-	//Initializes Direct3D
-	void Graphics::Initialize()
+	//Set up the structure used to create and reset the D3DDevice.
+	static void FillPresentParameters(Graphics* graphics, D3DPRESENT_PARAMETERS& pp)
 	{
-		//Create the D3D object (the parameter is there to make sure the app was built correctly).
-		pD3D = Direct3DCreate9(D3D_SDK_VERSION);
-
-		D3DDISPLAYMODE displayMode;
-		pD3D->GetAdapterDisplayMode(D3DADAPTER_DEFAULT, &displayMode);
-
-		//Set up the structure used to create the D3DDevice.
-		ZeroMemory(&PresentParameters, sizeof(PresentParameters));
+		ZeroMemory(&pp, sizeof(pp));
 
-		D3DPRESENT_PARAMETERS& pp = PresentParameters;
 		pp.Windowed = true;						//You can't just set this to FALSE--you'll need to change other stuff as well.
 		pp.SwapEffect = D3DSWAPEFFECT_DISCARD;	//Picks the best way to handle back buffers for you, but it means you have draw a full screen every time.
 		pp.BackBufferFormat = D3DFMT_UNKNOWN;	//This is for windowed apps, full screen will need to be explicit.
 		pp.PresentationInterval  = D3DPRESENT_INTERVAL_DEFAULT;
-		pp.BackBufferWidth = ScreenWidth;
-		pp.BackBufferHeight = ScreenHeight;
+		pp.BackBufferWidth = graphics->ScreenWidth;
+		pp.BackBufferHeight = graphics->ScreenHeight;
+	}
+
+	//Direct3D creates, resets and releases the device on the thread that owns
+	//the focus window, which is the windows system's input thread
+	void Graphics::CreateDevice(void* data)
+	{
+		Graphics * graphics = (Graphics*)data;
+		IDirect3D9 * pD3D = graphics->pD3D;
+
+		D3DDISPLAYMODE displayMode;
+		pD3D->GetAdapterDisplayMode(D3DADAPTER_DEFAULT, &displayMode);
+
+		D3DPRESENT_PARAMETERS pp;
+		FillPresentParameters(graphics, pp);
 
 		//Create the D3DDevice
     // IF THIS CALL FAILS:
@@ -69,17 +90,92 @@ namespace Framework
     //   with D3DCREATE_SOFTWARE_VERTEXPROCESSING.
 		DXVerify(pD3D->CreateDevice(D3DADAPTER_DEFAULT,	//The graphics adapter to be used.
 									  D3DDEVTYPE_HAL,		//Type of graphics device: Hardware acceleration or software
-									  HWnd,					//Window Handle for the device.
+									  (HWND)graphics->HWnd,	//Window Handle for the device.
 									  D3DCREATE_HARDWARE_VERTEXPROCESSING,	//Device behavior: vertex processing (software, mixed, hardware), double precision, etc.
 									  &pp,				//The presentation parameters created above.
- 									  &pDevice));			//A pointer to the new device.
+ 									  &graphics->pDevice));	//A pointer to the new device.
+	}
 
-		//Set our render states (culling, lighting, shading, zbuffers, etc.).
+	void Graphics::ReleaseDevice(void* data)
+	{
+		Graphics * graphics = (Graphics*)data;
+		SafeRelease(graphics->pDevice);
+	}
+
+	void Graphics::ResetDevice(void* data)
+	{
+		Graphics * graphics = (Graphics*)data;
+		D3DPRESENT_PARAMETERS pp;
+		FillPresentParameters(graphics, pp);
+		graphics->ResetSucceeded = SUCCEEDED(graphics->pDevice->Reset(&pp));
+	}
+
+	void Graphics::SetRenderStates()
+	{
 		pDevice->SetRenderState(D3DRS_CULLMODE, D3DCULL_NONE);			//Turn off culling
 		pDevice->SetRenderState(D3DRS_LIGHTING, FALSE);					//Turn off D3D lighting
 		pDevice->SetRenderState(D3DRS_ALPHABLENDENABLE, TRUE);			//Turn on alpha blending.
 		pDevice->SetRenderState(D3DRS_SRCBLEND, D3DBLEND_SRCALPHA);		//Use the texture's alpha channel.
 		pDevice->SetRenderState(D3DRS_DESTBLEND, D3DBLEND_INVSRCALPHA);	//Use the inverse of the texture's alpha channel.
+	}
+
+	void Graphics::DeviceLost()
+	{
+		//Effects hold device state that must be released before a reset
+		for (int i = 0; i < NumberOfShaders; i++)
+		{
+			if (Shaders[i] != NULL) Shaders[i]->OnLostDevice();
+		}
+	}
+
+	void Graphics::DeviceReset()
+	{
+		for (int i = 0; i < NumberOfShaders; i++)
+		{
+			if (Shaders[i] != NULL) Shaders[i]->OnResetDevice();
+		}
+		//A reset puts every render state back to its default
+		SetRenderStates();
+	}
+
+	bool Graphics::RestoreDevice()
+	{
+		HRESULT hr = pDevice->TestCooperativeLevel();
+		//Still lost, try again next frame
+		if( hr == D3DERR_DEVICELOST )
+			return false;
+
+		if( hr == D3DERR_DEVICENOTRESET )
+		{
+			DeviceLost();
+			//Only draws use the device between frames and this is the
+			//thread drawing, so nothing else touches it during the reset
+			WINDOWSSYSTEM->RunOnWindowThread(ResetDevice, this);
+			if( !ResetSucceeded )
+				return false;
+			DeviceReset();
+		}
+
+		DeviceIsLost = false;
+		return true;
+	}
+
+	//Initializes Direct3D
+	void Graphics::Initialize()
+	{
+		//Create the D3D object (the parameter is there to make sure the app was built correctly).
+		pD3D = Direct3DCreate9(D3D_SDK_VERSION);
+
+		WINDOWSSYSTEM->RunOnWindowThread(CreateDevice, this);
+
+		//Each particle is two triangles and one draw call can not go
+		//past the device's primitive limit
+		D3DCAPS9 caps;
+		pDevice->GetDeviceCaps(&caps);
+		ParticlesPerDraw = std::min(ParticlesPerDraw, (unsigned)caps.MaxPrimitiveCount / 2);
+
+		//Set our render states (culling, lighting, shading, zbuffers, etc.).
+		SetRenderStates();
 
 		SurfaceSize = Vec2((float)ScreenWidth, (float)ScreenHeight);
 
@@ -93,13 +189,28 @@ namespace Framework
 		//Load all of our assets (textures and shaders)
 		GRAPHICS->LoadAssets();
 
+		//From here on the device belongs to the render thread
+		if( Pipelined )
+			RenderThread.Start(RenderThreadMain, this);
+	}
 
-
+	void Graphics::StopRenderThread()
+	{
+		if( !RenderThread.IsRunning() )
+			return;
+		if( RenderingPacket )
+			RenderDone.Wait();
+		RenderingPacket = NULL;
+		RenderQuit = true;
+		RenderStart.Signal();
+		RenderThread.Join();
 	}
 
 	//Release Direct3D and do any needed cleanup.
 	Graphics::~Graphics()
 	{
+		StopRenderThread();
+
 		//Release all the shaders.
 		for (int i = 0; i < NumberOfShaders; i++)
 		{
@@ -114,7 +225,7 @@ namespace Framework
 		//Release the vertex buffer.
 		SafeRelease(pQuadVertexBuffer);
 		//Release the device.
-		SafeRelease(pDevice);
+		WINDOWSSYSTEM->RunOnWindowThread(ReleaseDevice, this);
 		//Release the Direct3D object.
 		SafeRelease(pD3D);
 
@@ -123,6 +234,93 @@ namespace Framework
 	//Render the array of sprites.
 	void Graphics::Update(float dt)
 	{
+		//Wait for the last frame to finish drawing before
+		//reusing the device
+		if( RenderingPacket )
+		{
+			RenderDone.Wait();
+			RenderingPacket = NULL;
+		}
+
+		//Draw the frame the last EndFrame published. It is a copy, so
+		//the other systems can change the live state meanwhile.
+		if( PublishedPacket == NULL )
+			return;
+		FramePacket& packet = *PublishedPacket;
+		PublishedPacket = NULL;
+
+		if( RenderThread.IsRunning() )
+		{
+			//Draw this frame while the next one simulates
+			RenderingPacket = &packet;
+			RenderStart.Signal();
+		}
+		else
+		{
+			RenderFrame(packet);
+		}
+	}
+
+	void Graphics::EndFrame()
+	{
+		//The render thread may still be drawing the last packet, so
+		//this frame goes in the other one
+		FramePacket& packet = Packets[WritePacket];
+		ExtractFrame(packet);
+		PublishedPacket = &packet;
+		WritePacket = 1 - WritePacket;
+	}
+
+	unsigned Graphics::RenderThreadMain(void* data)
+	{
+		Graphics * graphics = (Graphics*)data;
+		for(;;)
+		{
+			graphics->RenderStart.Wait();
+			if( graphics->RenderQuit )
+				break;
+			graphics->RenderFrame(*graphics->RenderingPacket);
+			graphics->RenderDone.Signal();
+		}
+		return 0;
+	}
+
+	void Graphics::ExtractFrame(FramePacket& packet)
+	{
+		//The camera is read here so the matrices used for
+		//picking match the frame being drawn
+		SetupMatrices();
+		packet.ViewMatrix = ViewMatrix;
+		packet.ProjMatrix = ProjMatrix;
+		packet.ViewProjMatrix = ViewProjMatrix;
+
+		packet.Sprites.resize(0);
+		ObjectLinkList<Sprite>::iterator it = SpriteList.begin();
+		for(;it!=SpriteList.end();++it)
+		{
+			packet.Sprites.push_back(SpriteInstance());
+			it->Extract(packet.Sprites.back());
+		}
+
+		GranularSolver& granular = PHYSICS->Granular;
+		packet.ParticleX.assign(granular.PositionX.begin(), granular.PositionX.end());
+		packet.ParticleY.assign(granular.PositionY.begin(), granular.PositionY.end());
+		packet.ParticleRadius = granular.Radius;
+
+		//Take the debug lines and leave the packet's old buffers to the
+		//drawer so neither side allocates once they have grown
+		Drawer::Instance.Flush();
+		packet.LineSets.swap(Drawer::Instance.Sets);
+		packet.Lines.swap(Drawer::Instance.LineSegments);
+		Drawer::Instance.Clear();
+	}
+
+	void Graphics::RenderFrame(FramePacket& packet)
+	{
+		//Frames are dropped until a lost device is back
+		if( DeviceIsLost && !RestoreDevice() )
+			return;
+
 		//Clear the backbuffer and fill it with the background color.
 		//The first parameter is the number of rectangles you are going to clear--0 means clear the whole thing.
 		//The second parameter is the array of rectangle to clear--just set it to NULL.
@@ -134,9 +332,9 @@ namespace Framework
 		//Begin the scene
 		if (SUCCEEDED(pDevice->BeginScene()))
 		{
-			DrawWorld();
+			DrawWorld(packet);
 
-			DrawDebugInfo();
+			DrawDebugInfo(packet);
 
 			//End the scene
 			pDevice->EndScene();
@@ -144,31 +342,110 @@ namespace Framework
 		
 		//Present the backbuffer contents to the display.
 		//The parameters are: source rect, dest rect, dest window (NULL meaning the default window), and dirty region.
-		pDevice->Present(NULL, NULL, NULL, NULL);
+		if( pDevice->Present(NULL, NULL, NULL, NULL) == D3DERR_DEVICELOST )
+			DeviceIsLost = true;
 	}
 
 
-	void Graphics::DrawWorld()
+	void Graphics::DrawWorld(FramePacket& packet)
 	{
-		//Setup the world, view, and projection matrices
-		SetupMatrices();
-
 		//TODO: Draw background
 
-		//Iterate through the link list of sprite and draw them all
+		//Draw all the sprites extracted for this frame
 		//TODO: Need Visibility to cull off screen sprites
-		ObjectLinkList<Sprite>::iterator it = SpriteList.begin();
-		for(;it!=SpriteList.end();++it)
-			it->Draw(pDevice, Shaders[Basic]);
+		for(unsigned i=0;i<packet.Sprites.size();++i)
+			packet.Sprites[i].Draw(pDevice, Shaders[Basic], packet.ViewProjMatrix);
 
+		DrawParticles(packet);
 	}
 
-	void Graphics::DrawDebugInfo()
+	void SpriteInstance::Draw(IDirect3DDevice9*	pDevice,ID3DXEffect* shader,const Mat4& viewProj)
 	{
-		Drawer::Instance.Flush();
 
-		std::vector<Drawer::LineSegment>& Lines = Drawer::Instance.LineSegments;
-		std::vector<Drawer::LineSet>& Sets = Drawer::Instance.Sets;
+		//Transform the sprite.
+		Mat4 matSprite, matTranslate, matRotate;
+		//First, scale it to the proper width and height.
+		D3DXMatrixScaling(DxMat(matSprite), Size.x, Size.y, 1.0f);
+		//Then, rotate it to the proper angle.
+		D3DXMatrixRotationZ(DxMat(matRotate), Rotation);
+		D3DXMatrixMultiply(DxMat(matSprite), DxMat(matSprite), DxMat(matRotate));
+		//Finally, move it to the proper location (note the floor functions on the positions).
+		D3DXMatrixTranslation(DxMat(matTranslate), floor(Position.x), floor(Position.y), 0.0f);
+		D3DXMatrixMultiply(DxMat(matSprite), DxMat(matSprite), DxMat(matTranslate));
+		
+		//Override the normal world transform and use the transform for this sprite.
+		shader->SetTechnique("Technique0");
+		pDevice->SetStreamSource(0, GRAPHICS->pQuadVertexBuffer, 0, sizeof(Vertex2D));
+		pDevice->SetFVF(VERTEX2D_FVF);
+
+		Mat4 worldViewProj = matSprite * viewProj;
+		UINT numberOfPasses = 0;
+		shader->SetMatrix( "WorldViewProj", DxMat(worldViewProj) );
+		shader->Begin(&numberOfPasses,0);
+		shader->SetTexture( "texture0" , pTexture );
+		shader->SetVector( "color" , DxVec(Color) );
+		for(UINT pass=0;pass<numberOfPasses;++pass)
+		{
+			shader->BeginPass(pass);
+			pDevice->DrawPrimitive(D3DPT_TRIANGLESTRIP, 0, 2);
+			shader->EndPass();
+		}
+		shader->End();
+	}
+
+	void Graphics::DrawParticles(FramePacket& packet)
+	{
+		unsigned count = packet.ParticleX.size();
+		if( count == 0 )
+			return;
+
+		//There are far too many particles to draw one at a time like
+		//sprites, so build two triangles per particle in world space
+		//and draw them in a few large batches
+		const float tu[6] = { 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 1.0f };
+		const float tv[6] = { 1.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f };
+		const float sx[6] = { -1.0f, -1.0f, 1.0f, 1.0f, -1.0f, 1.0f };
+		const float sy[6] = { -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f };
+		float radius = packet.ParticleRadius;
+
+		ParticleVertices.resize(count * 6);
+		for(unsigned i=0;i<count;++i)
+		{
+			Vertex2D * quad = &ParticleVertices[i * 6];
+			for(unsigned v=0;v<6;++v)
+			{
+				quad[v].Position = Vec3(packet.ParticleX[i] + sx[v] * radius, packet.ParticleY[i] + sy[v] * radius, 0.0f);
+				quad[v].tu = tu[v];
+				quad[v].tv = tv[v];
+			}
+		}
+
+		ID3DXEffect* shader = Shaders[Basic];
+		Vec4 color(0.9f, 0.8f, 0.4f, 1.0f);
+		shader->SetTechnique("Technique0");
+		pDevice->SetFVF(VERTEX2D_FVF);
+		UINT numberOfPasses = 0;
+		shader->SetMatrix( "WorldViewProj", DxMat(packet.ViewProjMatrix) );
+		shader->Begin(&numberOfPasses,0);
+		shader->SetTexture( "texture0" , GetTexture("circle") );
+		shader->SetVector( "color" , DxVec(color) );
+		for(UINT pass=0;pass<numberOfPasses;++pass)
+		{
+			shader->BeginPass(pass);
+			for(unsigned first=0;first<count;first+=ParticlesPerDraw)
+			{
+				unsigned batch = std::min(ParticlesPerDraw, count - first);
+				pDevice->DrawPrimitiveUP(D3DPT_TRIANGLELIST, batch * 2, &ParticleVertices[first * 6], sizeof(Vertex2D));
+			}
+			shader->EndPass();
+		}
+		shader->End();
+	}
+
+	void Graphics::DrawDebugInfo(FramePacket& packet)
+	{
+		std::vector<Drawer::LineSegment>& Lines = packet.Lines;
+		std::vector<Drawer::LineSet>& Sets = packet.LineSets;
 		pDevice->SetFVF(LINE_FVF);
 
 		//Each set is collection of lines that are in the same style (color)
@@ -180,10 +457,10 @@ namespace Framework
 			unsigned numberOfSegments = Sets[set].Segments;
 			Vec4 lineColor = Sets[set].Color;
 			
-			Mat4 worldViewProj = ViewMatrix * ProjMatrix;
+			Mat4 worldViewProj = packet.ViewMatrix * packet.ProjMatrix;
 
-			Shaders[DebugShader]->SetMatrix("WorldViewProj", &worldViewProj);
-			Shaders[DebugShader]->SetVector("color", &lineColor);
+			Shaders[DebugShader]->SetMatrix("WorldViewProj", DxMat(worldViewProj));
+			Shaders[DebugShader]->SetVector("color", DxVec(lineColor));
 			
 			UINT numberOfPasses = 0;
 			Shaders[DebugShader]->Begin(&numberOfPasses, 0);
@@ -197,8 +474,7 @@ namespace Framework
 			Shaders[DebugShader]->End();
 		}
 
-		//Clear all the lines they must be submitted again each frame
-		Drawer::Instance.Clear();
+		//The lines must be submitted again each frame
 	}
 
 	//Set up the world, view, and projection transform matrices.
@@ -217,19 +493,23 @@ namespace Framework
 		Vec3 upVector( 0.0f, 1.0f, 0.0f );
 		//Create a left-handed view matrix.
 		Mat4 matView;
-		D3DXMatrixLookAtLH(&matView, (DxVec3*)&eyePoint, (DxVec3*)&lookAtPoint, (DxVec3*)&upVector);
+		D3DXMatrixLookAtLH(DxMat(matView), (DxVec3*)&eyePoint, (DxVec3*)&lookAtPoint, (DxVec3*)&upVector);
 		//Store the view matrix
 		ViewMatrix = matView;
 		//Create an orthogonal left-handed projection matrix.
 		//This will transform everything to the view port with no perspective.
 		//The near and far clipping plains are still needed, but not as important.
 		Mat4 matProj;
-		D3DXMatrixOrthoLH(&matProj, SurfaceSize.x , SurfaceSize.y , 1.0f, 100.0f);
+		D3DXMatrixOrthoLH(DxMat(matProj), SurfaceSize.x , SurfaceSize.y , 1.0f, 100.0f);
 		//Store the projection matrix;
 		ProjMatrix = matProj;
 
 		//Store the view projection matrix
 		ViewProjMatrix = ViewMatrix * ProjMatrix;
+
+		//Picking unprojects with the inverse, which only changes with the camera
+		float det;
+		D3DXMatrixInverse(DxMat(InverseViewProjMatrix),&det,DxMat(ViewProjMatrix));
 	}
 
 	Vec2 Graphics::ScreenToWorldSpace(Vec2 screenPosition)
@@ -245,11 +525,8 @@ namespace Framework
 
 		//Unproject the point by applying the inverse
 		//of the ViewProjection matrix
-		Mat4 inverseViewProjection;
-		float det;
-		D3DXMatrixInverse(&inverseViewProjection,&det,&ViewProjMatrix);
 		Vec4 worldSpacePosition;
-		D3DXVec2Transform(&worldSpacePosition,(DxVec2*)&screenPosition,&inverseViewProjection);
+		D3DXVec2Transform(DxVec(worldSpacePosition),(DxVec2*)&screenPosition,DxMat(InverseViewProjMatrix));
 		return Vec2(worldSpacePosition.x,worldSpacePosition.y);
 	}
 
@@ -379,3 +656,5 @@ namespace Framework
 		return true;
 	}
 }
+
+#endif
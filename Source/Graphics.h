@@ -11,6 +11,12 @@
 
 #include "Engine.h"
 #include "Sprite.h"
+#include "VertexTypes.h"
+#include "DebugDraw.h"
+#include "Threading.h"
+
+struct IDirect3D9;
+struct IDirect3DVertexBuffer9;
 
 namespace Framework
 {	
@@ -24,22 +30,50 @@ namespace Framework
 		NumberOfShaders
 	};
 
+	///Everything needed to render one frame. Filled from the game objects
+	///at the end of a frame so drawing never reads live state.
+	struct FramePacket
+	{
+		Mat4 ViewMatrix;
+		Mat4 ProjMatrix;
+		Mat4 ViewProjMatrix;
+		std::vector<SpriteInstance> Sprites;
+		std::vector<float> ParticleX;
+		std::vector<float> ParticleY;
+		float ParticleRadius;
+		std::vector<Drawer::LineSet> LineSets;
+		std::vector<Drawer::LineSegment> Lines;
+	};
+
 	///A two-dimensional hardware accelerated non fixed function 
 	///sprite based graphics system.
+	///EndFrame copies the finished frame into one of two frame packets and
+	///the next Update draws it, or hands it to the render thread, while the
+	///other systems simulate. Drawing only uses the packet and the device.
+	///While the render thread runs it is the only user of the device.
 	///Provides Sprite and Camera GameComponents.
+	///Headless builds use the implementation in NullGraphics.cpp, which
+	///keeps the components and the debug line buffers but draws nothing.
 	class Graphics : public ISystem
 	{
 	public:
-		///Update by rendering the scene
+		///Update by drawing the frame published by the last EndFrame
 		void Update(float dt);
+		///Publish the frame by copying the sprites, particles and debug lines
+		virtual void EndFrame();
 		virtual std::string GetName(){return "Graphics";}
+		///Update only draws the published packet, which nothing else uses,
+		///so it can run alongside any system.
+		virtual unsigned GetReads(){return 0;}
+		virtual unsigned GetWrites(){return 0;}
+		virtual bool RunsOnMainThread(){return true;}
 		//Initialize the Direct3D system.
 		Graphics();
 		~Graphics();
 		//Get a texture asset. Will return null if texture is not loaded
 		IDirect3DTexture9* GetTexture(std::string);
 		Vec2 ScreenToWorldSpace(Vec2);
-		void SetWindwProperties(HWND hWnd,int screenWidth,int screenHeight);
+		void SetWindwProperties(void* hWnd,int screenWidth,int screenHeight);
 	private:
 		void Initialize();
 		//Create a vertex buffer for our sprites.
@@ -52,20 +86,40 @@ namespace Framework
 		void SetupMatrices();
 		//Load a effect file
 		bool LoadEffect(int index,const std::string& filename);
+		//Copy the sprites, particles and debug lines into a packet
+		void ExtractFrame(FramePacket& packet);
+		//Draw a packet and present it
+		void RenderFrame(FramePacket& packet);
+		static unsigned RenderThreadMain(void* data);
+		void StopRenderThread();
 		//Draw Debug Data
-		void DrawDebugInfo();
+		void DrawDebugInfo(FramePacket& packet);
 		//Draw the world
-		void DrawWorld();
-		//TODO: Need to handle device lost / device reset
+		void DrawWorld(FramePacket& packet);
+		//Draw the granular particles in batches of ParticlesPerDraw
+		void DrawParticles(FramePacket& packet);
+		//Run on the window thread (WindowsSystem::RunOnWindowThread)
+		static void CreateDevice(void* data);
+		static void ReleaseDevice(void* data);
+		static void ResetDevice(void* data);
+		//The device is lost when the window loses a full screen mode or
+		//the desktop is locked. Once it can be reset the effects are
+		//released (DeviceLost), the device is reset on the window thread
+		//and everything it forgot is restored (DeviceReset). Textures and
+		//the quad are in the managed pool and survive on their own.
+		//Returns true if the device can draw.
+		bool RestoreDevice();
 		void DeviceLost();
 		void DeviceReset();
+		void SetRenderStates();
 
 
 
 	public:
 		//The active camera
 		Camera*				CurrentCamera;
-		HWND HWnd;
+		//The window as an HWND
+		void* HWnd;
 		int ScreenWidth;
 		int ScreenHeight;
 
@@ -88,11 +142,37 @@ namespace Framework
 		Mat4 ProjMatrix;
 		Mat4 ViewMatrix;
 		Mat4 ViewProjMatrix;
+		//Inverted once a frame for ScreenToWorldSpace
+		Mat4 InverseViewProjMatrix;
 
-		//Stored copy of the DirectX Presentation Parameters
-		D3DPRESENT_PARAMETERS PresentParameters;
 		Vec2 SurfaceSize;
 		ObjectLinkList<Sprite> SpriteList;
+		//Vertices for the particle batch, kept to reuse the memory
+		std::vector<Vertex2D> ParticleVertices;
+		//Most particles drawn by one call, kept under the device's
+		//MaxPrimitiveCount
+		unsigned ParticlesPerDraw;
+
+		///Render on a separate thread. If false frames are rendered
+		///during Update on the main thread.
+		bool Pipelined;
+
+	private:
+		//One packet is filled while the other is rendered
+		FramePacket Packets[2];
+		unsigned WritePacket;
+		//Packet published by EndFrame for the next Update, NULL once drawn
+		FramePacket * PublishedPacket;
+		Thread RenderThread;
+		ThreadEvent RenderStart;
+		ThreadEvent RenderDone;
+		//Packet the render thread is drawing, NULL when it is idle
+		FramePacket * RenderingPacket;
+		bool RenderQuit;
+		//Set when Present reports the device lost, cleared once reset
+		bool DeviceIsLost;
+		//Result of Reset on the window thread
+		bool ResetSucceeded;
 	};
 
 	//A global pointer to the Graphics system, used to access it anywhere.
@@ -0,0 +1,230 @@
+///////////////////////////////////////////////////////////////////////////////////////
+//
+//	HeadlessMain
+//	Entry point for headless builds (see Platform.h). Runs the whole engine
+//	without a window or a renderer for a fixed number of frames, as fast as
+//	the CPU allows, then reports how long it took.
+//
+//	Usage: run from the Assets directory
+//		GameEngine [frames] [level file]
+//		GameEngine replay <recording> [level file]
+//		GameEngine worlds <count> [frames]
+//		GameEngine solvers
+//		GameEngine granular [particles] [steps]
+//		GameEngine reorder [columns] [rows]
+//	The defaults, 1000 frames of Objects\TestLevel.txt, are the smoke test.
+//	A replay runs every frame of a recording made with "record" on windows,
+//	with the recorded input and time steps, starting on the recorded level.
+//	"worlds" adds that many sandbox physics worlds, stepped in parallel by a
+//	WorldScheduler alongside the level, to measure server throughput.
+//	"solvers" prints the SolverBenchmark comparison instead of running frames.
+//	"granular" times the GranularBenchmark against a 60 Hz frame, by default
+//	100,000 particles for 120 steps.
+//	"reorder" times the ReorderBenchmark pile, by default 100 by 40 balls,
+//	with and without sorting the body list.
+//	
+//	Authors: Chris Peters
+//	Copyright 2011, Digipen Institute of Technology
+//
+///////////////////////////////////////////////////////////////////////////////////////
+
+#include "Precompiled.h"
+
+#ifdef G_HEADLESS
+
+#include "Core.h"
+#include "NullPlatform.h"
+#include "Graphics.h"
+#include "Physics.h"
+#include "GameLogic.h"
+#include "WorldScheduler.h"
+#include "SolverBenchmark.h"
+#include "GranularBenchmark.h"
+#include "ReorderBenchmark.h"
+#include "InputRecording.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstdarg>
+#include <cstring>
+
+using namespace Framework;
+
+//Every frame advances the game by the same time a window
+//running at 60 frames per second would
+const float FrameTime = 1.0f / 60.0f;
+
+//Fill a sandbox world with a floor and a pile of boxes and balls
+static void BuildSandbox(Physics* world)
+{
+	world->CreateObject("Objects\\Ground.txt", Vec2(0,-280), 0.0f);
+	for(int y=0;y<8;++y)
+	{
+		for(int x=0;x<8;++x)
+		{
+			const char * file = (x + y) % 2 ? "Objects\\Ball.txt" : "Objects\\Box.txt";
+			world->CreateObject(file, Vec2(x * 64.0f - 224.0f, y * 64.0f - 200.0f), 0.0f);
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int frameCount = 1000;
+	std::string levelFile;
+	InputPlayback playback;
+	bool replay = argc > 1 && strcmp(argv[1], "replay") == 0;
+	int worldCount = 0;
+	bool solvers = argc > 1 && strcmp(argv[1], "solvers") == 0;
+	bool granular = argc > 1 && strcmp(argv[1], "granular") == 0;
+	bool reorder = argc > 1 && strcmp(argv[1], "reorder") == 0;
+	GranularBenchmark granularBenchmark;
+
+	if( replay )
+	{
+		if( argc < 3 || !playback.Open(argv[2]) )
+		{
+			fprintf(stderr, "Could not read the recording %s\n", argc < 3 ? "" : argv[2]);
+			return 1;
+		}
+		levelFile = argc > 3 ? argv[3] : playback.GetLevelFile();
+	}
+	else if( argc > 2 && strcmp(argv[1], "worlds") == 0 )
+	{
+		worldCount = atoi(argv[2]);
+		if( argc > 3 )
+			frameCount = atoi(argv[3]);
+	}
+	else if( solvers || reorder )
+	{
+		frameCount = 0;
+	}
+	else if( granular )
+	{
+		frameCount = 0;
+		if( argc > 2 )
+			granularBenchmark.ParticleCount = atoi(argv[2]);
+		if( argc > 3 )
+			granularBenchmark.StepCount = atoi(argv[3]);
+	}
+	else
+	{
+		if( argc > 1 )
+			frameCount = atoi(argv[1]);
+		if( argc > 2 )
+			levelFile = argv[2];
+	}
+
+	CoreEngine* engine = new CoreEngine();
+
+	//The null systems take the place of WindowsSystem and the Direct3D Graphics
+	NullPlatform* platform = new NullPlatform();
+	GameLogic* logic = new GameLogic();
+	if( !levelFile.empty() )
+		logic->LevelFile = levelFile;
+
+	engine->AddSystem(platform);
+	engine->AddSystem(new GameObjectFactory());
+	engine->AddSystem(new Graphics());
+	engine->AddSystem(new Physics());
+	engine->AddSystem(logic);
+	WorldScheduler* scheduler = NULL;
+	if( worldCount > 0 )
+	{
+		scheduler = new WorldScheduler();
+		engine->AddSystem(scheduler);
+	}
+
+	engine->Initialize();
+
+	for(int i=0;i<worldCount;++i)
+		BuildSandbox(scheduler->CreateWorld());
+
+	if( solvers )
+	{
+		SolverBenchmark benchmark;
+		benchmark.RunComparison();
+	}
+
+	if( granular )
+		granularBenchmark.RunAndPrint();
+
+	if( reorder )
+	{
+		ReorderBenchmark benchmark;
+		if( argc > 2 )
+			benchmark.Columns = atoi(argv[2]);
+		if( argc > 3 )
+			benchmark.Rows = atoi(argv[3]);
+		benchmark.RunComparison();
+	}
+
+	TimeNs start = GetTimeNs();
+	if( replay )
+	{
+		//The platform sends each frame's recorded input as it updates
+		platform->Playback = &playback;
+		float dt;
+		for(frameCount=0;playback.NextFrame(dt);++frameCount)
+		{
+			engine->Frame(dt);
+		}
+		platform->Playback = NULL;
+	}
+	else
+	{
+		for(int i=0;i<frameCount;++i)
+		{
+			engine->Frame(FrameTime);
+		}
+	}
+	TimeNs elapsed = GetTimeNs() - start;
+
+	printf("%d frames in %.3f s, %.3f ms per frame\n", frameCount, NsToSeconds(elapsed),
+		frameCount > 0 ? NsToMilliseconds(elapsed) / frameCount : 0.0f);
+	engine->PrintFrameTimes();
+
+	//Delete all the game objects
+	FACTORY->DestroyAllObjects();
+
+	//Delete all the systems
+	engine->DestroySystems();
+
+	//Delete the engine itself
+	delete engine;
+
+	return 0;
+}
+
+void DebugPrintHandler( const char * msg , ... )
+{
+	va_list args;
+	va_start(args, msg);
+	vprintf(msg, args);
+	va_end(args);
+	printf("\n");
+}
+
+//A basic error output function
+bool SignalErrorHandler(const char * exp, const char * file, int line, const char * msg , ...)
+{
+	//Print the file and line in the format compilers use
+	fprintf(stderr, "%s:%d: error: ", file, line);
+	if (msg != NULL)
+	{
+		va_list args;
+		va_start(args, msg);
+		vfprintf(stderr, msg, args);
+		va_end(args);
+	}
+	else
+	{
+		fprintf(stderr, "No Error Message");
+	}
+	//The check that failed, to tell apart several errors on one line
+	fprintf(stderr, " (%s)\n", exp);
+
+	//Stop so a soak test never runs on in a broken state
+	return true;
+}
+
+#endif
@@ -0,0 +1,148 @@
+///////////////////////////////////////////////////////////////////////////////////////
+///
+///	\file Input.h
+///	Input messages and queries provided by every platform system, so game code
+///	does not depend on the windows system.
+///
+///	Authors: Benjamin Ellinger, Chris Peters
+///	Copyright 2010, Digipen Institute of Technology
+///
+///////////////////////////////////////////////////////////////////////////////////////
+#pragma once //Makes sure this header is only included once
+
+#include "Engine.h"
+#include "FrameTiming.h"
+
+namespace Framework
+{
+	///Message signaling that a key is pressed.
+	class MessageCharacterKey : public Message
+	{
+	public:
+		MessageCharacterKey() : Message(Mid::CharacterKey) , Time(0) {};	
+		int character;
+		///When the key was pressed (GetTimeNs), zero if unknown.
+		TimeNs Time;
+	};
+
+	///Message signaling that a mouse button state has changed.
+	class MouseButton: public Message
+	{
+	public:
+		enum MouseButtonIndexId
+		{
+			LeftMouse,
+			RightMouse
+		};
+		MouseButton(MouseButtonIndexId button,bool state,Vec2 position) 
+			: Message(Mid::MouseButton) ,  MouseButtonIndex(button) , ButtonIsPressed(state), MousePosition(position), Time(0) {};
+
+		MouseButtonIndexId MouseButtonIndex;
+		bool ButtonIsPressed;
+		Vec2 MousePosition;
+		///When the button changed (GetTimeNs), zero if unknown.
+		TimeNs Time;
+	};
+
+	///Message signaling that the mouse has moved. Sent at most once a frame
+	///with the latest position.
+	class MouseMove: public Message
+	{
+	public:
+		MouseMove(Vec2 position) : Message(Mid::MouseMove) , MousePosition(position), Time(0) {};	
+		Vec2 MousePosition;
+		///When the mouse reached the position (GetTimeNs), zero if unknown.
+		TimeNs Time;
+	};
+
+	///Message signaling that a file was dropped onto the window.
+	class FileDrop: public Message
+	{
+	public:
+		FileDrop(std::string filename) : Message(Mid::FileDrop) , FileName(filename) {};	
+		std::string FileName;
+	};
+
+	///Bits for each of the held keys below, used to store them all in one value.
+	namespace HeldKey
+	{
+		enum HeldKeyFlags
+		{
+			Shift = 1 << 0,
+			Ctrl = 1 << 1,
+			Alt = 1 << 2,
+			Up = 1 << 3,
+			Down = 1 << 4,
+			Left = 1 << 5,
+			Right = 1 << 6
+		};
+	}
+
+	///The input of one frame. The platform system folds the raw events into
+	///it as they arrive, so any number of mouse moves in a frame cost one
+	///position update, and the game reads it during the frame instead of
+	///reacting to every event. Edges are cleared when the next frame starts.
+	struct InputState
+	{
+		InputState() : MousePosition(0,0), MouseMoved(false), ButtonsHeld(0),
+			ButtonsPressed(0), ButtonsReleased(0), HeldKeys(0) {};
+
+		///Latest mouse position in screen pixels.
+		Vec2 MousePosition;
+		///The mouse moved this frame.
+		bool MouseMoved;
+		///One bit per MouseButtonIndexId. A button clicked within one frame
+		///is both pressed and released but no longer held.
+		unsigned ButtonsHeld;
+		unsigned ButtonsPressed;
+		unsigned ButtonsReleased;
+		///HeldKey flags.
+		unsigned HeldKeys;
+
+		bool IsHeld(MouseButton::MouseButtonIndexId button) const {return (ButtonsHeld & (1 << button)) != 0;}
+		bool WasPressed(MouseButton::MouseButtonIndexId button) const {return (ButtonsPressed & (1 << button)) != 0;}
+		bool WasReleased(MouseButton::MouseButtonIndexId button) const {return (ButtonsReleased & (1 << button)) != 0;}
+
+		///Clear the edges before gathering a new frame.
+		void NewFrame()
+		{
+			MouseMoved = false;
+			ButtonsPressed = 0;
+			ButtonsReleased = 0;
+		}
+
+		void MoveMouse(Vec2 position)
+		{
+			MousePosition = position;
+			MouseMoved = true;
+		}
+
+		void SetButton(MouseButton::MouseButtonIndexId button, bool pressed)
+		{
+			unsigned bit = 1 << button;
+			if( pressed )
+			{
+				ButtonsHeld |= bit;
+				ButtonsPressed |= bit;
+			}
+			else
+			{
+				ButtonsHeld &= ~bit;
+				ButtonsReleased |= bit;
+			}
+		}
+	};
+
+	///Input of the current frame, provided by the platform system.
+	const InputState& GetInput();
+
+	///Keys held down this frame. The null platform only reports keys from
+	///a playback.
+	inline bool IsShiftHeld(){return (GetInput().HeldKeys & HeldKey::Shift) != 0;}
+	inline bool IsCtrlHeld(){return (GetInput().HeldKeys & HeldKey::Ctrl) != 0;}
+	inline bool IsAltHeld(){return (GetInput().HeldKeys & HeldKey::Alt) != 0;}
+	inline bool IsUpHeld(){return (GetInput().HeldKeys & HeldKey::Up) != 0;}
+	inline bool IsDownHeld(){return (GetInput().HeldKeys & HeldKey::Down) != 0;}
+	inline bool IsLeftHeld(){return (GetInput().HeldKeys & HeldKey::Left) != 0;}
+	inline bool IsRightHeld(){return (GetInput().HeldKeys & HeldKey::Right) != 0;}
+}
@@ -0,0 +1,164 @@
+///////////////////////////////////////////////////////////////////////////////////////
+//
+//	InputQueue.cpp
+//
+//	Authors: Chris Peters
+//	Copyright 2011, Digipen Institute of Technology
+//
+///////////////////////////////////////////////////////////////////////////////////////
+#include "Precompiled.h"
+#include "InputQueue.h"
+#include "Threading.h"
+#include "Core.h"
+
+namespace Framework
+{
+	InputQueue::InputQueue()
+	{
+		Head = 0;
+		Tail = 0;
+		MoveVersion = 0;
+		LastIsMove = false;
+		Dropped = 0;
+	}
+
+	InputQueue::~InputQueue()
+	{
+		//Free the file names of events that were never delivered
+		for(unsigned i=Head;i!=Tail;++i)
+			delete Events[i & (Capacity - 1)].FileName;
+	}
+
+	bool InputQueue::Push(const InputEvent& event)
+	{
+		unsigned tail = Tail;
+
+		//Fold the move into the last one while the consumer has not taken it
+		if( event.Type == InputEvent::Move && LastIsMove && Head != tail )
+		{
+			InputEvent& last = Events[(tail - 1) & (Capacity - 1)];
+			MoveVersion = MoveVersion + 1;
+			MemoryFence();
+			last.Position = event.Position;
+			last.Time = event.Time;
+			MemoryFence();
+			MoveVersion = MoveVersion + 1;
+			MemoryFence();
+			//The consumer frees the slot before rereading it. So either it
+			//rereads after this and sees the new position, or the slot shows
+			//as taken here and the move is pushed as an event of its own.
+			if( Head != tail )
+				return true;
+		}
+
+		//Only Quit may take the last slot
+		unsigned capacity = event.Type == InputEvent::Quit ? Capacity : Capacity - 1;
+		if( tail - Head >= capacity )
+		{
+			delete event.FileName;
+			++Dropped;
+			return false;
+		}
+
+		Events[tail & (Capacity - 1)] = event;
+		//The event must be complete before the consumer can see it
+		MemoryFence();
+		Tail = tail + 1;
+		LastIsMove = event.Type == InputEvent::Move;
+		return true;
+	}
+
+	InputEvent InputQueue::ReadEvent(unsigned index)
+	{
+		for(;;)
+		{
+			unsigned version = MoveVersion;
+			MemoryFence();
+			InputEvent event = Events[index & (Capacity - 1)];
+			MemoryFence();
+			if( (version & 1) == 0 && version == MoveVersion )
+				return event;
+		}
+	}
+
+	void InputQueue::Deliver(InputState& input, TimeNs until)
+	{
+		bool moved = false;
+		TimeNs moveTime = 0;
+
+		unsigned head = Head;
+		while( head != Tail )
+		{
+			//Read the event only after seeing the tail that published it
+			MemoryFence();
+			InputEvent event = ReadEvent(head);
+			if( event.Time > until )
+				break;
+
+			//Done with the slot, let the producer reuse it
+			++head;
+			MemoryFence();
+			Head = head;
+
+			//A later move may have been folded in before the producer saw
+			//the slot taken. It is delivered now even if it came after until.
+			if( event.Type == InputEvent::Move )
+			{
+				MemoryFence();
+				event = ReadEvent(head - 1);
+			}
+
+			switch( event.Type )
+			{
+			case InputEvent::Key:
+				{
+					MessageCharacterKey key;
+					key.character = event.Value;
+					key.Time = event.Time;
+					CORE->QueueMessage(key);
+					break;
+				}
+			case InputEvent::Button:
+				{
+					MouseButton m((MouseButton::MouseButtonIndexId)event.Value, event.Pressed, event.Position);
+					m.Time = event.Time;
+					input.SetButton(m.MouseButtonIndex, m.ButtonIsPressed);
+					CORE->QueueMessage(m);
+					break;
+				}
+			case InputEvent::Move:
+				{
+					input.MoveMouse(event.Position);
+					moved = true;
+					moveTime = event.Time;
+					break;
+				}
+			case InputEvent::Keys:
+				{
+					input.HeldKeys = event.Value;
+					break;
+				}
+			case InputEvent::Drop:
+				{
+					FileDrop drop(*event.FileName);
+					delete event.FileName;
+					CORE->QueueMessage(drop);
+					break;
+				}
+			case InputEvent::Quit:
+				{
+					MessageQuit q;
+					CORE->QueueMessage(q);
+					break;
+				}
+			}
+		}
+
+		if( moved )
+		{
+			MouseMove m(input.MousePosition);
+			m.Time = moveTime;
+			CORE->QueueMessage(m);
+		}
+	}
+}
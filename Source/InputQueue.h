@@ -0,0 +1,103 @@
+///////////////////////////////////////////////////////////////////////////////////////
+///
+///	\file InputQueue.h
+///	Lock free queue that carries timestamped input events from the thread
+///	that reads them from the operating system to the main thread.
+///
+///	Authors: Chris Peters
+///	Copyright 2011, Digipen Institute of Technology
+///
+///////////////////////////////////////////////////////////////////////////////////////
+#pragma once //Makes sure this header is only included once
+
+#include "Input.h"
+#include "FrameTiming.h"
+
+namespace Framework
+{
+	///One input event, stamped with the time it was read.
+	struct InputEvent
+	{
+		enum EventType
+		{
+			///Value is the character.
+			Key,
+			///Value is the MouseButtonIndexId.
+			Button,
+			Move,
+			///Value is the HeldKey flags of all the keys held from now on.
+			Keys,
+			Drop,
+			Quit
+		};
+
+		InputEvent() : Type(Quit), Time(0), Value(0), Pressed(false), Position(0,0), FileName(NULL) {};
+		InputEvent(EventType type, TimeNs time) : Type(type), Time(time), Value(0), Pressed(false), Position(0,0), FileName(NULL) {};
+
+		EventType Type;
+		///GetTimeNs when the event was read, or zero to deliver it right away.
+		TimeNs Time;
+		int Value;
+		bool Pressed;
+		///Mouse position in screen pixels for Button and Move.
+		Vec2 Position;
+		///Dropped file. Allocated with new by the producer and
+		///owned by the queue once pushed.
+		std::string * FileName;
+	};
+
+	///Single producer, single consumer ring of input events. The platform's
+	///input thread pushes events as it reads them and the main thread
+	///delivers them once a frame, so neither ever waits for the other.
+	///Each side only writes its own index and a memory fence orders the
+	///event data against the index that publishes or frees it.
+	///A move pushed right after a move that is still waiting updates that
+	///one in place, so a moving mouse can not flood the queue. The update
+	///is bracketed by a version the consumer checks while copying.
+	///Any thread can be the producer, so the delivery can be driven from a
+	///test or a playback without a window.
+	class InputQueue
+	{
+	public:
+		///Events that can be waiting at once. A power of two. The last
+		///slot is kept for Quit, so a flood of input can not lose it.
+		enum { Capacity = 1024 };
+
+		InputQueue();
+		~InputQueue();
+
+		///Producer only. False if the queue is full, in which case the
+		///event is dropped and its file name freed. A Move may be folded
+		///into the last event instead (see above).
+		bool Push(const InputEvent& event);
+		///Producer only. True if a Push of anything but Quit would fail.
+		bool IsFull(){return Tail - Head >= Capacity - 1;}
+
+		///Consumer only. Fold the events read before the time into the
+		///input state and queue their messages in order, to be sent at the
+		///end of the frame (CoreEngine::QueueMessage). Later events
+		///wait for the next frame. All the mouse moves delivered together
+		///are sent as one MouseMove with the latest position.
+		void Deliver(InputState& input, TimeNs until);
+
+		///Events lost because the queue was full.
+		unsigned GetDroppedCount(){return Dropped;}
+
+	private:
+		InputQueue(const InputQueue&);
+		InputQueue& operator=(const InputQueue&);
+		//Copy an event that a move may be folded into meanwhile
+		InputEvent ReadEvent(unsigned index);
+
+		InputEvent Events[Capacity];
+		//Next event to deliver, only written by the consumer
+		volatile unsigned Head;
+		//Next free slot, only written by the producer
+		volatile unsigned Tail;
+		//Odd while the producer folds a move into the last event
+		volatile unsigned MoveVersion;
+		//The last event pushed is a move, only used by the producer
+		bool LastIsMove;
+		unsigned Dropped;
+	};
+}
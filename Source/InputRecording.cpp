@@ -0,0 +1,317 @@
+///////////////////////////////////////////////////////////////////////////////////////
+//
+//	InputRecording.cpp
+//
+//	Authors: Chris Peters
+//	Copyright 2011, Digipen Institute of Technology
+//
+///////////////////////////////////////////////////////////////////////////////////////
+#include "Precompiled.h"
+#include "InputRecording.h"
+#include "InputQueue.h"
+#include "Core.h"
+#include <algorithm>
+
+namespace Framework
+{
+	using namespace InputRecord;
+
+	//Size at which buffered frames are written to the file
+	const unsigned FlushSize = 64 * 1024;
+
+	InputRecorder::InputRecorder()
+	{
+		File = NULL;
+		FrameTime = 0.0f;
+		EventCount = 0;
+	}
+
+	InputRecorder::~InputRecorder()
+	{
+		Close();
+	}
+
+	bool InputRecorder::Open(const std::string& filename, const std::string& levelFile)
+	{
+		Close();
+		File = fopen(filename.c_str(), "wb");
+		if( File == NULL )
+			return false;
+
+		Write(Buffer, Magic);
+		Write(Buffer, Version);
+		WriteString(Buffer, levelFile);
+		return true;
+	}
+
+	void InputRecorder::Close()
+	{
+		if( File == NULL )
+			return;
+		Flush();
+		fclose(File);
+		File = NULL;
+	}
+
+	void InputRecorder::Initialize()
+	{
+		CORE->Subscribe(Mid::CharacterKey, this);
+		CORE->Subscribe(Mid::MouseButton, this);
+		CORE->Subscribe(Mid::MouseMove, this);
+		CORE->Subscribe(Mid::FileDrop, this);
+	}
+
+	void InputRecorder::Update(float dt)
+	{
+		FrameTime = dt;
+	}
+
+	void InputRecorder::EndFrame()
+	{
+		if( File == NULL )
+			return;
+
+		Write(Buffer, FrameTime);
+		Write(Buffer, (unsigned char)GetInput().HeldKeys);
+		Write(Buffer, (unsigned short)EventCount);
+		Buffer.insert(Buffer.end(), Events.begin(), Events.end());
+		Events.clear();
+		EventCount = 0;
+
+		if( Buffer.size() >= FlushSize )
+			Flush();
+	}
+
+	void InputRecorder::SendMessage(Message* message)
+	{
+		//The count is stored in 16 bits, more than that in a frame is dropped
+		if( File == NULL || EventCount == 0xFFFF )
+			return;
+
+		switch( message->MessageId )
+		{
+		case Mid::CharacterKey:
+			{
+				MessageCharacterKey * key = (MessageCharacterKey*)message;
+				Write(Events, (unsigned char)EventKey);
+				Write(Events, key->character);
+				break;
+			}
+		case Mid::MouseButton:
+			{
+				MouseButton * button = (MouseButton*)message;
+				Write(Events, (unsigned char)EventMouseButton);
+				Write(Events, (unsigned char)button->MouseButtonIndex);
+				Write(Events, (unsigned char)button->ButtonIsPressed);
+				Write(Events, button->MousePosition.x);
+				Write(Events, button->MousePosition.y);
+				break;
+			}
+		case Mid::MouseMove:
+			{
+				MouseMove * move = (MouseMove*)message;
+				Write(Events, (unsigned char)EventMouseMove);
+				Write(Events, move->MousePosition.x);
+				Write(Events, move->MousePosition.y);
+				break;
+			}
+		case Mid::FileDrop:
+			{
+				FileDrop * drop = (FileDrop*)message;
+				Write(Events, (unsigned char)EventFileDrop);
+				WriteString(Events, drop->FileName);
+				break;
+			}
+		default:
+			return;
+		}
+		++EventCount;
+	}
+
+	template<typename T>
+	void InputRecorder::Write(std::vector<unsigned char>& buffer, const T& value)
+	{
+		const unsigned char * bytes = (const unsigned char*)&value;
+		buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+	}
+
+	void InputRecorder::WriteString(std::vector<unsigned char>& buffer, const std::string& text)
+	{
+		unsigned short length = (unsigned short)std::min<std::size_t>(text.size(), 0xFFFF);
+		Write(buffer, length);
+		buffer.insert(buffer.end(), text.begin(), text.begin() + length);
+	}
+
+	void InputRecorder::Flush()
+	{
+		if( !Buffer.empty() )
+			fwrite(&Buffer[0], 1, Buffer.size(), File);
+		fflush(File);
+		Buffer.clear();
+	}
+
+	InputPlayback::InputPlayback()
+	{
+		Position = 0;
+		FrameEvents = 0;
+		FrameEventCount = 0;
+		QueuedCount = 0;
+		HeldKeys = 0;
+	}
+
+	bool InputPlayback::Open(const std::string& filename)
+	{
+		Data.clear();
+		Position = 0;
+		FrameEventCount = 0;
+		HeldKeys = 0;
+
+		FILE * file = fopen(filename.c_str(), "rb");
+		if( file == NULL )
+			return false;
+		unsigned char block[4096];
+		std::size_t count;
+		while( (count = fread(block, 1, sizeof(block), file)) > 0 )
+			Data.insert(Data.end(), block, block + count);
+		fclose(file);
+
+		unsigned magic = 0;
+		unsigned version = 0;
+		if( !Read(magic) || !Read(version) || magic != Magic || version != Version )
+			return false;
+		return ReadString(LevelFile);
+	}
+
+	bool InputPlayback::NextFrame(float& dt)
+	{
+		unsigned char heldKeys;
+		unsigned short eventCount;
+		if( !Read(dt) || !Read(heldKeys) || !Read(eventCount) )
+			return false;
+
+		//Step over the events to the next frame. A recording cut off
+		//part way through a frame ends before that frame.
+		unsigned frameEvents = Position;
+		for(unsigned i=0;i<eventCount;++i)
+		{
+			unsigned char type;
+			if( !Read(type) )
+				return false;
+
+			unsigned size = 0;
+			switch( type )
+			{
+			case EventKey: size = sizeof(int); break;
+			case EventMouseButton: size = 2 + 2 * sizeof(float); break;
+			case EventMouseMove: size = 2 * sizeof(float); break;
+			case EventFileDrop:
+				{
+					unsigned short length;
+					if( !Read(length) )
+						return false;
+					size = length;
+					break;
+				}
+			default:
+				return false;
+			}
+			if( Position + size > Data.size() )
+				return false;
+			Position += size;
+		}
+
+		FrameEvents = frameEvents;
+		FrameEventCount = eventCount;
+		QueuedCount = 0;
+		HeldKeys = heldKeys;
+		return true;
+	}
+
+	bool InputPlayback::QueueFrame(InputQueue& queue)
+	{
+		//NextFrame checked the events so they are read without checks here.
+		//The locals still start zeroed so nothing reads as uninitialized.
+		unsigned framePosition = Position;
+		Position = FrameEvents;
+
+		//The held keys go first, then the events in recorded order
+		for(;QueuedCount < FrameEventCount + 1 && !queue.IsFull();++QueuedCount)
+		{
+			if( QueuedCount == 0 )
+			{
+				InputEvent keys(InputEvent::Keys, 0);
+				keys.Value = HeldKeys;
+				queue.Push(keys);
+				continue;
+			}
+
+			unsigned char type = 0;
+			Read(type);
+			switch( type )
+			{
+			case EventKey:
+				{
+					InputEvent e(InputEvent::Key, 0);
+					Read(e.Value);
+					queue.Push(e);
+					break;
+				}
+			case EventMouseButton:
+				{
+					unsigned char button = 0;
+					unsigned char pressed = 0;
+					InputEvent e(InputEvent::Button, 0);
+					Read(button);
+					Read(pressed);
+					Read(e.Position.x);
+					Read(e.Position.y);
+					e.Value = button;
+					e.Pressed = pressed != 0;
+					queue.Push(e);
+					break;
+				}
+			case EventMouseMove:
+				{
+					InputEvent e(InputEvent::Move, 0);
+					Read(e.Position.x);
+					Read(e.Position.y);
+					queue.Push(e);
+					break;
+				}
+			case EventFileDrop:
+				{
+					InputEvent e(InputEvent::Drop, 0);
+					e.FileName = new std::string();
+					ReadString(*e.FileName);
+					queue.Push(e);
+					break;
+				}
+			}
+		}
+
+		//Remember where to carry on if the queue filled up
+		FrameEvents = Position;
+		Position = framePosition;
+		return QueuedCount == FrameEventCount + 1;
+	}
+
+	template<typename T>
+	bool InputPlayback::Read(T& value)
+	{
+		if( Position + sizeof(T) > Data.size() )
+			return false;
+		memcpy(&value, &Data[Position], sizeof(T));
+		Position += sizeof(T);
+		return true;
+	}
+
+	bool InputPlayback::ReadString(std::string& text)
+	{
+		unsigned short length;
+		if( !Read(length) || Position + length > Data.size() )
+			return false;
+		text.assign(Data.begin() + Position, Data.begin() + Position + length);
+		Position += length;
+		return true;
+	}
+}
@@ -0,0 +1,118 @@
+///////////////////////////////////////////////////////////////////////////////////////
+///
+///	\file InputRecording.h
+///	Records the input of a play session to a file and plays it back, so a
+///	session can be run again headless as a repeatable benchmark.
+///
+///	File layout, little endian, no padding:
+///		Header:	unsigned Magic, unsigned Version,
+///				unsigned short level name length, level name characters
+///		Frames until the end of the file:
+///				float dt, unsigned char held keys (HeldKey flags),
+///				unsigned short event count, events
+///		Event:	unsigned char EventType, then
+///				EventKey:			int character
+///				EventMouseButton:	unsigned char button, unsigned char pressed, float x, float y
+///				EventMouseMove:		float x, float y
+///				EventFileDrop:		unsigned short length, characters
+///	A frame without input takes 7 bytes.
+///
+///	Authors: Chris Peters
+///	Copyright 2011, Digipen Institute of Technology
+///
+///////////////////////////////////////////////////////////////////////////////////////
+#pragma once //Makes sure this header is only included once
+
+#include "Engine.h"
+#include <cstdio>
+
+namespace Framework
+{
+	class InputQueue;
+
+	namespace InputRecord
+	{
+		///'GEIR' in memory on little endian machines.
+		const unsigned Magic = 0x52494547;
+		const unsigned Version = 1;
+
+		enum EventType
+		{
+			EventKey,
+			EventMouseButton,
+			EventMouseMove,
+			EventFileDrop
+		};
+	}
+
+	///Writes every input message and the frame time of each frame to a
+	///file. The platform queues the messages of a frame's input, so the
+	///frame is written by EndFrame once they have been sent.
+	class InputRecorder : public ISystem
+	{
+	public:
+		InputRecorder();
+		~InputRecorder();
+		///Start a new recording of a session that begins with the level.
+		bool Open(const std::string& filename, const std::string& levelFile);
+		///Write everything still buffered and close the file.
+		void Close();
+
+		virtual void Initialize();
+		///Keep the frame's time step for its record.
+		virtual void Update(float dt);
+		///Write the frame's record.
+		virtual void EndFrame();
+		virtual void SendMessage(Message* message);
+		virtual std::string GetName(){return "InputRecorder";}
+		virtual unsigned GetReads(){return 0;}
+		virtual unsigned GetWrites(){return 0;}
+
+	private:
+		template<typename T>
+		void Write(std::vector<unsigned char>& buffer, const T& value);
+		void WriteString(std::vector<unsigned char>& buffer, const std::string& text);
+		void Flush();
+		FILE * File;
+		//Time step of the frame being recorded
+		float FrameTime;
+		//Events received since the last frame was written
+		std::vector<unsigned char> Events;
+		unsigned EventCount;
+		//Frames are written to the file in large blocks
+		std::vector<unsigned char> Buffer;
+	};
+
+	///Reads a recording made by InputRecorder one frame at a time.
+	class InputPlayback
+	{
+	public:
+		InputPlayback();
+		///Load the whole recording. False if it is missing or not a recording.
+		bool Open(const std::string& filename);
+		///Level the recorded session started with.
+		const std::string& GetLevelFile(){return LevelFile;}
+		///Move to the next frame and get its time step. False at the end.
+		bool NextFrame(float& dt);
+		///Keys held during the current frame as HeldKey flags.
+		unsigned GetHeldKeys(){return HeldKeys;}
+		///Push the current frame's held keys and events into the queue the
+		///platform delivers from. False if the queue filled up first, in
+		///which case the next call pushes the rest.
+		bool QueueFrame(InputQueue& queue);
+
+	private:
+		template<typename T>
+		bool Read(T& value);
+		bool ReadString(std::string& text);
+		std::vector<unsigned char> Data;
+		unsigned Position;
+		//Next event of the current frame to queue, the frame's event
+		//count and how many of them and the held keys have been queued
+		unsigned FrameEvents;
+		unsigned FrameEventCount;
+		unsigned QueuedCount;
+		unsigned HeldKeys;
+		std::string LevelFile;
+	};
+}
@@ -201,26 +201,103 @@ namespace Framework
     return true;
   }
 
+  bool SegmentCircle(Vec2Param segmentStart, Vec2Param segmentEnd,
+                     Vec2Param circleCenter, float circleRadius)
+  {
+    //The segment touches the circle if the closest point on the
+    //segment to the center is within the radius
+    Vec2 closestPoint = circleCenter;
+    if(Dot(segmentEnd - segmentStart, segmentEnd - segmentStart) > 0.0f)
+      ClosestPointOnSegmentToPoint(segmentStart, segmentEnd, &closestPoint);
+    else
+      closestPoint = segmentStart;
+
+    Vec2 delta = circleCenter - closestPoint;
+    return Dot(delta, delta) <= circleRadius * circleRadius;
+  }
+
+  bool SegmentBox(Vec2Param segmentStart, Vec2Param segmentEnd,
+                  Vec2Param boxCenter, Vec2Param boxHalfExtents,
+                  const Vec2* boxAxes)
+  {
+    //Bring the segment into the space of the box and clip it against
+    //the slab of each axis. If anything of the segment is left over it
+    //passes through the box.
+    Vec2 start = segmentStart - boxCenter;
+    Vec2 direction = segmentEnd - segmentStart;
+    float tMin = 0.0f;
+    float tMax = 1.0f;
+
+    for(uint i = 0; i < 2; ++i)
+    {
+      float origin = Dot(start, boxAxes[i]);
+      float speed = Dot(direction, boxAxes[i]);
+      if(fabs(speed) < 0.000001f)
+      {
+        //Parallel to the slab, must start inside it
+        if(origin < -boxHalfExtents[i] || origin > boxHalfExtents[i])
+          return false;
+      }
+      else
+      {
+        float t0 = (-boxHalfExtents[i] - origin) / speed;
+        float t1 = ( boxHalfExtents[i] - origin) / speed;
+        if(t0 > t1)
+        {
+          float temp = t0;
+          t0 = t1;
+          t1 = temp;
+        }
+        tMin = Max(tMin, t0);
+        tMax = Min(tMax, t1);
+        if(tMin > tMax)
+          return false;
+      }
+    }
+    return true;
+  }
+
   ///Intersect a rotated box with a rotated box.
   bool BoxBox(Vec2Param boxCenterA, Vec2Param boxHalfExtentsA, 
               const Vec2* boxAxesA, Vec2Param boxCenterB, 
               Vec2Param boxHalfExtentsB, const Vec2* boxAxesB, 
-              Manifold* manifold)
+              Manifold* manifold, SatCache* cache)
   {
     //This routine can be optimized by rotating everything into the space of
     //boxA (so that boxA is axis aligned and centered at the origin). This
     //will allow us to know boxA's face normals are the x and y axis. Look
     //at Real Time Collision Detection for more details.
 
+    //The cached reference face is kept unless another axis is clearly
+    //better. This keeps the reference face from flipping between steps
+    //when the overlaps are nearly equal.
+    const float relativeTolerance = 0.95f;
+    const float absoluteTolerance = 0.01f;
+
+    const Vec2 axes[4] = { boxAxesA[0], boxAxesA[1], boxAxesB[0], boxAxesB[1] };
+
+    //Test the cached axis first. If it separated the boxes last step it
+    //most likely still does and the other three projections are skipped.
+    uint order[4] = { 0, 1, 2, 3 };
+    if(cache != NULL && cache->AxisIndex < SatCache::NoAxis)
+    {
+      for(uint i = cache->AxisIndex; i > 0; --i)
+      {
+        order[i] = order[i - 1];
+      }
+      order[0] = cache->AxisIndex;
+    }
+
     float minOverlap = PositiveMax();
     Vec2 minAxis;
     uint axisIndex = 5;
 
     //----------------------------------------------------------------------------
-    //Project the boxes onto the axes of box A
-    for(uint i = 0; i < 2; ++i)
+    //Project the boxes onto the axes of both boxes
+    for(uint i = 0; i < 4; ++i)
     {
-      Vec2 axis = boxAxesA[i];
+      uint index = order[i];
+      Vec2 axis = axes[index];
       Vec2 intervalA = ProjectBoxOntoAxis(boxCenterA, boxHalfExtentsA, boxAxesA, 
                                           axis);
       Vec2 intervalB = ProjectBoxOntoAxis(boxCenterB, boxHalfExtentsB, boxAxesB,  
@@ -230,40 +307,35 @@ namespace Framework
       //Overlap amount is negative, interval is invalid, no intersection
       if(overlapAmount < 0.0f)
       {
+        if(cache != NULL)
+        {
+          cache->AxisIndex = index;
+          cache->Separated = true;
+        }
         return false;
       }
-      if(overlapAmount < minOverlap)
-      {
-        minOverlap = overlapAmount;
-        minAxis = axis;
-        axisIndex = i;
-      }
-    }
 
-    //----------------------------------------------------------------------------
-    //Project the boxes onto the axes of box B
-    for(uint i = 0; i < 2; ++i)
-    {
-      Vec2 axis = boxAxesB[i];
-      Vec2 intervalA = ProjectBoxOntoAxis(boxCenterA, boxHalfExtentsA, boxAxesA, 
-                                          axis);
-      Vec2 intervalB = ProjectBoxOntoAxis(boxCenterB, boxHalfExtentsB, boxAxesB,  
-                                          axis);
-      float overlapAmount = IntersectIntervals(intervalA, intervalB);
-
-      //Overlap amount is negative, interval is invalid, no intersection
-      if(overlapAmount < 0.0f)
+      //The cached reference face is only given up for a clearly smaller
+      //overlap. Otherwise the first axis with the smallest overlap wins.
+      float threshold = minOverlap;
+      if(cache != NULL && !cache->Separated && axisIndex == cache->AxisIndex)
       {
-        return false;
+        threshold = minOverlap * relativeTolerance - absoluteTolerance;
       }
-      if(overlapAmount < minOverlap)
+      if(overlapAmount < threshold)
       {
         minOverlap = overlapAmount;
         minAxis = axis;
-        axisIndex = i + 2;
+        axisIndex = index;
       }
     }
 
+    if(cache != NULL)
+    {
+      cache->AxisIndex = axisIndex;
+      cache->Separated = false;
+    }
+
     //----------------------------------------------------------------------------
     ErrorIf(axisIndex == 5, "Intersection - Axis index is invalid, impossible "\
                             "for this to break.");
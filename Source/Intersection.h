@@ -42,6 +42,22 @@ namespace Framework
     ContactPoint& PointAt(uint index) { return Points[index]; }
   };
 
+  ///Results of the separating axis test kept between steps for a pair of 
+  ///boxes. Boxes move very little each step, so the axis that separated them
+  ///last step usually still does, and colliding boxes usually keep the same
+  ///reference face.
+  struct SatCache
+  {
+    ///Axis 0 and 1 are the axes of box A, 2 and 3 the axes of box B.
+    enum { NoAxis = 4 };
+
+    SatCache() : AxisIndex(NoAxis), Separated(false) {}
+
+    ///The separating axis if Separated, otherwise the reference face axis.
+    uint AxisIndex;
+    bool Separated;
+  };
+
 
   bool CircleCirlce(Vec2Param circleCenterA, float circleRadiusA,
                     Vec2Param circleCenterB, float circleRadiusB, 
@@ -51,9 +67,16 @@ namespace Framework
                   const Vec2* boxAxes, Vec2Param circleCenter, 
                   float circleRadius, Manifold* manifold);
 
+  bool SegmentCircle(Vec2Param segmentStart, Vec2Param segmentEnd,
+                     Vec2Param circleCenter, float circleRadius);
+
+  bool SegmentBox(Vec2Param segmentStart, Vec2Param segmentEnd,
+                  Vec2Param boxCenter, Vec2Param boxHalfExtents,
+                  const Vec2* boxAxes);
+
   bool BoxBox(Vec2Param boxCenterA, Vec2Param boxHalfExtentsA, 
               const Vec2* boxAxesA, Vec2Param boxCenterB, 
               Vec2Param boxHalfExtentsB, const Vec2* boxAxesB, 
-              Manifold* manifold);
+              Manifold* manifold, SatCache* cache = NULL);
 
 }
\ No newline at end of file
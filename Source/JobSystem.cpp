@@ -0,0 +1,297 @@
+///////////////////////////////////////////////////////////////////////////////////////
+//
+//	JobSystem.cpp
+//
+//	Authors: Chris Peters
+//	Copyright 2011, Digipen Institute of Technology
+//
+///////////////////////////////////////////////////////////////////////////////////////
+#include "Precompiled.h"
+#include "JobSystem.h"
+
+namespace Framework
+{
+	JobSystem * JOBS = NULL;
+
+	ScratchArena::ScratchArena()
+	{
+		Memory = NULL;
+		Size = 0;
+		Used = 0;
+	}
+
+	ScratchArena::~ScratchArena()
+	{
+		delete [] Memory;
+	}
+
+	void ScratchArena::Reserve(unsigned size)
+	{
+		ErrorIf(Used!=0,"Scratch arena resized while in use.");
+		delete [] Memory;
+		Memory = new char[size];
+		Size = size;
+		Used = 0;
+	}
+
+	void* ScratchArena::Allocate(unsigned size)
+	{
+		//Align the address, not just the offset
+		size_t address = (size_t)(Memory + Used);
+		unsigned padding = unsigned( (16 - (address & 15)) & 15 );
+		if( Used + padding + size > Size )
+			return NULL;
+		void * result = Memory + Used + padding;
+		Used += padding + size;
+		return result;
+	}
+
+	JobSystem::JobSystem()
+	{
+		Quit = false;
+		Sleepers = 0;
+		ErrorIf(JOBS!=NULL,"Job system already created");
+		JOBS = this;
+	}
+
+	JobSystem::~JobSystem()
+	{
+		Shutdown();
+		if( JOBS == this )
+			JOBS = NULL;
+	}
+
+	void JobSystem::Initialize(unsigned threadCount)
+	{
+		if( threadCount < 1 ) threadCount = 1;
+		Quit = false;
+		Sleepers = 0;
+
+		for(unsigned i=0;i<threadCount;++i)
+		{
+			WorkerThread * thread = new WorkerThread();
+			thread->Owner = this;
+			thread->Index = i;
+			thread->Scratch.Reserve(ScratchSize);
+			Threads.push_back(thread);
+		}
+
+		//The calling thread is thread zero and runs jobs while it waits
+		ThreadIndex.Set((void*)1);
+
+		//Start the workers only after every queue exists since
+		//they steal from each other
+		for(unsigned i=1;i<threadCount;++i)
+			Threads[i]->Handle.Start(WorkerMain, Threads[i]);
+	}
+
+	void JobSystem::Shutdown()
+	{
+		if( Threads.empty() )
+			return;
+
+		Quit = true;
+		WorkReady.Release(Threads.size() - 1);
+		for(unsigned i=1;i<Threads.size();++i)
+			Threads[i]->Handle.Join();
+
+		for(unsigned i=0;i<Threads.size();++i)
+			delete Threads[i];
+		Threads.clear();
+		ThreadIndex.Set(NULL);
+	}
+
+	unsigned JobSystem::GetThreadIndex()
+	{
+		size_t index = (size_t)ThreadIndex.Get();
+		ErrorIf(index==0,"Job system used from a thread it does not own.");
+		return index > 0 ? unsigned(index - 1) : 0;
+	}
+
+	ScratchArena& JobSystem::GetScratch()
+	{
+		return Threads[GetThreadIndex()]->Scratch;
+	}
+
+	unsigned JobSystem::WorkerMain(void* data)
+	{
+		WorkerThread * thread = (WorkerThread*)data;
+		JobSystem * owner = thread->Owner;
+		owner->ThreadIndex.Set((void*)(size_t)(thread->Index + 1));
+
+		while( !owner->Quit )
+		{
+			if( owner->RunOneJob(thread->Index) )
+				continue;
+
+			//Announce the sleep before looking once more. A job submitted
+			//after the increment sees the sleeper and wakes it, and one
+			//submitted before it is found by the second look.
+			AtomicIncrement(&owner->Sleepers);
+			bool ran = owner->RunOneJob(thread->Index);
+
+			//Withdraw unless a submit already woke this worker, in which
+			//case its release has to be taken from the semaphore
+			long sleepers = AtomicLoadAcquire(&owner->Sleepers);
+			while( ran && sleepers > 0 )
+			{
+				long previous = AtomicCompareExchange(&owner->Sleepers, sleepers - 1, sleepers);
+				if( previous == sleepers )
+					break;
+				sleepers = previous;
+			}
+			if( !ran || sleepers == 0 )
+				owner->WorkReady.Wait();
+		}
+		return 0;
+	}
+
+	void JobSystem::WakeWorkers(long count)
+	{
+		long sleepers = AtomicLoadAcquire(&Sleepers);
+		while( sleepers > 0 )
+		{
+			long woken = sleepers < count ? sleepers : count;
+			long previous = AtomicCompareExchange(&Sleepers, sleepers - woken, sleepers);
+			if( previous == sleepers )
+			{
+				WorkReady.Release(woken);
+				return;
+			}
+			sleepers = previous;
+		}
+	}
+
+	void JobSystem::Submit(JobFunction function, void* data, JobCounter* counter, JobCounter* dependency)
+	{
+		Job job;
+		job.Function = function;
+		job.Data = data;
+		job.Counter = counter;
+		job.Dependency = dependency;
+
+		if( counter )
+			AtomicIncrement(&counter->Count);
+
+		WorkerThread& thread = *Threads[GetThreadIndex()];
+		{
+			ScopedLock lock(thread.QueueLock);
+			thread.Queue.push_back(job);
+		}
+		//Only a sleeping worker needs waking, an awake one will steal the
+		//job on its own. The fence orders the push before reading the
+		//sleeper count, mirroring the worker's increment and second look.
+		MemoryFence();
+		WakeWorkers(1);
+	}
+
+	bool JobSystem::TakeJob(WorkerThread& thread, bool steal, Job& job)
+	{
+		ScopedLock lock(thread.QueueLock);
+		unsigned count = thread.Queue.size();
+		for(unsigned i=0;i<count;++i)
+		{
+			//Newest first for our own queue, oldest first when stealing
+			unsigned index = steal ? i : count - 1 - i;
+			Job& candidate = thread.Queue[index];
+			if( candidate.Dependency && !candidate.Dependency->IsDone() )
+				continue;
+			job = candidate;
+			thread.Queue.erase(thread.Queue.begin() + index);
+			return true;
+		}
+		return false;
+	}
+
+	bool JobSystem::RunOneJob(unsigned index)
+	{
+		Job job;
+		bool found = TakeJob(*Threads[index], false, job);
+		for(unsigned i=1;!found && i<Threads.size();++i)
+			found = TakeJob(*Threads[(index + i) % Threads.size()], true, job);
+		if( !found )
+			return false;
+
+		//Jobs run inside a wait share the arena with the waiting job,
+		//so each job frees only what it allocated
+		ScratchArena& scratch = Threads[index]->Scratch;
+		unsigned mark = scratch.GetMark();
+		job.Function(job.Data);
+		scratch.FreeToMark(mark);
+
+		//Jobs depending on this counter may be able to start now
+		if( job.Counter && AtomicDecrement(&job.Counter->Count) == 0 )
+			WakeWorkers(Threads.size() - 1);
+		return true;
+	}
+
+	void JobSystem::Wait(JobCounter* counter)
+	{
+		unsigned index = GetThreadIndex();
+		while( !counter->IsDone() )
+		{
+			if( !RunOneJob(index) )
+				YieldThread();
+		}
+	}
+
+	struct RangeJob
+	{
+		RangeFunction Function;
+		void* Data;
+		unsigned Begin;
+		unsigned End;
+	};
+
+	static void RunRangeJob(void* data)
+	{
+		RangeJob * range = (RangeJob*)data;
+		range->Function(range->Data, range->Begin, range->End);
+	}
+
+	void JobSystem::ParallelFor(RangeFunction function, void* data, unsigned count, unsigned minPerJob, unsigned maxJobs)
+	{
+		if( count == 0 )
+			return;
+
+		unsigned rangeCount = maxJobs > 0 ? maxJobs : GetThreadCount();
+		unsigned maxRanges = count / (minPerJob > 0 ? minPerJob : 1);
+		if( maxRanges < rangeCount ) rangeCount = maxRanges;
+		if( rangeCount < 1 ) rangeCount = 1;
+
+		//The range descriptions live in this thread's scratch until the wait ends
+		ScratchArena& scratch = GetScratch();
+		unsigned mark = scratch.GetMark();
+		RangeJob * ranges = NULL;
+		if( rangeCount > 1 )
+			ranges = (RangeJob*)scratch.Allocate(sizeof(RangeJob) * rangeCount);
+		if( ranges == NULL )
+		{
+			function(data, 0, count);
+			return;
+		}
+
+		unsigned perRange = count / rangeCount;
+		JobCounter counter;
+		for(unsigned i=1;i<rangeCount;++i)
+		{
+			ranges[i].Function = function;
+			ranges[i].Data = data;
+			ranges[i].Begin = i * perRange;
+			ranges[i].End = (i == rangeCount - 1) ? count : ranges[i].Begin + perRange;
+			Submit(RunRangeJob, &ranges[i], &counter);
+		}
+
+		function(data, 0, perRange);
+		Wait(&counter);
+		scratch.FreeToMark(mark);
+	}
+
+	void ParallelFor(RangeFunction function, void* data, unsigned count, unsigned minPerJob, unsigned maxJobs)
+	{
+		if( JOBS && JOBS->GetThreadCount() > 0 )
+			JOBS->ParallelFor(function, data, count, minPerJob, maxJobs);
+		else
+			function(data, 0, count);
+	}
+}
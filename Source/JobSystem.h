@@ -0,0 +1,143 @@
+///////////////////////////////////////////////////////////////////////////////////////
+///
+///	\file JobSystem.h
+///	Work stealing job system shared by all the engine systems.
+///
+///	Authors: Chris Peters
+///	Copyright 2011, Digipen Institute of Technology
+///
+///////////////////////////////////////////////////////////////////////////////////////
+#pragma once //Makes sure this header is only included once
+
+#include "Threading.h"
+#include <deque>
+
+namespace Framework
+{
+	///Function run by a job.
+	typedef void (*JobFunction)(void* data);
+	///Function run on a range [begin,end) of items by ParallelFor.
+	typedef void (*RangeFunction)(void* data, unsigned begin, unsigned end);
+
+	///Counts the unfinished jobs submitted with it. Wait on a counter to
+	///wait for a group of jobs, or pass it as the dependency of other jobs
+	///so they only start once the group is done.
+	struct JobCounter
+	{
+		JobCounter() : Count(0) {}
+		///Only changed with AtomicIncrement and AtomicDecrement. The
+		///decrement is a full barrier, so a job's writes are released
+		///before the count drops, and IsDone acquires them.
+		volatile long Count;
+		bool IsDone(){return AtomicLoadAcquire(&Count) == 0;}
+	};
+
+	///Bump allocator private to one thread. Jobs allocate temporary memory
+	///from the arena of the thread running them. Everything a job allocates
+	///is freed when it returns.
+	class ScratchArena
+	{
+	public:
+		ScratchArena();
+		~ScratchArena();
+		void Reserve(unsigned size);
+		///Allocate 16 byte aligned memory. Returns NULL if the arena is full.
+		void* Allocate(unsigned size);
+		///Free everything allocated after the mark was taken.
+		unsigned GetMark(){return Used;}
+		void FreeToMark(unsigned mark){Used = mark;}
+	private:
+		ScratchArena(const ScratchArena&);
+		ScratchArena& operator=(const ScratchArena&);
+		char* Memory;
+		unsigned Size;
+		unsigned Used;
+	};
+
+	///Runs jobs on a worker thread per core. Each thread has its own queue.
+	///Threads take their newest job first, which keeps nested work in cache,
+	///and take the oldest job of another thread when theirs is empty.
+	///Waiting on a counter runs other jobs instead of blocking, so jobs can
+	///submit and wait on more jobs. Only the thread that initialized the
+	///system (the main thread) and the workers may use it.
+	class JobSystem
+	{
+	public:
+		JobSystem();
+		~JobSystem();
+
+		///Start threadCount - 1 workers. The main thread is thread zero.
+		void Initialize(unsigned threadCount);
+		///Stop and join the workers. Jobs not yet started are dropped.
+		void Shutdown();
+
+		///Number of threads that run jobs including the main thread.
+		unsigned GetThreadCount(){return Threads.size();}
+		///Index of the calling thread, zero for the main thread.
+		unsigned GetThreadIndex();
+
+		///Queue a job on the calling thread. The counter, if any, is
+		///counted up now and down when the job finishes. A job with a
+		///dependency does not start until that counter reaches zero.
+		void Submit(JobFunction function, void* data, JobCounter* counter, JobCounter* dependency = NULL);
+		///Run jobs until the counter reaches zero.
+		void Wait(JobCounter* counter);
+
+		///Split [0,count) into contiguous ranges and run the function on
+		///each, the first on the calling thread. Returns when all ranges
+		///are done. Ranges are never smaller than minPerJob items and there
+		///are at most maxJobs of them (zero for one per thread).
+		void ParallelFor(RangeFunction function, void* data, unsigned count, unsigned minPerJob, unsigned maxJobs = 0);
+
+		///Scratch memory of the calling thread.
+		ScratchArena& GetScratch();
+		///Size of each thread's scratch arena in bytes.
+		enum { ScratchSize = 1024 * 1024 };
+
+	private:
+		struct Job
+		{
+			JobFunction Function;
+			void* Data;
+			JobCounter* Counter;
+			JobCounter* Dependency;
+		};
+
+		struct WorkerThread
+		{
+			JobSystem * Owner;
+			unsigned Index;
+			Thread Handle;
+			Mutex QueueLock;
+			//Owner takes from the back, other threads steal from the front
+			std::deque<Job> Queue;
+			ScratchArena Scratch;
+		};
+
+		static unsigned WorkerMain(void* data);
+		bool TakeJob(WorkerThread& thread, bool steal, Job& job);
+		bool RunOneJob(unsigned index);
+		///Wake up to count sleeping workers. Each one woken is taken off
+		///the sleeper count by the caller.
+		void WakeWorkers(long count);
+
+		JobSystem(const JobSystem&);
+		JobSystem& operator=(const JobSystem&);
+
+		std::vector<WorkerThread*> Threads;
+		//Index + 1 of the calling thread. Zero for threads that are not ours.
+		ThreadLocal ThreadIndex;
+		//Released once for each sleeping worker that is woken
+		ThreadSemaphore WorkReady;
+		//Workers about to sleep on WorkReady that nobody has woken yet
+		volatile long Sleepers;
+		volatile bool Quit;
+	};
+
+	///Run a loop on the engine job system, or on the calling thread if
+	///there is none.
+	void ParallelFor(RangeFunction function, void* data, unsigned count, unsigned minPerJob, unsigned maxJobs = 0);
+
+	///Global pointer to the job system owned by the core.
+	extern JobSystem * JOBS;
+}
@@ -49,4 +49,8 @@ namespace Framework
     void ApplyImpulse(int bodyIndex, Vec2Param impulse);
   };
 
+  // Contacts for a step. Produced by the narrow phase and resolved in place
+  // by whichever solver is active.
+  typedef std::vector<BodyManifold> ContactArray;
+
 }
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "Vector4.hpp"
+
+namespace Framework
+{
+
+  ///Row major 4x4 matrix that transforms row vectors (v * M), the same
+  ///layout and convention as D3DXMATRIX.
+  struct Matrix4
+  {
+    Matrix4()
+    {
+      SetIdentity();
+    }
+
+    void SetIdentity()
+    {
+      for(unsigned r=0;r<4;++r)
+        for(unsigned c=0;c<4;++c)
+          m[r][c] = r == c ? 1.0f : 0.0f;
+    }
+
+    Matrix4 operator*(const Matrix4& rhs) const
+    {
+      Matrix4 ret;
+      for(unsigned r=0;r<4;++r)
+      {
+        for(unsigned c=0;c<4;++c)
+        {
+          ret.m[r][c] = m[r][0] * rhs.m[0][c] + m[r][1] * rhs.m[1][c] +
+                        m[r][2] * rhs.m[2][c] + m[r][3] * rhs.m[3][c];
+        }
+      }
+      return ret;
+    }
+
+    ///Transform the point (x, y, 0, 1).
+    Vector4 TransformPoint(float x, float y) const
+    {
+      return Vector4(x * m[0][0] + y * m[1][0] + m[3][0],
+                     x * m[0][1] + y * m[1][1] + m[3][1],
+                     x * m[0][2] + y * m[1][2] + m[3][2],
+                     x * m[0][3] + y * m[1][3] + m[3][3]);
+    }
+
+    float m[4][4];
+  };
+
+  typedef Matrix4 Mat4;
+}
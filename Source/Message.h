@@ -25,7 +25,11 @@ namespace Framework
 			CharacterKey,
 			MouseButton,
 			MouseMove,
-			FileDrop
+			FileDrop,
+			SensorEnter,
+			SensorExit,
+			//Number of message ids, keep last
+			MessageIdCount
 		};
 	}
 
@@ -39,6 +39,9 @@ namespace Framework
 
     Vec2 p2p1 = Target - worldPoint1;
     float distance = Normalize(p2p1);
+    //The grab point starts on the target, any axis will do until it moves
+    if(distance == 0.0f)
+      p2p1 = Vec2(1.0f, 0.0f);
     Bias = .5f * distance * distance - Distance * Distance;
     //the jacobian for is ( -d, -r1 x d, 0, 0)
     StickJacobian.Set(-p2p1,-Cross2D(worldR1,p2p1));
@@ -48,8 +51,11 @@ namespace Framework
     EffectiveMass = linearMass1 + angularMass1;
     ErrorIf(EffectiveMass == 0.0f,"Constraint is connected to an object of infinite mass. Cannot grab an infinite mass object with a mouse constraint.");
     EffectiveMass = EffectiveMass;
+  }
 
-
+  void MouseConstraint::DebugDraw()
+  {
+    Vec2 worldPoint1 = Bodies[0]->GetWorldPointFromBodyPoint(BodyR);
     Drawer::Instance.DrawSegment( worldPoint1 , Target );
   }
 
@@ -72,6 +78,18 @@ namespace Framework
     Bodies[0]->AngularVelocity += StickJacobian.Angular1 * lambda * Bodies[0]->InvInertia;
   }
 
+  void MouseConstraint::WarmStart(float scale)
+  {
+    AccumulatedImpulse *= scale;
+    Bodies[0]->Velocity += StickJacobian.Linear1 * AccumulatedImpulse * Bodies[0]->InvMass;
+    Bodies[0]->AngularVelocity += StickJacobian.Angular1 * AccumulatedImpulse * Bodies[0]->InvInertia;
+  }
+
+  void MouseConstraint::ClearImpulse()
+  {
+    AccumulatedImpulse = 0;
+  }
+
   void MouseConstraint::SetBody(Body* body)
   {
     Bodies[0] = body;
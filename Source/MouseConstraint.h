@@ -26,6 +26,9 @@ namespace Framework
 
     virtual void Update(float dt);
     virtual void SolveIteration(float dt);
+    virtual void WarmStart(float scale);
+    virtual void ClearImpulse();
+    virtual void DebugDraw();
 
     void SetBody(Body* body);
     void SetBodyPoint(Vec2Param bodyPoint);
@@ -0,0 +1,103 @@
+///////////////////////////////////////////////////////////////////////////////////////
+//
+//	NarrowPhase.cpp
+//
+//	Authors: Chris Peters
+//	Copyright 2011, Digipen Institute of Technology
+//
+///////////////////////////////////////////////////////////////////////////////////////
+#include "Precompiled.h"
+#include "NarrowPhase.h"
+#include "Body.h"
+
+namespace Framework
+{
+	NarrowPhase::NarrowPhase()
+	{
+		Collision = NULL;
+		MinPairsPerThread = 64;
+		ThreadCount = 1;
+	}
+
+	NarrowPhase::~NarrowPhase()
+	{
+	}
+
+	void NarrowPhase::Initialize(CollsionDatabase* collision, unsigned threadCount)
+	{
+		Collision = collision;
+		ThreadCount = threadCount > 0 ? threadCount : 1;
+	}
+
+	void NarrowPhase::RunRange(void* data)
+	{
+		RangeJob * range = (RangeJob*)data;
+		range->Owner->ProcessPairs(range->Pairs, range->PairCount, range->Contacts);
+	}
+
+	void NarrowPhase::ProcessPairs(BodyPair* pairs, unsigned pairCount, ContactArray& contacts)
+	{
+		contacts.clear();
+		for(unsigned i=0;i<pairCount;++i)
+		{
+			Body * bodyA = pairs[i].Bodies[0];
+			Body * bodyB = pairs[i].Bodies[1];
+			Manifold manifolds[CollsionDatabase::MaxManifolds];
+			unsigned count = Collision->GenerateManifolds(bodyA, bodyB, manifolds, CollsionDatabase::MaxManifolds, pairs[i].Cache);
+			for(unsigned m=0;m<count;++m)
+			{
+				contacts.push_back(BodyManifold());
+				contacts.back().Set(&manifolds[m], bodyA, bodyB);
+			}
+		}
+	}
+
+	void NarrowPhase::GenerateContacts(BodyPairArray& pairs)
+	{
+		unsigned pairCount = pairs.size();
+		if( pairCount == 0 )
+		{
+			Contacts.clear();
+			return;
+		}
+
+		//Determine how many ranges to split the pairs into. Small
+		//pair lists are not worth handing to other threads.
+		unsigned rangeCount = ThreadCount;
+		if( JOBS == NULL || JOBS->GetThreadCount() == 0 )
+			rangeCount = 1;
+		unsigned maxRanges = pairCount / MinPairsPerThread;
+		if( maxRanges < rangeCount ) rangeCount = maxRanges;
+		if( rangeCount < 1 ) rangeCount = 1;
+
+		unsigned pairsPerRange = pairCount / rangeCount;
+		BodyPair * allPairs = &pairs[0];
+		if( Ranges.size() < rangeCount )
+			Ranges.resize(rangeCount);
+
+		//Ranges 1..n are jobs
+		JobCounter counter;
+		for(unsigned i=1;i<rangeCount;++i)
+		{
+			RangeJob& range = Ranges[i];
+			unsigned begin = i * pairsPerRange;
+			unsigned end = (i == rangeCount - 1) ? pairCount : begin + pairsPerRange;
+			range.Owner = this;
+			range.Pairs = allPairs + begin;
+			range.PairCount = end - begin;
+			JOBS->Submit(RunRange, &range, &counter);
+		}
+
+		//Range 0 is processed on this thread directly into the output
+		ProcessPairs(allPairs, rangeCount == 1 ? pairCount : pairsPerRange, Contacts);
+
+		if( rangeCount == 1 )
+			return;
+
+		//Merge the range buffers in range order so the contacts come out
+		//in exactly the same order as the serial pair loop
+		JOBS->Wait(&counter);
+		for(unsigned i=1;i<rangeCount;++i)
+			Contacts.insert(Contacts.end(), Ranges[i].Contacts.begin(), Ranges[i].Contacts.end());
+	}
+}
@@ -0,0 +1,71 @@
+///////////////////////////////////////////////////////////////////////////////////////
+///
+///	\file NarrowPhase.h
+///	Multi-threaded narrow phase. Generates contacts for a list of candidate
+///	body pairs as jobs on the engine job system.
+///
+///	Authors: Chris Peters
+///	Copyright 2011, Digipen Institute of Technology
+///
+///////////////////////////////////////////////////////////////////////////////////////
+#pragma once //Makes sure this header is only included once
+
+#include "Collision.h"
+#include "Manifold.h"
+#include "JobSystem.h"
+
+namespace Framework
+{
+	///A pair of bodies that may be colliding.
+	struct BodyPair
+	{
+		Body * Bodies[2];
+		///Separating axis results from the last step, NULL if not cached.
+		SatCache * Cache;
+	};
+
+	typedef std::vector<BodyPair> BodyPairArray;
+
+	///Runs the collision tests for all candidate pairs. Pairs are split into
+	///contiguous ranges, one job per range, and each range writes to its own
+	///contact buffer. The buffers are merged in range order so the resulting
+	///contacts are in the same order as the pair list no matter how many
+	///threads are used. This keeps the solvers deterministic.
+	class NarrowPhase
+	{
+	public:
+		NarrowPhase();
+		~NarrowPhase();
+
+		///Set the most jobs the pairs are split into. A thread count of
+		///one runs everything on the calling thread.
+		void Initialize(CollsionDatabase* collision, unsigned threadCount);
+
+		///Generate contacts for every pair. Results are stored in Contacts.
+		void GenerateContacts(BodyPairArray& pairs);
+
+		///Contacts from the last call to GenerateContacts in pair order.
+		ContactArray Contacts;
+
+		///Pairs per thread below which the work is not split.
+		unsigned MinPairsPerThread;
+
+	private:
+		//One contiguous range of pairs and the contacts it produced
+		struct RangeJob
+		{
+			NarrowPhase * Owner;
+			BodyPair * Pairs;
+			unsigned PairCount;
+			ContactArray Contacts;
+		};
+
+		static void RunRange(void* data);
+		void ProcessPairs(BodyPair* pairs, unsigned pairCount, ContactArray& contacts);
+
+		CollsionDatabase * Collision;
+		unsigned ThreadCount;
+		//Kept between steps to reuse the contact buffers
+		std::vector<RangeJob> Ranges;
+	};
+}
@@ -0,0 +1,94 @@
+///////////////////////////////////////////////////////////////////////////////////////
+//
+//	NullGraphics.cpp
+//	Graphics for headless builds. Provides the Sprite and Camera components and
+//	throws away the debug lines, but has no device and draws nothing.
+//	
+//	Authors: Chris Peters
+//	Copyright 2011, Digipen Institute of Technology
+//
+///////////////////////////////////////////////////////////////////////////////////////
+#include "Precompiled.h"
+
+#ifdef G_HEADLESS
+
+#include "Graphics.h"
+#include "DebugDraw.h"
+#include "Camera.h"
+#include "ComponentCreator.h"
+
+namespace Framework
+{
+	//Our global pointer to Graphics.
+	Graphics* GRAPHICS = NULL;
+
+	Graphics::Graphics()
+	{
+		CurrentCamera = NULL;
+		HWnd = NULL;
+		ScreenWidth = 800;
+		ScreenHeight = 600;
+		pD3D = NULL;
+		pDevice = NULL;
+		pQuadVertexBuffer = NULL;
+		for (int i = 0; i < NumberOfShaders; i++)
+			Shaders[i] = NULL;
+		Pipelined = false;
+		WritePacket = 0;
+		PublishedPacket = NULL;
+		RenderingPacket = NULL;
+		RenderQuit = false;
+
+		ErrorIf(GRAPHICS!=NULL,"Graphics already initialized.");
+		GRAPHICS = this;
+	}
+
+	Graphics::~Graphics()
+	{
+	}
+
+	void Graphics::SetWindwProperties(void* hWnd,int screenWidth,int screenHeight)
+	{
+		HWnd = hWnd;
+		ScreenWidth = screenWidth;
+		ScreenHeight = screenHeight;
+	}
+
+	void Graphics::Initialize()
+	{
+		SurfaceSize = Vec2((float)ScreenWidth, (float)ScreenHeight);
+
+		RegisterComponent(Sprite);
+		RegisterComponent(Camera);
+	}
+
+	void Graphics::Update(float)
+	{
+	}
+
+	void Graphics::EndFrame()
+	{
+		//Nothing reads the debug lines so drop them
+		//before they pile up from frame to frame
+		Drawer::Instance.Flush();
+		Drawer::Instance.Clear();
+	}
+
+	IDirect3DTexture9* Graphics::GetTexture(std::string)
+	{
+		//No textures are loaded without a device
+		return NULL;
+	}
+
+	Vec2 Graphics::ScreenToWorldSpace(Vec2 screenPosition)
+	{
+		//The same mapping as the orthographic camera: one unit per pixel,
+		//centered on the camera with y pointing up
+		Vec2 world(screenPosition.x - SurfaceSize.x * 0.5f, SurfaceSize.y * 0.5f - screenPosition.y);
+		if( CurrentCamera && CurrentCamera->transform )
+			world += CurrentCamera->transform->Position;
+		return world;
+	}
+}
+
+#endif
@@ -0,0 +1,59 @@
+///////////////////////////////////////////////////////////////////////////////////////
+//
+//	NullPlatform.cpp
+//	
+//	Authors: Chris Peters
+//	Copyright 2011, Digipen Institute of Technology
+//
+///////////////////////////////////////////////////////////////////////////////////////
+#include "Precompiled.h"
+
+#ifdef G_HEADLESS
+
+#include "NullPlatform.h"
+#include "InputRecording.h"
+#include "Core.h"
+
+namespace Framework
+{
+	//A global pointer to the null platform
+	NullPlatform* NULLPLATFORM = NULL;
+
+	NullPlatform::NullPlatform()
+	{
+		Playback = NULL;
+		ErrorIf(NULLPLATFORM!=NULL,"Platform already initialized.");
+		NULLPLATFORM = this;
+	}
+
+	NullPlatform::~NullPlatform()
+	{
+		NULLPLATFORM = NULL;
+	}
+
+	void NullPlatform::Update(float)
+	{
+		Input.NewFrame();
+
+		//A recorded frame with more events than the queue holds
+		//is delivered a queue full at a time
+		if( Playback )
+		{
+			while( !Playback->QueueFrame(Events) )
+				Events.Deliver(Input, CORE->GetFrameStartTime());
+		}
+
+		Events.Deliver(Input, CORE->GetFrameStartTime());
+	}
+
+	//Reported when there is no platform
+	static const InputState NoInput;
+
+	//There is no keyboard or mouse, so only a playback ever changes the input
+	const InputState& GetInput()
+	{
+		return NULLPLATFORM ? NULLPLATFORM->Input : NoInput;
+	}
+}
+
+#endif
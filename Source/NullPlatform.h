@@ -0,0 +1,46 @@
+///////////////////////////////////////////////////////////////////////////////////////
+///
+///	\file NullPlatform.h
+///	Platform system for headless builds. Has no window and no input.
+///
+///	Authors: Chris Peters
+///	Copyright 2011, Digipen Institute of Technology
+///
+///////////////////////////////////////////////////////////////////////////////////////
+#pragma once //Makes sure this header is only included once
+
+#include "Engine.h"
+#include "Input.h"
+#include "InputQueue.h"
+
+namespace Framework
+{
+	class InputPlayback;
+
+	///Stands in for WindowsSystem when there is no window. Without a
+	///playback or pushed events nothing is ever pressed and it sends no
+	///input messages. With one it sends the recorded input of each frame.
+	class NullPlatform : public ISystem
+	{
+	public:
+		NullPlatform();
+		~NullPlatform();
+		virtual void Update(float dt);
+		virtual std::string GetName() {return "NullPlatform";}
+		virtual unsigned GetReads() {return SystemData::Input;}
+		virtual unsigned GetWrites() {return SystemData::Input;}
+		virtual bool RunsOnMainThread() {return true;}
+
+		///Recording to play back, advanced by whoever runs the frames.
+		InputPlayback * Playback;
+		///Input of the current frame, from the playback if there is one.
+		InputState Input;
+		///Events delivered at the start of each frame, the same way the
+		///windows system delivers the events of its input thread. Playbacks
+		///queue their frames here. Without a playback one other thread may
+		///push events instead, such as a test feeding input while frames run.
+		InputQueue Events;
+	};
+
+	extern NullPlatform* NULLPLATFORM;
+}
@@ -13,15 +13,36 @@
 #include "Body.h"
 #include "ComponentCreator.h"
 #include "Core.h"
+#include "Graphics.h"
+#include "Camera.h"
+#include <algorithm>
 
 namespace Framework
 {
 	Physics * PHYSICS = NULL;
 
+	///Creates the bodies of data driven objects in one world.
+	class BodyCreator : public ComponentCreator
+	{
+	public:
+		BodyCreator(Physics * world)
+			:ComponentCreator(CT_Body), World(world)
+		{
+		}
+
+		virtual GameComponent * Create()
+		{
+			return new Body(World);
+		}
+
+		Physics * World;
+	};
+
 	Physics::Physics()
 	{
-		ErrorIf(PHYSICS!=NULL,"Physics already initialized");
-		PHYSICS = this;
+		//The first world created is the default world
+		if( PHYSICS == NULL )
+			PHYSICS = this;
 		DebugDrawingActive = false;
 		TimeAccumulation = 0.0f;
 		Gravity = Vec2(0,-400);
@@ -31,11 +52,60 @@ namespace Framework
 		PenetrationResolvePercentage = 0.8f;
 		StepModeActive = false;
 		AdvanceStep = false;
+		BroadPhaseDirty = true;
+		StepCount = 0;
+		ReorderInterval = 120;
+		Exporter = NULL;
+		ContactSolver = SolverImpulses;
+		Substeps = 8;
+		LodEnabled = false;
+		LodUseCamera = true;
+		LodDistances[0] = 1500.0f;
+		LodDistances[1] = 3000.0f;
+		LodDistances[2] = 6000.0f;
+		LodMargin = 32.0f;
+		LodStep = 0;
+		HasCamera = false;
+	}
+
+	Physics::~Physics()
+	{
+		if( PHYSICS == this )
+			PHYSICS = NULL;
 	}
 
 	void Physics::Initialize()
 	{
-		RegisterComponent(Body);
+		//Bodies built by the factory go to this world
+		FACTORY->AddComponentCreator( "Body", new BodyCreator(this) );
+		CORE->Subscribe(Mid::ToggleDebugInfo, this);
+
+		//Split the narrow phase across all the cores
+		InitializeWorld(GetHardwareThreadCount());
+	}
+
+	void Physics::InitializeWorld(unsigned threadCount)
+	{
+		Narrow.Initialize(&Collsion, threadCount);
+		Granular.Initialize(threadCount);
+	}
+
+	GOC * Physics::CreateObject(const std::string& filename, Vec2Param position, float rotation)
+	{
+		GOC * goc = FACTORY->BuildAndSerialize(filename);
+		if( goc )
+		{
+			if( Transform * transform = goc->has(Transform) )
+			{
+				transform->Position = position;
+				transform->Rotation = rotation;
+			}
+			//The factory built the body for the default world
+			if( Body * body = goc->has(Body) )
+				body->World = this;
+			goc->Initialize();
+		}
+		return goc;
 	}
 
   void Physics::AddConstraint(Constraint* constraint)
@@ -52,66 +122,147 @@ namespace Framework
 	{
 		for(BodyIterator it=Bodies.begin();it!=Bodies.end();++it)
 		{
-			it->Integrate(dt);
+			if( it->LodActive )
+				it->Integrate(dt);
 		}
 	}
 
-  void Physics::DetectContactsImpulses(float dt)
-  {
-    BodyIterator bodyA = Bodies.begin();
-    BodyIterator lastBody = Bodies.last(); //end - 1
-
-    //Broad phase should be added this is N^2
-    for(;bodyA!=lastBody;++bodyA)
-    {
-      BodyIterator bodyB = bodyA;
-      ++bodyB;
-      for(;bodyB!=Bodies.end();++bodyB)
-      {
-        //Do not collide static bodies with other static bodies
-        if( !bodyA->IsStatic || !bodyB->IsStatic )
-        {
-          Manifold manifold;
-          if(Collsion.GenerateContacts( bodyA, bodyB, &manifold ))
-          {
-            BodyManifold* contact = Contacts.GetNextContact();
-            contact->Set(&manifold,bodyA,bodyB);
-          }
-        }
-      }
-    }
-  }
+	void Physics::UpdateBroadPhase()
+	{
+		if( BroadPhaseDirty )
+		{
+			Broad.Build(Bodies);
+			BroadPhaseDirty = false;
+		}
+	}
 
-	void Physics::DetectContactsConstraints(float dt)
+	//A sensor notices other bodies when at least one of the two can move,
+	//so kinematic bodies trigger sensors as well as dynamic ones.
+	//Sensors do not notice each other.
+	static bool IsSensorPair(Body* bodyA, Body* bodyB)
 	{
-		BodyIterator bodyA = Bodies.begin();
-		BodyIterator lastBody = Bodies.last(); //end - 1
-		
-		//Broad phase should be added this is N^2
-		for(;bodyA!=lastBody;++bodyA)
+		return bodyA->IsSensor != bodyB->IsSensor && (!bodyA->IsStatic || !bodyB->IsStatic);
+	}
+
+	void Physics::BuildCandidatePairs(bool activeOnly)
+	{
+		CandidatePairs.clear();
+
+		//Bodies have just been integrated so the grid is always rebuilt.
+		//A grid of only the active bodies can not be used for queries.
+		Broad.Build(Bodies, 0.0f, activeOnly);
+		BroadPhaseDirty = activeOnly;
+		Broad.FindPairs(QueryPairs);
+		//The narrow phase holds pointers to the caches, so the table
+		//must not grow once they are handed out
+		SatCaches.Reserve(QueryPairs.size());
+
+		for(unsigned i=0;i<QueryPairs.size();++i)
 		{
-			BodyIterator bodyB = bodyA;
-			++bodyB;
-			for(;bodyB!=Bodies.end();++bodyB)
+			Body * bodyA = QueryPairs[i].Bodies[0];
+			Body * bodyB = QueryPairs[i].Bodies[1];
+
+			//Sensors only need an overlap test and never
+			//reach the contact solvers
+			if( bodyA->IsSensor || bodyB->IsSensor )
 			{
-				//Do not collide static bodies with other static bodies
-				if( !bodyA->IsStatic || !bodyB->IsStatic )
-				{
-          Manifold manifold;
-					if(Collsion.GenerateContacts( bodyA, bodyB , &manifold ))
-          {
-            BodyManifold contact;
-            contact.Set(&manifold,bodyA,bodyB);
-            Solver.AddContact(&contact);
-          }
-				}
+				//Level of detail passes take the sensor pairs from the
+				//island grid, which has every body
+				if( !activeOnly && IsSensorPair(bodyA, bodyB) )
+					SensorPairs.push_back(QueryPairs[i]);
+			}
+			//Only pairs with at least one dynamic body can collide. This
+			//skips static, kinematic vs static and kinematic vs kinematic
+			else if( bodyA->IsDynamic() || bodyB->IsDynamic() )
+			{
+				BodyPair& pair = QueryPairs[i];
+				if( bodyA->BodyShape->Id == Shape::SidBox && bodyB->BodyShape->Id == Shape::SidBox )
+					pair.Cache = SatCaches.Find(bodyA->GetOwner()->GetId(), bodyB->GetOwner()->GetId(), StepCount);
+				CandidatePairs.push_back(pair);
+			}
+		}
+	}
+
+	void Physics::DetectContacts(bool activeOnly)
+	{
+		BuildCandidatePairs(activeOnly);
+		Narrow.GenerateContacts(CandidatePairs);
+		CountContacts();
+	}
+
+	void Physics::CountContacts()
+	{
+		//Bodies left out of this pass keep their count
+		for(BodyIterator it=Bodies.begin();it!=Bodies.end();++it)
+		{
+			if( it->LodActive || !it->IsDynamic() )
+				it->ContactCount = 0;
+		}
+
+		for(unsigned i=0;i<Narrow.Contacts.size();++i)
+		{
+			++Narrow.Contacts[i].Bodies[0]->ContactCount;
+			++Narrow.Contacts[i].Bodies[1]->ContactCount;
+		}
+	}
+
+	void Physics::DetectSensors()
+	{
+		PrevSensorOverlaps.swap(SensorOverlaps);
+		SensorOverlaps.clear();
+
+		for(unsigned i=0;i<SensorPairs.size();++i)
+		{
+			Body * bodyA = SensorPairs[i].Bodies[0];
+			Body * bodyB = SensorPairs[i].Bodies[1];
+			if( Collsion.TestOverlap(bodyA, bodyB) )
+			{
+				GOCId idA = bodyA->GetOwner()->GetId();
+				GOCId idB = bodyB->GetOwner()->GetId();
+				SensorOverlaps.insert( std::make_pair( std::min(idA,idB), std::max(idA,idB) ) );
 			}
 		}
 	}
 
+	void Physics::PublishSensorEvents()
+	{
+		//New overlaps are enter events
+		for(SensorOverlapSet::iterator it=SensorOverlaps.begin();it!=SensorOverlaps.end();++it)
+		{
+			if( PrevSensorOverlaps.find(*it) == PrevSensorOverlaps.end() )
+			{
+				SensorEvent event = { Mid::SensorEnter, it->first, it->second };
+				SensorEvents.push_back(event);
+			}
+		}
+
+		//Overlaps that ended are exit events
+		for(SensorOverlapSet::iterator it=PrevSensorOverlaps.begin();it!=PrevSensorOverlaps.end();++it)
+		{
+			if( SensorOverlaps.find(*it) == SensorOverlaps.end() )
+			{
+				SensorEvent event = { Mid::SensorExit, it->first, it->second };
+				SensorEvents.push_back(event);
+			}
+		}
+	}
 
+	void Physics::ResolveContacts(float dt)
+	{
+		//Both solvers work directly on the narrow phase contacts
+		if( ContactSolver == SolverConstraints )
+		{
+			Solver.SetContacts(Narrow.Contacts);
+			Solver.Solve(dt);
+		}
+		else
+		{
+			Resolver.PenetrationResolvePercentage = PenetrationResolvePercentage;
+			Resolver.ResolveContacts(Narrow.Contacts, dt);
+		}
+	}
 
-	void Physics::PublishResultsImpulses()
+	void Physics::PublishResults(ContactArray& contacts)
 	{
 		//Commit all physics updates
 		for(BodyIterator it=Bodies.begin();it!=Bodies.end();++it)
@@ -119,124 +270,442 @@ namespace Framework
 			(it)->PublishResults();
 		}
 
-		//Broadcast physics collision messages AFTER physics
-		//has update the bodies
-		for(unsigned i=0;i<Contacts.NumberOfContacts;++i)
+		//Collision messages are sent AFTER physics has updated
+		//the bodies, once DeliverEvents is called
+		for(unsigned i=0;i<contacts.size();++i)
 		{
-			BodyManifold* contact = &Contacts.contactArray[i];
-			MessageCollide messageCollide;
-			messageCollide.ContactNormal = contact->Normal;
-			messageCollide.Impulse = contact->ContactImpulse;
-			messageCollide.CollidedWith = contact->Bodies[1]->GetOwner();
-			contact->Bodies[0]->GetOwner()->SendMessage( &messageCollide );
+			BodyManifold* contact = &contacts[i];
+			GOCId idA = contact->Bodies[0]->GetOwner()->GetId();
+			GOCId idB = contact->Bodies[1] ? contact->Bodies[1]->GetOwner()->GetId() : 0;
+			CollisionEvent event = { idA, idB, contact->Normal, contact->ContactImpulse };
+			CollisionEvents.push_back(event);
 			if( contact->Bodies[1] != NULL )
 			{
-				messageCollide.ContactNormal = -contact->Normal;
-				messageCollide.Impulse = contact->ContactImpulse;
-				messageCollide.CollidedWith = contact->Bodies[0]->GetOwner();
-				contact->Bodies[1]->GetOwner()->SendMessage( &messageCollide );
+				CollisionEvent reverse = { idB, idA, -contact->Normal, contact->ContactImpulse };
+				CollisionEvents.push_back(reverse);
 			}
 		}
 	}
 
-  void Physics::PublishResultsConstraints()
-  {
-    //Commit all physics updates
-    for(BodyIterator it=Bodies.begin();it!=Bodies.end();++it)
-    {
-      (it)->PublishResults();
-    }
-
-    //Broadcast physics collision messages AFTER physics
-    //has update the bodies
-    for(unsigned i=0;i<Solver.NumberOfContacts;++i)
-    {
-      ContactConstraint* contact = &Solver.contactArray[i];
-      MessageCollide messageCollide;
-      messageCollide.ContactNormal = contact->ContactPoint.Normal;
-      messageCollide.Impulse = contact->ContactPoint.ContactImpulse;
-      messageCollide.CollidedWith = contact->ContactPoint.Bodies[1]->GetOwner();
-      contact->Bodies[0]->GetOwner()->SendMessage( &messageCollide );
-      if( contact->Bodies[1] != NULL )
-      {
-        messageCollide.ContactNormal = -contact->ContactPoint.Normal;
-        messageCollide.Impulse = contact->ContactPoint.ContactImpulse;
-        messageCollide.CollidedWith = contact->ContactPoint.Bodies[0]->GetOwner();
-        contact->Bodies[1]->GetOwner()->SendMessage( &messageCollide );
-      }
-    }
-  }
+	void Physics::DeliverEvents()
+	{
+		for(unsigned i=0;i<CollisionEvents.size();++i)
+		{
+			CollisionEvent& event = CollisionEvents[i];
+			GOC * object = FACTORY->GetObjectWithId(event.Object);
+			if( object == NULL )
+				continue;
+			MessageCollide messageCollide;
+			messageCollide.ContactNormal = event.Normal;
+			messageCollide.Impulse = event.Impulse;
+			messageCollide.CollidedWith = FACTORY->GetObjectWithId(event.Other);
+			object->SendMessage( &messageCollide );
+		}
+		CollisionEvents.clear();
 
-	void Physics::StepImpulses(float dt)
+		for(unsigned i=0;i<SensorEvents.size();++i)
+		{
+			//Objects are looked up by id because either may have been
+			//destroyed since the overlap started
+			GOC * objectA = FACTORY->GetObjectWithId(SensorEvents[i].ObjectA);
+			GOC * objectB = FACTORY->GetObjectWithId(SensorEvents[i].ObjectB);
+			MessageSensor message(SensorEvents[i].Id);
+			if( objectA )
+			{
+				message.Other = objectB;
+				objectA->SendMessage( &message );
+			}
+			if( objectB )
+			{
+				message.Other = objectA;
+				objectB->SendMessage( &message );
+			}
+		}
+		SensorEvents.clear();
+	}
+
+	void Physics::SimulateActive(float dt, bool activeOnly)
 	{
+		if( ContactSolver == SolverSubstepped )
+		{
+			SimulateSubsteps(dt, activeOnly);
+			return;
+		}
+		Solver.SkipSubsteps();
 
 		IntegrateBodies(dt);
 
-		Contacts.Reset();
+		DetectContacts(activeOnly);
 
-		DetectContactsImpulses(dt);
+		ResolveContacts(dt);
+	}
 
-		Contacts.ResolveContacts(dt);
+	void Physics::SimulateSubsteps(float dt, bool activeOnly)
+	{
+		//Static and kinematic bodies move once for the whole step
+		for(BodyIterator it=Bodies.begin();it!=Bodies.end();++it)
+		{
+			if( it->LodActive && !it->IsDynamic() )
+				it->Integrate(dt);
+			else if( it->LodActive )
+				it->PrevPosition = it->Position;
+		}
 
-		PublishResultsImpulses();
+		//Contacts are only found once per step. Each substep moves the
+		//depths by the relative velocity at the contact points instead of
+		//running the narrow phase again, which is accurate for the small
+		//motions within one step.
+		DetectContacts(activeOnly);
+		Solver.SetContacts(Narrow.Contacts);
+		Solver.BeginSubsteps();
+
+		unsigned substeps = Substeps > 0 ? Substeps : 1;
+		float h = dt / substeps;
+		for(unsigned s=0;s<substeps;++s)
+		{
+			for(BodyIterator it=Bodies.begin();it!=Bodies.end();++it)
+			{
+				if( it->LodActive )
+					it->IntegrateVelocity(h);
+			}
+
+			Solver.SolveSubstep(h);
+
+			for(BodyIterator it=Bodies.begin();it!=Bodies.end();++it)
+			{
+				if( it->LodActive )
+					it->IntegratePosition(h);
+			}
+
+			for(unsigned i=0;i<Narrow.Contacts.size();++i)
+			{
+				BodyManifold& contact = Narrow.Contacts[i];
+				contact.Depth -= contact.CalculateSeparatingVelocity() * h;
+			}
+		}
 
+		for(BodyIterator it=Bodies.begin();it!=Bodies.end();++it)
+		{
+			if( it->LodActive )
+				it->AccumulatedForce = Vec2(0,0);
+		}
 	}
 
-  void Physics::StepConstraints(float dt)
-  {
+	//Spread the low 16 bits of the value to the even bits
+	static unsigned SpreadBits(unsigned value)
+	{
+		value &= 0x0000ffff;
+		value = (value | (value << 8)) & 0x00ff00ff;
+		value = (value | (value << 4)) & 0x0f0f0f0f;
+		value = (value | (value << 2)) & 0x33333333;
+		value = (value | (value << 1)) & 0x55555555;
+		return value;
+	}
 
-    IntegrateBodies(dt);
+	void Physics::ReorderBodies()
+	{
+		if( Bodies.begin() == Bodies.end() )
+			return;
 
-    Solver.ClearContacts();
+		//Quantize positions within the bounds of all bodies
+		Vec2 minPosition = Bodies.begin()->Position;
+		Vec2 maxPosition = minPosition;
+		for(BodyIterator it=Bodies.begin();it!=Bodies.end();++it)
+		{
+			minPosition.x = Min(minPosition.x, it->Position.x);
+			minPosition.y = Min(minPosition.y, it->Position.y);
+			maxPosition.x = Max(maxPosition.x, it->Position.x);
+			maxPosition.y = Max(maxPosition.y, it->Position.y);
+		}
+		Vec2 size = maxPosition - minPosition;
+		float scaleX = size.x > 0.0f ? 65535.0f / size.x : 0.0f;
+		float scaleY = size.y > 0.0f ? 65535.0f / size.y : 0.0f;
 
-    DetectContactsConstraints(dt);
+		BodyOrder.clear();
+		unsigned index = 0;
+		for(BodyIterator it=Bodies.begin();it!=Bodies.end();++it)
+		{
+			BodyOrderEntry entry;
+			unsigned x = unsigned( (it->Position.x - minPosition.x) * scaleX );
+			unsigned y = unsigned( (it->Position.y - minPosition.y) * scaleY );
+			entry.Code = SpreadBits(x) | (SpreadBits(y) << 1);
+			//Ties keep their current order
+			entry.Index = index++;
+			entry.OrderBody = it;
+			BodyOrder.push_back(entry);
+		}
+		std::sort(BodyOrder.begin(), BodyOrder.end());
 
-    Solver.Solve(dt);
+		//Relink the list in the new order
+		while( Bodies.pop_front() != NULL );
+		for(unsigned i=0;i<BodyOrder.size();++i)
+			Bodies.push_back(BodyOrder[i].OrderBody);
 
-    PublishResultsConstraints();
+		//Queries return bodies in list order
+		BroadPhaseDirty = true;
+	}
 
-  }
+	void Physics::Step(float dt)
+	{
+		++StepCount;
+		SensorPairs.clear();
 
-  void Physics::Update(float dt)
-  {
-    //UpdateConstraints(dt);
-    UpdateImpulses(dt);
-  }
+		//The list starts in creation order and bodies drift apart over
+		//time, so it is sorted on the first step and again now and then.
+		//The sort is cheap next to a step and is spread over many.
+		if( ReorderInterval > 0 && (StepCount - 1) % ReorderInterval == 0 )
+			ReorderBodies();
 
-  void Physics::UpdateImpulses(float dt)
-  {
-    const float TimeStep = 1.0f / 60.0f;
-
-    if( !StepModeActive )
-    {
-      TimeAccumulation += dt;
-      TimeAccumulation = std::min( TimeAccumulation , TimeStep *5 );
-      if( TimeAccumulation > TimeStep )
-      {
-        TimeAccumulation-= TimeStep;
-        StepImpulses( TimeStep );
-      }
-
-    }
-    else
-    {
-      TimeAccumulation = 0.0f;
-      if( AdvanceStep )
-      {
-        StepImpulses( TimeStep );
-        AdvanceStep = false;
-      }
-    }
-
-    if( DebugDrawingActive )
-      DebugDraw();
+		bool useLod = LodEnabled && GatherInterestPoints();
+		if( useLod )
+		{
+			StepLod(dt);
+		}
+		else
+		{
+			//Everything is simulated at the full rate
+			for(BodyIterator it=Bodies.begin();it!=Bodies.end();++it)
+			{
+				it->LodActive = true;
+				it->LodLag = 0;
+			}
+			SimulateActive(dt, false);
+		}
 
-  }
+		//Pairs that are no longer near each other lose their cache
+		SatCaches.Prune(StepCount);
+
+		DetectSensors();
+
+		//Particles are solved after the bodies so they rest on them
+		Granular.Step(dt, Gravity, Bodies);
+
+		//Bodies were moved by the solver
+		BroadPhaseDirty = true;
 
-	void Physics::UpdateConstraints(float dt)
+		PublishResults( useLod ? LodContacts : Narrow.Contacts );
+
+		PublishSensorEvents();
+
+		if( Exporter )
+			Exporter->Publish(Bodies, dt);
+
+	}
+
+	void Physics::AddInterestPoint(Vec2Param point)
+	{
+		InterestPoints.push_back(point);
+	}
+
+	void Physics::ClearInterestPoints()
+	{
+		InterestPoints.clear();
+	}
+
+	bool Physics::GatherInterestPoints()
+	{
+		LodPoints = InterestPoints;
+		if( LodUseCamera && HasCamera )
+			LodPoints.push_back(CameraPosition);
+		return !LodPoints.empty();
+	}
+
+	unsigned Physics::FindIsland(unsigned index)
+	{
+		while( IslandParent[index] != index )
+		{
+			IslandParent[index] = IslandParent[IslandParent[index]];
+			index = IslandParent[index];
+		}
+		return index;
+	}
+
+	bool Physics::IsIslandDue(unsigned island)
+	{
+		//Tiers are aligned so islands of a tier always step together
+		unsigned interval = 1u << IslandTier[island];
+		return LodStep % interval == 0;
+	}
+
+	void Physics::BuildIslands()
+	{
+		//Number the dynamic bodies
+		IslandBodies.clear();
+		for(BodyIterator it=Bodies.begin();it!=Bodies.end();++it)
+		{
+			if( it->IsDynamic() )
+			{
+				it->IslandIndex = IslandBodies.size();
+				IslandBodies.push_back(it);
+			}
+		}
+
+		unsigned count = IslandBodies.size();
+		IslandParent.resize(count);
+		for(unsigned i=0;i<count;++i)
+			IslandParent[i] = i;
+
+		//Bodies that may touch during the longest step share an island.
+		//Static and kinematic bodies do not join islands or the ground
+		//would put every body in one island.
+		Broad.Build(Bodies, LodMargin);
+		BroadPhaseDirty = true;
+		Broad.FindPairs(QueryPairs);
+		for(unsigned i=0;i<QueryPairs.size();++i)
+		{
+			Body * bodyA = QueryPairs[i].Bodies[0];
+			Body * bodyB = QueryPairs[i].Bodies[1];
+			if( bodyA->IsSensor || bodyB->IsSensor )
+			{
+				if( IsSensorPair(bodyA, bodyB) )
+					SensorPairs.push_back(QueryPairs[i]);
+			}
+			else if( bodyA->IsDynamic() && bodyB->IsDynamic() )
+				IslandParent[FindIsland(bodyA->IslandIndex)] = FindIsland(bodyB->IslandIndex);
+		}
+
+		ConstraintPairs.clear();
+		Solver.GetConnectedPairs(ConstraintPairs);
+		for(unsigned i=0;i<ConstraintPairs.size();++i)
+		{
+			Body * bodyA = ConstraintPairs[i].Bodies[0];
+			Body * bodyB = ConstraintPairs[i].Bodies[1];
+			if( bodyA->IsDynamic() && bodyB->IsDynamic() )
+				IslandParent[FindIsland(bodyA->IslandIndex)] = FindIsland(bodyB->IslandIndex);
+		}
+
+		//An island runs at the rate of its body nearest an interest point
+		IslandTier.assign(count, LodTierCount - 1);
+		for(unsigned i=0;i<count;++i)
+		{
+			float nearestSq = LengthSquared(IslandBodies[i]->Position - LodPoints[0]);
+			for(unsigned p=1;p<LodPoints.size();++p)
+				nearestSq = std::min(nearestSq, LengthSquared(IslandBodies[i]->Position - LodPoints[p]));
+
+			unsigned tier = 0;
+			while( tier < LodTierCount - 1 && nearestSq > LodDistances[tier] * LodDistances[tier] )
+				++tier;
+
+			unsigned island = FindIsland(i);
+			IslandTier[island] = std::min(IslandTier[island], tier);
+		}
+	}
+
+	void Physics::RunLodPass(float dt, unsigned steps)
+	{
+		SimulateActive(dt * steps, true);
+		LodContacts.insert(LodContacts.end(), Narrow.Contacts.begin(), Narrow.Contacts.end());
+
+		for(unsigned i=0;i<IslandBodies.size();++i)
+		{
+			if( IslandBodies[i]->LodActive )
+				IslandBodies[i]->LodLag -= steps;
+		}
+	}
+
+	void Physics::StepLod(float dt)
+	{
+		++LodStep;
+		LodContacts.clear();
+		BuildIslands();
+
+		//Static and kinematic bodies always move at the full rate. They are
+		//moved up front and are only obstacles in the passes.
+		for(BodyIterator it=Bodies.begin();it!=Bodies.end();++it)
+		{
+			if( !it->IsDynamic() )
+				it->Integrate(dt);
+			else
+				++it->LodLag;
+			it->LodActive = false;
+		}
+
+		unsigned count = IslandBodies.size();
+		IslandMaxLag.resize(count);
+		IslandNextLag.resize(count);
+
+		//Handoff: an island that is due can hold bodies that came from a
+		//slower island and are behind the rest. The bodies furthest behind
+		//are simulated on their own until they reach the next group, so
+		//bodies only ever interact when they are at the same time.
+		for(;;)
+		{
+			for(unsigned i=0;i<count;++i)
+			{
+				IslandMaxLag[i] = 0;
+				IslandNextLag[i] = 0;
+			}
+
+			for(unsigned i=0;i<count;++i)
+			{
+				unsigned island = FindIsland(i);
+				unsigned lag = IslandBodies[i]->LodLag;
+				if( lag > IslandMaxLag[island] )
+				{
+					IslandNextLag[island] = IslandMaxLag[island];
+					IslandMaxLag[island] = lag;
+				}
+				else if( lag < IslandMaxLag[island] && lag > IslandNextLag[island] )
+					IslandNextLag[island] = lag;
+			}
+
+			//Take the shortest catch up of any island this pass
+			unsigned passSteps = 0;
+			for(unsigned i=0;i<count;++i)
+			{
+				if( IslandParent[i] == i && IsIslandDue(i) && IslandNextLag[i] > 0 )
+				{
+					unsigned steps = IslandMaxLag[i] - IslandNextLag[i];
+					if( passSteps == 0 || steps < passSteps )
+						passSteps = steps;
+				}
+			}
+
+			if( passSteps == 0 )
+				break;
+
+			for(unsigned i=0;i<count;++i)
+			{
+				unsigned island = FindIsland(i);
+				IslandBodies[i]->LodActive = IsIslandDue(island) && IslandNextLag[island] > 0 &&
+					IslandBodies[i]->LodLag == IslandMaxLag[island] &&
+					IslandMaxLag[island] - IslandNextLag[island] == passSteps;
+			}
+
+			RunLodPass(dt, passSteps);
+		}
+
+		//Every due island is now at one time. Islands with the same lag
+		//(normally the islands of one tier) are stepped together.
+		for(;;)
+		{
+			unsigned passSteps = 0;
+			for(unsigned i=0;i<count;++i)
+			{
+				unsigned lag = IslandBodies[i]->LodLag;
+				if( lag > 0 && IsIslandDue(FindIsland(i)) && (passSteps == 0 || lag < passSteps) )
+					passSteps = lag;
+			}
+
+			if( passSteps == 0 )
+				break;
+
+			for(unsigned i=0;i<count;++i)
+				IslandBodies[i]->LodActive = IslandBodies[i]->LodLag == passSteps && IsIslandDue(FindIsland(i));
+
+			RunLodPass(dt, passSteps);
+		}
+	}
+
+	void Physics::Update(float dt)
 	{
 		const float TimeStep = 1.0f / 60.0f;
 
+		//Step only uses the camera position copied here
+		HasCamera = GRAPHICS && GRAPHICS->CurrentCamera;
+		if( HasCamera )
+			CameraPosition = GRAPHICS->CurrentCamera->transform->Position;
+
 		if( !StepModeActive )
 		{
 			TimeAccumulation += dt;
@@ -244,7 +713,7 @@ namespace Framework
 			if( TimeAccumulation > TimeStep )
 			{
 				TimeAccumulation-= TimeStep;
-				StepConstraints( TimeStep );
+				Step( TimeStep );
 			}
 
 		}
@@ -253,19 +722,28 @@ namespace Framework
 			TimeAccumulation = 0.0f;
 			if( AdvanceStep )
 			{
-				StepConstraints( TimeStep );
+				Step( TimeStep );
 				AdvanceStep = false;
 			}
 		}
 
+		DeliverEvents();
+
 		if( DebugDrawingActive )
 			DebugDraw();
-	
+
 	}
 
+  void Physics::AddBody(Body* body)
+  {
+    Bodies.push_back(body);
+    BroadPhaseDirty = true;
+  }
+
   void Physics::RemoveBody(Body* body)
   {
     Bodies.erase(body);
+    BroadPhaseDirty = true;
     Solver.RemoveConstraintsWithBody(body);
   }
 
@@ -280,12 +758,71 @@ namespace Framework
 		return NULL;
 	}
 
+	unsigned Physics::ApplyRadialImpulse(const RadialImpulse& impulse)
+	{
+		UpdateBroadPhase();
+
+		Aabb region;
+		region.Min = impulse.Center - Vec2(impulse.Radius,impulse.Radius);
+		region.Max = impulse.Center + Vec2(impulse.Radius,impulse.Radius);
+		QueryResults.clear();
+		Broad.Query(region, QueryResults);
+
+		unsigned affected = 0;
+		for(unsigned i=0;i<QueryResults.size();++i)
+		{
+			Body * body = QueryResults[i];
+			if( !body->IsDynamic() || body->IsSensor )
+				continue;
+
+			Vec2 offset = body->Position - impulse.Center;
+			float distanceSq = LengthSquared(offset);
+			if( distanceSq > impulse.Radius * impulse.Radius )
+				continue;
+
+			//A body right at the center is pushed straight up
+			float distance = 0.0f;
+			if( distanceSq > 0.0f )
+				distance = Normalize(offset);
+			else
+				offset = Vec2(0,1);
+
+			if( impulse.RequireLineOfSight )
+			{
+				//Any static body in the region that the segment
+				//passes through shields the body
+				bool blocked = false;
+				for(unsigned j=0;j<QueryResults.size() && !blocked;++j)
+				{
+					Body * blocker = QueryResults[j];
+					if( blocker->IsStatic && !blocker->IsSensor )
+						blocked = blocker->BodyShape->TestSegment(impulse.Center, body->Position);
+				}
+				if( blocked )
+					continue;
+			}
+
+			float scale = 1.0f;
+			float t = distance / impulse.Radius;
+			if( impulse.Falloff == FalloffLinear )
+				scale = 1.0f - t;
+			else if( impulse.Falloff == FalloffQuadratic )
+				scale = (1.0f - t) * (1.0f - t);
+
+			body->Velocity += offset * (impulse.Strength * scale * body->InvMass);
+			++affected;
+		}
+
+		return affected;
+	}
+
 	void Physics::DebugDraw()
 	{
 		for(BodyIterator it=Bodies.begin();it!=Bodies.end();++it)
 		{
 			it->DebugDraw();
 		}
+		Solver.DebugDraw();
 	}
 
 	void Physics::SendMessage(Message * m )
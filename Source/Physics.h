@@ -15,6 +15,11 @@
 #include "Body.h"
 #include "Resolution.h"
 #include "ConstraintSolver.h"
+#include "NarrowPhase.h"
+#include "BroadPhase.h"
+#include "SatCacheTable.h"
+#include "StateExport.h"
+#include "Granular.h"
 
 namespace Framework
 {
@@ -30,41 +35,218 @@ namespace Framework
 		GOC * CollidedWith;
 	};
 
+	///Message sent to both objects when a body starts (SensorEnter) or
+	///stops (SensorExit) overlapping a sensor body.
+	class MessageSensor : public Message
+	{
+	public:
+		MessageSensor(Mid::MessageIdType id) : Message(id) {};
+		//The other object in the overlap. NULL if it has been destroyed.
+		GOC * Other;
+	};
+
+	///How the strength of a radial impulse drops off with distance.
+	enum RadialFalloff
+	{
+		FalloffConstant,
+		FalloffLinear,
+		FalloffQuadratic
+	};
+
+	///Description of an area of effect impulse such as an explosion.
+	struct RadialImpulse
+	{
+		RadialImpulse() : Radius(0), Strength(0), Falloff(FalloffLinear), RequireLineOfSight(false) {};
+		Vec2 Center;
+		float Radius;
+		///Impulse applied at the center.
+		float Strength;
+		RadialFalloff Falloff;
+		///If true bodies hidden behind static bodies are not affected.
+		bool RequireLineOfSight;
+	};
+
 	///	Basic 2D iterative impulse physics engine system.
 	/// Provides the Body Component.
+	/// Each instance is an independent world with its own bodies, contacts
+	/// and settings. The instance added to the engine is the default world
+	/// (PHYSICS). Other worlds are stepped by a WorldScheduler.
+	/// With level of detail enabled, islands of nearby bodies far from the
+	/// camera and interest points are stepped less often with a larger dt.
 	class Physics : public ISystem
 	{
 	public:
 		Physics();
+		~Physics();
     virtual void Update(float dt);
-    virtual void UpdateImpulses(float dt);
-		virtual void UpdateConstraints(float dt);
+    void AddBody(Body* body);
     void RemoveBody(Body* body);
 		virtual std::string GetName(){return "Physics";}
+		///Moves bodies and their transforms and sends collision messages to
+		///objects. The camera is read for level of detail.
+		virtual unsigned GetReads(){return SystemData::Bodies | SystemData::Transforms | SystemData::Sprites;}
+		virtual unsigned GetWrites(){return SystemData::Bodies | SystemData::Transforms | SystemData::Objects | SystemData::DebugLines;}
 		void SendMessage(Message * m );
 		GOC * TestPoint(Vec2 testPosition);
+		///Push all dynamic bodies within the radius away from the center.
+		///Returns the number of bodies affected.
+		unsigned ApplyRadialImpulse(const RadialImpulse& impulse);
 		void Initialize();
+		///Start the world without registering the Body component. Worlds
+		///stepped by a WorldScheduler should use a thread count of one.
+		void InitializeWorld(unsigned threadCount);
+		///Advance the world by one fixed time step. Only touches this
+		///world's bodies and their transforms, so different worlds can be
+		///stepped at the same time. Collision and sensor messages are held
+		///until DeliverEvents.
+		void Step(float dt);
+		///Send the collision and sensor messages of the steps since the
+		///last call. Must be called from one thread at a time since the
+		///objects respond to them.
+		void DeliverEvents();
+		///Create an object from a data file with its body in this world.
+		GOC * CreateObject(const std::string& filename, Vec2Param position, float rotation);
     void AddConstraint(Constraint* constraint);
     void RemoveConstraint(Constraint* constraint);
+		///Add a point that keeps nearby bodies at full rate (players, AI).
+		void AddInterestPoint(Vec2Param point);
+		void ClearInterestPoints();
 	private:
 		void IntegrateBodies(float dt);
-    void DetectContactsImpulses(float dt);
-		void DetectContactsConstraints(float dt);
-		void PublishResultsImpulses();
-    void PublishResultsConstraints();
+		void UpdateBroadPhase();
+		void BuildCandidatePairs(bool activeOnly);
+		void CountContacts();
+		void DetectSensors();
+		void PublishSensorEvents();
+		void DetectContacts(bool activeOnly);
+		void ResolveContacts(float dt);
+		void PublishResults(ContactArray& contacts);
+		//Level of detail
+		bool GatherInterestPoints();
+		void BuildIslands();
+		unsigned FindIsland(unsigned index);
+		bool IsIslandDue(unsigned island);
+		void StepLod(float dt);
+		void RunLodPass(float dt, unsigned steps);
+		void SimulateActive(float dt, bool activeOnly);
+		void SimulateSubsteps(float dt, bool activeOnly);
+		void ReorderBodies();
 		void DebugDraw();
-		void StepImpulses(float dt);
-    void StepConstraints(float dt);
 		bool DebugDrawingActive;
 		float TimeAccumulation;
 		CollsionDatabase Collsion;
-		ContactSet Contacts;
+		BroadPhase Broad;
+		//Set when bodies are added, removed or moved since the last build
+		bool BroadPhaseDirty;
+		BodyPairArray QueryPairs;
+		std::vector<Body*> QueryResults;
+		BodyPairArray CandidatePairs;
+		BodyPairArray SensorPairs;
+		//Separating axis results for box pairs by object id
+		SatCacheTable SatCaches;
+		unsigned StepCount;
+		//Overlapping sensor pairs by object id for this and the last step
+		typedef std::set< std::pair<GOCId,GOCId> > SensorOverlapSet;
+		SensorOverlapSet SensorOverlaps;
+		SensorOverlapSet PrevSensorOverlaps;
+		NarrowPhase Narrow;
+		//Messages found by Step and sent by DeliverEvents. Objects are
+		//stored by id since they may be destroyed in between.
+		struct CollisionEvent
+		{
+			GOCId Object;
+			GOCId Other;
+			Vec2 Normal;
+			float Impulse;
+		};
+		std::vector<CollisionEvent> CollisionEvents;
+		struct SensorEvent
+		{
+			Mid::MessageIdType Id;
+			GOCId ObjectA;
+			GOCId ObjectB;
+		};
+		std::vector<SensorEvent> SensorEvents;
+		//The camera is read by Update, never by Step
+		bool HasCamera;
+		Vec2 CameraPosition;
+		//Level of detail state. Islands are stored as a union find over
+		//the dynamic bodies, the tier is kept on the root of each island.
+		std::vector<Vec2> LodPoints;
+		std::vector<Body*> IslandBodies;
+		std::vector<unsigned> IslandParent;
+		std::vector<unsigned> IslandTier;
+		std::vector<unsigned> IslandMaxLag;
+		std::vector<unsigned> IslandNextLag;
+		BodyPairArray ConstraintPairs;
+		ContactArray LodContacts;
+		unsigned LodStep;
+		ContactSet Resolver;
     ConstraintSolver Solver;
+		//Scratch for sorting the body list by Morton code
+		struct BodyOrderEntry
+		{
+			unsigned Code;
+			unsigned Index;
+			Body * OrderBody;
+			bool operator<(const BodyOrderEntry& other) const
+			{
+				if( Code != other.Code ) return Code < other.Code;
+				return Index < other.Index;
+			}
+		};
+		std::vector<BodyOrderEntry> BodyOrder;
 
 	public:
+		///Which solver resolves the contacts. Both work in place on the
+		///contacts from the narrow phase.
+		enum ContactSolverType
+		{
+			//Iterative impulses and position correction (Resolution.cpp)
+			SolverImpulses,
+			//Sequential impulse constraints, also solves joints (ConstraintSolver.cpp)
+			SolverConstraints,
+			//The constraint solver run once per substep with the bodies
+			//integrated between substeps. Stiffer stacks and joints for
+			//about the same cost as the iterations it replaces.
+			SolverSubstepped
+		};
+		ContactSolverType ContactSolver;
+		///Substeps per step for SolverSubstepped.
+		unsigned Substeps;
+
 		bool AdvanceStep;
 		bool StepModeActive;
 
+		//Circle particles simulated alongside the bodies
+		GranularSolver Granular;
+
+		//Optional exporter the body state is published to after each step
+		StateExporter * Exporter;
+
+		///Number of slower tiers. Tier n steps every 2^n base steps.
+		enum { LodTierCount = 4 };
+		///Step distant islands at reduced rates.
+		bool LodEnabled;
+		///Use the graphics camera as an interest point. Only the default
+		///world reads the camera, scheduled worlds ignore this.
+		bool LodUseCamera;
+		///Distance from the nearest interest point where each slower tier starts.
+		float LodDistances[LodTierCount - 1];
+		///Bounds are grown by this much when finding islands so bodies that
+		///may touch during a long step share an island.
+		float LodMargin;
+		///Points other than the camera that keep bodies at full rate.
+		std::vector<Vec2> InterestPoints;
+
+		///Steps between sorting the body list by Morton code of position,
+		///starting with the first step, zero to never sort. The pair, contact and solver order all follow
+		///the body list, so keeping bodies that are near each other next to
+		///each other in the list keeps the solver working on nearby data.
+		///Bodies are only relinked, never moved, so pointers and ids stay
+		///valid.
+		unsigned ReorderInterval;
+
 		typedef ObjectLinkList<Body>::iterator BodyIterator;
 		ObjectLinkList<Body> Bodies;
 
@@ -82,6 +264,6 @@ namespace Framework
 
 	};
 
-	//A global pointer to the Physics system, used to access it globally.
+	//A global pointer to the default physics world, used to access it globally.
 	extern Physics* PHYSICS;
 }
\ No newline at end of file
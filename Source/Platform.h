@@ -0,0 +1,20 @@
+///////////////////////////////////////////////////////////////////////////////////////
+///
+///	\file Platform.h
+///	Selects the platform configuration the engine is built for.
+///
+///	Authors: Chris Peters
+///	Copyright 2011, Digipen Institute of Technology
+///
+///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+//G_HEADLESS builds the engine without a window or a renderer. The null
+//systems (NullPlatform, NullGraphics) stand in for WindowsSystem and the
+//Direct3D Graphics and HeadlessMain is the entry point instead of WinMain.
+//Headless is the only configuration on platforms other than windows, and
+//can be defined in the project to run headless on windows. CMakeLists.txt
+//at the root of the repository builds it.
+#if !defined(G_HEADLESS) && !defined(_WIN32)
+#define G_HEADLESS
+#endif
@@ -1,16 +1,27 @@
 ///////////////////////////////////////////////////////////////////////////////////////
 ///
 ///	\file Precompiled.h
-///	Precompiled Header file which includes the large unchanging header of stl, windows
-///	DirectX. These are 'precompiled once' and used for every cpp. This helps to 
-///	greatly reduce compile times.
+///	Precompiled Header file which includes the large unchanging header of stl and
+///	windows. These are 'precompiled once' and used for every cpp. This helps to 
+///	greatly reduce compile times. DirectX is only included by the files that
+///	render so the engine can be built headless (see Platform.h).
 ///
 ///	Authors: Chris Peters
 ///	Copyright 2010, Digipen Institute of Technology
 ///
 ///////////////////////////////////////////////////////////////////////////////////////
+#include "Platform.h"
+#ifdef _WIN32
 #include "WindowsIncludes.h"
-#include "DirectXIncludes.h"
+#else
+//The C runtime headers windows.h brings in
+#include <cstddef>
+#include <cstdlib>
+#include <cstdio>
+#include <cstdarg>
+#include <cstring>
+#include <climits>
+#endif
 #include "Containers.h"
 #include "DebugDiagnostic.h"
 
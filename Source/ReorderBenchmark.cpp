@@ -0,0 +1,134 @@
+///////////////////////////////////////////////////////////////////////////////////////
+///
+///	\file ReorderBenchmark.cpp
+///	Measures sorting the body list by position (Physics::ReorderInterval).
+///
+///	Authors: Chris Peters
+///	Copyright 2011, Digipen Institute of Technology
+///
+///////////////////////////////////////////////////////////////////////////////////////
+#include "Precompiled.h"
+#include "ReorderBenchmark.h"
+#include "Factory.h"
+#include "Transform.h"
+#include "FrameTiming.h"
+#include <algorithm>
+
+namespace Framework
+{
+	const float BallRadius = 10.0f;
+	const float PileWallHalfThickness = 20.0f;
+
+	ReorderBenchmark::ReorderBenchmark()
+	{
+		Columns = 100;
+		Rows = 40;
+		StepCount = 300;
+		Repeats = 3;
+		TimeStep = 1.0f / 60.0f;
+		ReorderInterval = 120;
+	}
+
+	Body * ReorderBenchmark::AddBody(Physics* world, Vec2Param position, Shape* shape, float density)
+	{
+		GOC * object = FACTORY->CreateEmptyComposition();
+		Transform * transform = new Transform();
+		transform->Position = position;
+		object->AddComponent(CT_Transform, transform);
+
+		Body * body = new Body(world);
+		body->Density = density;
+		body->Friction = 0.4f;
+		body->Restitution = 0.0f;
+		body->BodyShape = shape;
+		object->AddComponent(CT_Body, body);
+
+		object->Initialize();
+		Objects.push_back(object);
+		return body;
+	}
+
+	float ReorderBenchmark::Run(unsigned reorderInterval)
+	{
+		Physics * world = new Physics();
+		world->InitializeWorld(1);
+		//Every body is simulated every step
+		world->LodEnabled = false;
+		world->ReorderInterval = reorderInterval;
+
+		float spacing = BallRadius * 2.0f;
+		float halfWidth = Columns * spacing * 0.5f;
+		float height = Rows * spacing;
+
+		ShapeAAB * floor = new ShapeAAB();
+		floor->Extents = Vec2(halfWidth + PileWallHalfThickness * 2.0f, PileWallHalfThickness);
+		AddBody(world, Vec2(0, -PileWallHalfThickness), floor, 0.0f);
+		for(int side=-1;side<=1;side+=2)
+		{
+			ShapeAAB * wall = new ShapeAAB();
+			wall->Extents = Vec2(PileWallHalfThickness, height);
+			AddBody(world, Vec2(side * (halfWidth + PileWallHalfThickness), height), wall, 0.0f);
+		}
+
+		//Shuffle the grid cells with a fixed seed so every run builds the
+		//pile in the same order
+		unsigned count = Columns * Rows;
+		std::vector<unsigned> cells(count);
+		for(unsigned i=0;i<count;++i)
+			cells[i] = i;
+		unsigned seed = 12345;
+		for(unsigned i=count;i>1;--i)
+		{
+			seed = seed * 1103515245u + 12345u;
+			std::swap(cells[i - 1], cells[(seed >> 8) % i]);
+		}
+
+		for(unsigned i=0;i<count;++i)
+		{
+			unsigned x = cells[i] % Columns;
+			unsigned y = cells[i] / Columns;
+			ShapeCircle * circle = new ShapeCircle();
+			circle->Radius = BallRadius;
+			AddBody(world, Vec2(x * spacing - halfWidth + BallRadius, y * spacing + BallRadius), circle, 1.0f);
+		}
+
+		TimeNs start = GetTimeNs();
+		for(unsigned i=0;i<StepCount;++i)
+		{
+			world->Step(TimeStep);
+			world->DeliverEvents();
+		}
+		float milliseconds = NsToMilliseconds(GetTimeNs() - start);
+
+		//Leave the world now so the bodies do not reach back into it
+		//when the factory deletes the objects later
+		for(unsigned i=0;i<Objects.size();++i)
+		{
+			Body * body = Objects[i]->has(Body);
+			world->RemoveBody(body);
+			body->World = NULL;
+			FACTORY->Destroy(Objects[i]);
+		}
+		Objects.clear();
+		delete world;
+
+		return milliseconds;
+	}
+
+	void ReorderBenchmark::RunComparison()
+	{
+		LogPrint("Body order: %u balls created in shuffled order, %u steps, best of %u", Columns * Rows, StepCount, Repeats);
+		//Alternated so both see the same machine load
+		float off = 0.0f;
+		float on = 0.0f;
+		for(unsigned i=0;i<Repeats;++i)
+		{
+			float time = Run(0);
+			off = i == 0 ? time : Min(off, time);
+			time = Run(ReorderInterval);
+			on = i == 0 ? time : Min(on, time);
+		}
+		LogPrint("Body order: list order %.1f ms (%.3f ms per step), sorted every %u steps %.1f ms (%.3f ms per step), %.2fx",
+			off, off / StepCount, ReorderInterval, on, on / StepCount, on > 0.0f ? off / on : 0.0f);
+	}
+}
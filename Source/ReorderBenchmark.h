@@ -0,0 +1,43 @@
+///////////////////////////////////////////////////////////////////////////////////////
+///
+///	\file ReorderBenchmark.h
+///	Measures sorting the body list by position (Physics::ReorderInterval).
+///
+///	Authors: Chris Peters
+///	Copyright 2011, Digipen Institute of Technology
+///
+///////////////////////////////////////////////////////////////////////////////////////
+#pragma once //Makes sure this header is only included once
+
+#include "Physics.h"
+
+namespace Framework
+{
+	///Builds a dense pile of balls in a walled box, creating the balls in
+	///a shuffled order so the body list starts with no relation to space,
+	///like a level that has been played for a while. The same pile is
+	///stepped with the body list reordering on and off.
+	class ReorderBenchmark
+	{
+	public:
+		ReorderBenchmark();
+
+		///Time in milliseconds to step the pile with the given interval.
+		float Run(unsigned reorderInterval);
+		///Run with reordering off and on, Repeats times each, and print
+		///the fastest runs.
+		void RunComparison();
+
+		unsigned Columns;
+		unsigned Rows;
+		unsigned StepCount;
+		unsigned Repeats;
+		float TimeStep;
+		///Interval used for the run with reordering on.
+		unsigned ReorderInterval;
+
+	private:
+		Body * AddBody(Physics* world, Vec2Param position, Shape* shape, float density);
+		std::vector<GOC*> Objects;
+	};
+}
@@ -20,19 +20,9 @@ namespace Framework
   ContactSet::ContactSet()
   {
     IterationCount = 3;
+    PenetrationResolvePercentage = 0.8f;
   }
 
-	BodyManifold * ContactSet::GetNextContact()
-	{
-		ErrorIf(NumberOfContacts==MaxContacts,"Maximum number of contacts reached. There is too many colliding objects in the simulation.");
-		return &contactArray[NumberOfContacts++];
-	}
-
-	void ContactSet::Reset()
-	{
-		NumberOfContacts = 0;
-	}
-
   void ResolveContactVelocityFull(BodyManifold& m, float dt)
   {
     /*The full impulse equation:
@@ -86,7 +76,7 @@ namespace Framework
     totalInvMass = m.GetContactMass(tangent);
     //If the object falls perfectly down, it will have no tangent velocity.
     //Therefore, there is nothing to do and we should exit out.
-    if(abs(tangentVelocity) < .001f)
+    if(fabs(tangentVelocity) < .001f)
       return;
     //calculate j (the impulse) in the direction of the tangent
     float jTangent = tangentVelocity / totalInvMass;
@@ -105,7 +95,7 @@ namespace Framework
     m.ApplyImpulse(1,tangentImpulse);
   }
 
-  void ResolvePenetrationFull(BodyManifold& m, float dt)
+  void ResolvePenetrationFull(BodyManifold& m, float dt, float resolvePercentage)
   {
     // The movement of each object is based on their inverse mass, so
     // total that.
@@ -117,7 +107,7 @@ namespace Framework
 
     // If stack stability can be increased by not resolving all the penetrations
     // in one step
-    movePerIMass *= PHYSICS->PenetrationResolvePercentage;
+    movePerIMass *= resolvePercentage;
 
     // Calculate the the movement amounts
     Vec2 movement0 = movePerIMass * -m.Bodies[0]->InvMass;
@@ -129,14 +119,14 @@ namespace Framework
   }
 
 	//Resolve Positions
-	void ContactSet::ResolvePositions(float dt)
+	void ContactSet::ResolvePositions(ContactArray& contacts, float dt)
 	{
-    for(unsigned int index = 0; index < NumberOfContacts; ++index)
-      ResolvePenetrationFull(contactArray[index],dt);
+    for(unsigned int index = 0; index < contacts.size(); ++index)
+      ResolvePenetrationFull(contacts[index],dt,PenetrationResolvePercentage);
 	}
 
 	//Resolve Velocities of all contacts
-	void ContactSet::ResolveVelocities(float dt)
+	void ContactSet::ResolveVelocities(ContactArray& contacts, float dt)
 	{
     //This is an iterative solver. That means we do several passes over
     //all of the data so that we can approach the correct answer. Also,
@@ -144,14 +134,14 @@ namespace Framework
     //billiards to propagate energy to the end in one frame with enough
     //iterations.
     for(unsigned int i = 0; i < IterationCount; ++i)
-      for(unsigned int index = 0; index < NumberOfContacts; ++index)
-        ResolveContactVelocityFull(contactArray[index],dt);
+      for(unsigned int index = 0; index < contacts.size(); ++index)
+        ResolveContactVelocityFull(contacts[index],dt);
 	}
 
-	void ContactSet::ResolveContacts(float dt)
+	void ContactSet::ResolveContacts(ContactArray& contacts, float dt)
 	{
-		this->ResolveVelocities(dt);
-    this->ResolvePositions(dt);
+		this->ResolveVelocities(contacts,dt);
+    this->ResolvePositions(contacts,dt);
 	}
 
 }
\ No newline at end of file
@@ -12,24 +12,22 @@
 
 namespace Framework
 {
-	///A Set of contacts that need to be resolved.
+	///Resolves contacts with iterative impulses. The contacts are owned by
+	///the narrow phase and are resolved in place.
 	class ContactSet
 	{
 	public:
     ContactSet();
 
-		BodyManifold * GetNextContact();
-		void ResolveContacts(float dt);
-		void Reset();
+		void ResolveContacts(ContactArray& contacts, float dt);
+
+		//Copied from the owning world each step. See ResolvePenetrationFull.
+		float PenetrationResolvePercentage;
 	private:
-		void ResolveVelocities(float dt);
-		void ResolvePositions(float dt);
+		void ResolveVelocities(ContactArray& contacts, float dt);
+		void ResolvePositions(ContactArray& contacts, float dt);
 
-    friend class Physics;
-    static const int MaxContacts = 1024;
     unsigned int IterationCount;
-    BodyManifold contactArray[MaxContacts];
-    unsigned NumberOfContacts;
 	};
 
 }
\ No newline at end of file
@@ -0,0 +1,137 @@
+///////////////////////////////////////////////////////////////////////////////////////
+//
+//	SatCacheTable.cpp
+//
+//	Authors: Chris Peters
+//	Copyright 2011, Digipen Institute of Technology
+//
+///////////////////////////////////////////////////////////////////////////////////////
+#include "Precompiled.h"
+#include "SatCacheTable.h"
+
+namespace Framework
+{
+	SatCacheTable::SatCacheTable()
+	{
+		PruneSlices = 16;
+		Count = 0;
+		Shift = 64;
+		PruneCursor = 0;
+	}
+
+	unsigned SatCacheTable::Home(unsigned long long key)
+	{
+		//Fibonacci hashing, the top bits of the product are well mixed
+		return (unsigned)( (key * 0x9E3779B97F4A7C15ull) >> Shift );
+	}
+
+	void SatCacheTable::Reserve(unsigned count)
+	{
+		//Kept at most half full so probe runs stay short
+		unsigned needed = (Count + count) * 2;
+		if( needed <= Entries.size() )
+			return;
+
+		unsigned capacity = Entries.empty() ? 64 : (unsigned)Entries.size();
+		while( capacity < needed )
+			capacity *= 2;
+		Rehash(capacity);
+	}
+
+	void SatCacheTable::Rehash(unsigned capacity)
+	{
+		std::vector<Entry> old;
+		old.swap(Entries);
+
+		Entry empty;
+		empty.Key = EmptyKey;
+		empty.LastStep = 0;
+		Entries.assign(capacity, empty);
+
+		Shift = 64;
+		for(unsigned size=capacity;size>1;size/=2)
+			--Shift;
+		PruneCursor = 0;
+
+		unsigned mask = capacity - 1;
+		for(unsigned i=0;i<old.size();++i)
+		{
+			if( old[i].Key == EmptyKey )
+				continue;
+			unsigned slot = Home(old[i].Key);
+			while( Entries[slot].Key != EmptyKey )
+				slot = (slot + 1) & mask;
+			Entries[slot] = old[i];
+		}
+	}
+
+	SatCache* SatCacheTable::Find(GOCId idA, GOCId idB, unsigned step)
+	{
+		ErrorIf( (Count + 1) * 2 > Entries.size() , "Reserve the SatCacheTable before finding pairs." );
+
+		unsigned long long key = (unsigned long long)idA << 32 | idB;
+		unsigned mask = (unsigned)Entries.size() - 1;
+		unsigned slot = Home(key);
+		while( Entries[slot].Key != EmptyKey )
+		{
+			Entry& entry = Entries[slot];
+			if( entry.Key == key )
+			{
+				//Pruning is spread over several steps, so a pair that was
+				//apart for a step may still be stored. It starts over as
+				//it would if it had been removed right away.
+				if( entry.LastStep + 1 < step )
+					entry.Sat = SatCache();
+				entry.LastStep = step;
+				return &entry.Sat;
+			}
+			slot = (slot + 1) & mask;
+		}
+
+		Entry& entry = Entries[slot];
+		entry.Key = key;
+		entry.LastStep = step;
+		entry.Sat = SatCache();
+		++Count;
+		return &entry.Sat;
+	}
+
+	void SatCacheTable::Erase(unsigned hole)
+	{
+		//Backward shift deletion. Later entries of the probe run that can
+		//sit in the hole are moved into it so no tombstones are needed.
+		unsigned mask = (unsigned)Entries.size() - 1;
+		unsigned next = (hole + 1) & mask;
+		while( Entries[next].Key != EmptyKey )
+		{
+			unsigned home = Home(Entries[next].Key);
+			if( ((next - home) & mask) >= ((next - hole) & mask) )
+			{
+				Entries[hole] = Entries[next];
+				hole = next;
+			}
+			next = (next + 1) & mask;
+		}
+		Entries[hole].Key = EmptyKey;
+		--Count;
+	}
+
+	void SatCacheTable::Prune(unsigned step)
+	{
+		if( Count == 0 )
+			return;
+
+		unsigned mask = (unsigned)Entries.size() - 1;
+		unsigned slots = (unsigned)Entries.size() / PruneSlices + 1;
+		for(unsigned i=0;i<slots;++i)
+		{
+			Entry& entry = Entries[PruneCursor];
+			//An erased slot is filled from the slots after it, so it is
+			//checked again
+			if( entry.Key != EmptyKey && entry.LastStep != step )
+				Erase(PruneCursor);
+			else
+				PruneCursor = (PruneCursor + 1) & mask;
+		}
+	}
+}
@@ -0,0 +1,62 @@
+///////////////////////////////////////////////////////////////////////////////////////
+///
+///	\file SatCacheTable.h
+///	Separating axis results kept between steps for each pair of boxes.
+///
+///	Authors: Chris Peters
+///	Copyright 2011, Digipen Institute of Technology
+///
+///////////////////////////////////////////////////////////////////////////////////////
+#pragma once //Makes sure this header is only included once
+
+#include "Composition.h"
+#include "Intersection.h"
+
+namespace Framework
+{
+	///Open addressed hash table of SatCaches keyed by the object ids of a
+	///pair. Ids are used since a destroyed body's memory may be reused.
+	///Entries live in one array so finding a pair is a few cache lines and
+	///pairs that stop touching are removed a slice of the table at a time
+	///instead of by scanning every entry each step.
+	class SatCacheTable
+	{
+	public:
+		SatCacheTable();
+
+		///Make room for count more pairs. Growing moves the entries, so call
+		///it before handing out the caches of a pass, never during one.
+		void Reserve(unsigned count);
+		///Get the cache of a pair for the given step. A pair that was not
+		///found in this or the last step starts over with an empty cache.
+		SatCache* Find(GOCId idA, GOCId idB, unsigned step);
+		///Remove pairs not found in this step from the next slice of the
+		///table. Every slot is visited once every PruneSlices steps.
+		void Prune(unsigned step);
+		///Number of pairs stored.
+		unsigned GetCount(){return Count;}
+
+		///How many steps it takes to check the whole table.
+		unsigned PruneSlices;
+
+	private:
+		struct Entry
+		{
+			unsigned long long Key;
+			unsigned LastStep;
+			SatCache Sat;
+		};
+
+		//Ids start at one so no pair has a zero key
+		enum { EmptyKey = 0 };
+
+		unsigned Home(unsigned long long key);
+		void Rehash(unsigned capacity);
+		void Erase(unsigned slot);
+
+		std::vector<Entry> Entries;
+		unsigned Count;
+		unsigned Shift;
+		unsigned PruneCursor;
+	};
+}
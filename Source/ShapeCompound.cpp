@@ -0,0 +1,403 @@
+///////////////////////////////////////////////////////////////////////////////////////
+//
+//	ShapeCompound.cpp
+//
+//	Authors: Chris Peters
+//	Copyright 2011, Digipen Institute of Technology
+//
+///////////////////////////////////////////////////////////////////////////////////////
+#include "Precompiled.h"
+#include "ShapeCompound.h"
+#include "ShapeGrid.h"
+#include "Body.h"
+#include "DebugDraw.h"
+#include <algorithm>
+
+namespace Framework
+{
+	bool CollideParts(const ShapePart& a, const ShapePart& b, Manifold* m)
+	{
+		if( a.Id == Shape::SidCircle && b.Id == Shape::SidCircle )
+			return CircleCirlce(a.Center, a.Radius, b.Center, b.Radius, m);
+
+		if( a.Id == Shape::SidBox && b.Id == Shape::SidBox )
+			return BoxBox(a.Center, a.Extents, a.Axes, b.Center, b.Extents, b.Axes, m);
+
+		if( a.Id == Shape::SidBox )
+			return BoxCircle(a.Center, a.Extents, a.Axes, b.Center, b.Radius, m);
+
+		//Circle against box is the box test with the results swapped
+		if( !BoxCircle(b.Center, b.Extents, b.Axes, a.Center, a.Radius, m) )
+			return false;
+		if( m != NULL )
+		{
+			m->Normal *= -1;
+			for(unsigned p=0;p<m->PointCount;++p)
+				std::swap(m->Points[p].Points[0], m->Points[p].Points[1]);
+		}
+		return true;
+	}
+
+	Aabb ComputePartAabb(const ShapePart& part)
+	{
+		Vec2 half(part.Radius, part.Radius);
+		if( part.Id == Shape::SidBox )
+		{
+			half = Vec2( fabs(part.Axes[0].x) * part.Extents.x + fabs(part.Axes[1].x) * part.Extents.y ,
+			             fabs(part.Axes[0].y) * part.Extents.x + fabs(part.Axes[1].y) * part.Extents.y );
+		}
+		Aabb box;
+		box.Min = part.Center - half;
+		box.Max = part.Center + half;
+		return box;
+	}
+
+	void ShapeCompound::AddCircle(Vec2Param offset, float radius)
+	{
+		Child child;
+		child.Id = SidCircle;
+		child.Offset = offset;
+		child.Rotation = 0.0f;
+		child.Radius = radius;
+		child.Extents = Vec2(radius, radius);
+		Children.push_back(child);
+	}
+
+	void ShapeCompound::AddBox(Vec2Param offset, Vec2Param extents, float rotation)
+	{
+		Child child;
+		child.Id = SidBox;
+		child.Offset = offset;
+		child.Rotation = rotation;
+		child.Radius = 0.0f;
+		child.Extents = extents;
+		Children.push_back(child);
+	}
+
+	void ShapeCompound::Serialize(ISerializer& stream)
+	{
+		int count = 0;
+		StreamRead(stream,count);
+		for(int i=0;i<count;++i)
+		{
+			std::string childType;
+			StreamRead(stream,childType);
+			if( childType == "Circle" )
+			{
+				float radius;
+				Vec2 offset;
+				StreamRead(stream,radius);
+				StreamRead(stream,offset);
+				AddCircle(offset, radius);
+			}
+			else if( childType == "Box" )
+			{
+				Vec2 extents;
+				Vec2 offset;
+				float rotation;
+				StreamRead(stream,extents);
+				StreamRead(stream,offset);
+				StreamRead(stream,rotation);
+				AddBox(offset, extents, rotation);
+			}
+			else
+			{
+				ErrorIf( true , "Unknown compound child type %s.", childType.c_str() );
+			}
+		}
+		BuildTree();
+	}
+
+	Aabb ShapeCompound::ComputeChildBounds(unsigned child)
+	{
+		//Place the child at the body origin with no rotation
+		Child& c = Children[child];
+		ShapePart part;
+		part.Id = c.Id;
+		part.Center = c.Offset;
+		Mat2 rot;
+		rot.BuildRotation(c.Rotation);
+		rot.GetBases(part.Axes[0],part.Axes[1]);
+		part.Radius = c.Radius;
+		part.Extents = c.Extents;
+		return ComputePartAabb(part);
+	}
+
+	//Orders children by their center along one axis
+	struct ChildCenterLess
+	{
+		ChildCenterLess(const std::vector<Vec2>& centers, unsigned axis) : Centers(centers), Axis(axis) {}
+		bool operator()(unsigned a, unsigned b) const { return Centers[a][Axis] < Centers[b][Axis]; }
+		const std::vector<Vec2>& Centers;
+		unsigned Axis;
+	};
+
+	int ShapeCompound::BuildNode(unsigned begin, unsigned end)
+	{
+		int index = Nodes.size();
+		Nodes.push_back(Node());
+
+		Aabb bounds = ComputeChildBounds(Order[begin]);
+		Vec2 centerMin = Centers[Order[begin]];
+		Vec2 centerMax = centerMin;
+		for(unsigned i=begin+1;i<end;++i)
+		{
+			Aabb childBounds = ComputeChildBounds(Order[i]);
+			bounds.Min = Vec2( std::min(bounds.Min.x, childBounds.Min.x) , std::min(bounds.Min.y, childBounds.Min.y) );
+			bounds.Max = Vec2( std::max(bounds.Max.x, childBounds.Max.x) , std::max(bounds.Max.y, childBounds.Max.y) );
+			Vec2 center = Centers[Order[i]];
+			centerMin = Vec2( std::min(centerMin.x, center.x) , std::min(centerMin.y, center.y) );
+			centerMax = Vec2( std::max(centerMax.x, center.x) , std::max(centerMax.y, center.y) );
+		}
+
+		Nodes[index].Bounds = bounds;
+		Nodes[index].ChildIndex = -1;
+		Nodes[index].Left = -1;
+		Nodes[index].Right = -1;
+
+		if( end - begin == 1 )
+		{
+			Nodes[index].ChildIndex = Order[begin];
+			return index;
+		}
+
+		//Split at the median along the axis the centers are spread over most
+		unsigned axis = centerMax.x - centerMin.x >= centerMax.y - centerMin.y ? 0 : 1;
+		unsigned middle = (begin + end) / 2;
+		std::nth_element(Order.begin() + begin, Order.begin() + middle, Order.begin() + end, ChildCenterLess(Centers, axis));
+
+		int left = BuildNode(begin, middle);
+		int right = BuildNode(middle, end);
+		Nodes[index].Left = left;
+		Nodes[index].Right = right;
+		return index;
+	}
+
+	void ShapeCompound::BuildTree()
+	{
+		ErrorIf( Children.size() > MaxChildren , "Compound shapes can have at most %d children.", MaxChildren );
+
+		Nodes.clear();
+		Order.resize(Children.size());
+		Centers.resize(Children.size());
+		for(unsigned i=0;i<Children.size();++i)
+		{
+			Order[i] = i;
+			Aabb bounds = ComputeChildBounds(i);
+			Centers[i] = (bounds.Min + bounds.Max) * 0.5f;
+		}
+
+		if( !Children.empty() )
+			BuildNode(0, Children.size());
+	}
+
+	void ShapeCompound::GetPart(unsigned child, ShapePart& part)
+	{
+		Child& c = Children[child];
+		part.Id = c.Id;
+		part.Center = body->GetWorldPointFromBodyPoint(c.Offset);
+		Mat2 rot;
+		rot.BuildRotation(body->Rotation + c.Rotation);
+		rot.GetBases(part.Axes[0],part.Axes[1]);
+		part.Radius = c.Radius;
+		part.Extents = c.Extents;
+	}
+
+	unsigned ShapeCompound::QueryChildren(const Aabb& box, unsigned* results, unsigned maxResults)
+	{
+		if( Nodes.empty() )
+			return 0;
+
+		//Bring the box into body space
+		Vec2 center = body->GetBodyPointFromWorldPoint( (box.Min + box.Max) * 0.5f );
+		Vec2 half = (box.Max - box.Min) * 0.5f;
+		float c = fabs(cos(body->Rotation));
+		float s = fabs(sin(body->Rotation));
+		Aabb local;
+		local.Min = center - Vec2( c * half.x + s * half.y , s * half.x + c * half.y );
+		local.Max = center + Vec2( c * half.x + s * half.y , s * half.x + c * half.y );
+
+		//The tree of a compound with MaxChildren is never deeper than the stack
+		int stack[MaxChildren];
+		unsigned stackSize = 0;
+		unsigned count = 0;
+		stack[stackSize++] = 0;
+		while( stackSize > 0 )
+		{
+			Node& node = Nodes[stack[--stackSize]];
+			if( !node.Bounds.Overlaps(local) )
+				continue;
+			if( node.ChildIndex != -1 )
+			{
+				if( count < maxResults )
+					results[count++] = node.ChildIndex;
+			}
+			else
+			{
+				stack[stackSize++] = node.Left;
+				stack[stackSize++] = node.Right;
+			}
+		}
+		return count;
+	}
+
+	unsigned ShapeCompound::CollidePart(const ShapePart& other, Manifold* manifolds, unsigned maxManifolds)
+	{
+		unsigned children[MaxChildren];
+		unsigned childCount = QueryChildren(ComputePartAabb(other), children, MaxChildren);
+
+		unsigned written = 0;
+		for(unsigned i=0;i<childCount;++i)
+		{
+			ShapePart part;
+			GetPart(children[i], part);
+			if( manifolds == NULL )
+			{
+				if( CollideParts(part, other, NULL) )
+					return 1;
+			}
+			else if( written < maxManifolds && CollideParts(part, other, &manifolds[written]) )
+				++written;
+		}
+		return written;
+	}
+
+	unsigned ShapeCompound::CollideGrid(ShapeGrid* grid, Manifold* manifolds, unsigned maxManifolds)
+	{
+		//Grids find their own cells so every child is tested
+		unsigned written = 0;
+		for(unsigned i=0;i<Children.size();++i)
+		{
+			ShapePart part;
+			GetPart(i, part);
+			Manifold* childManifolds = manifolds ? manifolds + written : NULL;
+			unsigned childMax = manifolds ? maxManifolds - written : 0;
+			unsigned count = 0;
+			if( part.Id == SidCircle )
+				count = grid->CollideCircle(part.Center, part.Radius, childManifolds, childMax);
+			else
+				count = grid->CollideBox(part.Center, part.Extents, part.Axes, childManifolds, childMax);
+
+			if( manifolds == NULL )
+			{
+				if( count > 0 )
+					return 1;
+				continue;
+			}
+
+			//The grid normals point at the child, flip them to point at the grid
+			for(unsigned m=0;m<count;++m)
+			{
+				childManifolds[m].Normal *= -1;
+				for(unsigned p=0;p<childManifolds[m].PointCount;++p)
+					std::swap(childManifolds[m].Points[p].Points[0], childManifolds[m].Points[p].Points[1]);
+			}
+			written += count;
+			if( written == maxManifolds )
+				break;
+		}
+		return written;
+	}
+
+	void ShapeCompound::Draw()
+	{
+		for(unsigned i=0;i<Children.size();++i)
+		{
+			ShapePart part;
+			GetPart(i, part);
+			if( part.Id == SidCircle )
+			{
+				Drawer::Instance.DrawCircle( part.Center , part.Radius );
+				continue;
+			}
+			Vec2 x = part.Axes[0] * part.Extents.x;
+			Vec2 y = part.Axes[1] * part.Extents.y;
+			Drawer::Instance.MoveTo( part.Center + x + y );
+			Drawer::Instance.LineTo( part.Center - x + y );
+			Drawer::Instance.LineTo( part.Center - x - y );
+			Drawer::Instance.LineTo( part.Center + x - y );
+			Drawer::Instance.LineTo( part.Center + x + y );
+		}
+	}
+
+	bool ShapeCompound::TestPoint(Vec2 testPoint)
+	{
+		for(unsigned i=0;i<Children.size();++i)
+		{
+			ShapePart part;
+			GetPart(i, part);
+			Vec2 delta = testPoint - part.Center;
+			if( part.Id == SidCircle )
+			{
+				if( LengthSquared(delta) < part.Radius * part.Radius )
+					return true;
+			}
+			else if( fabs(Dot(delta, part.Axes[0])) < part.Extents.x && fabs(Dot(delta, part.Axes[1])) < part.Extents.y )
+				return true;
+		}
+		return false;
+	}
+
+	bool ShapeCompound::TestSegment(Vec2 start, Vec2 end)
+	{
+		for(unsigned i=0;i<Children.size();++i)
+		{
+			ShapePart part;
+			GetPart(i, part);
+			if( part.Id == SidCircle )
+			{
+				if( SegmentCircle(start, end, part.Center, part.Radius) )
+					return true;
+			}
+			else if( SegmentBox(start, end, part.Center, part.Extents, part.Axes) )
+				return true;
+		}
+		return false;
+	}
+
+	Aabb ShapeCompound::ComputeAabb()
+	{
+		Aabb bounds;
+		bounds.Min = body->Position;
+		bounds.Max = body->Position;
+		for(unsigned i=0;i<Children.size();++i)
+		{
+			ShapePart part;
+			GetPart(i, part);
+			Aabb childBounds = ComputePartAabb(part);
+			if( i == 0 )
+				bounds = childBounds;
+			bounds.Min = Vec2( std::min(bounds.Min.x, childBounds.Min.x) , std::min(bounds.Min.y, childBounds.Min.y) );
+			bounds.Max = Vec2( std::max(bounds.Max.x, childBounds.Max.x) , std::max(bounds.Max.y, childBounds.Max.y) );
+		}
+		return bounds;
+	}
+
+	void ShapeCompound::ComputeMassAndInertia(float density, float& mass, float& inertia)
+	{
+		//Sum the children using the formulas of the single shapes and move
+		//each child's inertia to the body center (parallel axis theorem)
+		mass = 0.0f;
+		inertia = 0.0f;
+		for(unsigned i=0;i<Children.size();++i)
+		{
+			Child& c = Children[i];
+			float childMass = 0.0f;
+			float childInertia = 0.0f;
+			if( c.Id == SidCircle )
+			{
+				ShapeCircle circle;
+				circle.Radius = c.Radius;
+				circle.ComputeMassAndInertia(density, childMass, childInertia);
+			}
+			else
+			{
+				ShapeAAB box;
+				box.Extents = c.Extents;
+				box.ComputeMassAndInertia(density, childMass, childInertia);
+			}
+			mass += childMass;
+			inertia += childInertia + childMass * LengthSquared(c.Offset);
+		}
+	}
+}
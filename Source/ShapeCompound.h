@@ -0,0 +1,103 @@
+///////////////////////////////////////////////////////////////////////////////////////
+///
+///	\file ShapeCompound.h
+///	Rigid shape made of several circles and boxes with a local bounding
+///	volume hierarchy.
+///
+///	Authors: Chris Peters
+///	Copyright 2011, Digipen Institute of Technology
+///
+///////////////////////////////////////////////////////////////////////////////////////
+#pragma once //Makes sure this header is only included once
+
+#include "Collision.h"
+
+namespace Framework
+{
+	class ShapeGrid;
+
+	///A circle or box placed in world space. Used to test the parts of
+	///compound shapes with the basic intersection tests.
+	struct ShapePart
+	{
+		Shape::ShapeId Id;
+		Vec2 Center;
+		Vec2 Axes[2];
+		float Radius;
+		Vec2 Extents;
+	};
+
+	///Collide two parts. The manifold normal points from a to b.
+	bool CollideParts(const ShapePart& a, const ShapePart& b, Manifold* m);
+	///World bounds of a part.
+	Aabb ComputePartAabb(const ShapePart& part);
+
+	///Several circles and boxes fixed to one body. The whole object is one
+	///body for the solver, so it does not stretch like bodies held together
+	///by sticks. Children are placed relative to the body position, which
+	///should be the center of mass of the children.
+	///The children are kept in a small bounding volume tree in body space,
+	///built once on load, so only the children near the other shape are
+	///tested. Each touching child produces its own manifold.
+	class ShapeCompound : public Shape
+	{
+	public:
+		ShapeCompound() : Shape(SidCompound) {};
+
+		///Most children one compound can have.
+		enum { MaxChildren = 64 };
+
+		struct Child
+		{
+			///SidCircle or SidBox.
+			ShapeId Id;
+			Vec2 Offset;
+			float Rotation;
+			float Radius;
+			Vec2 Extents;
+		};
+		std::vector<Child> Children;
+
+		void AddCircle(Vec2Param offset, float radius);
+		void AddBox(Vec2Param offset, Vec2Param extents, float rotation);
+		///Read the children from a data file. Each child is either
+		///"Circle radius x y" or "Box extentX extentY x y rotation".
+		void Serialize(ISerializer& stream);
+		///Rebuild the tree after the children change.
+		void BuildTree();
+
+		///World placement of a child at the body's current position.
+		void GetPart(unsigned child, ShapePart& part);
+		///Find the children whose bounds may overlap the world box.
+		///Returns the number found.
+		unsigned QueryChildren(const Aabb& box, unsigned* results, unsigned maxResults);
+
+		///Collide the children with a part or a grid. Manifold normals point
+		///from the compound to the other shape.
+		unsigned CollidePart(const ShapePart& other, Manifold* manifolds, unsigned maxManifolds);
+		unsigned CollideGrid(ShapeGrid* grid, Manifold* manifolds, unsigned maxManifolds);
+
+		virtual void Draw();
+		virtual bool TestPoint(Vec2);
+		virtual bool TestSegment(Vec2 start, Vec2 end);
+		virtual Aabb ComputeAabb();
+		virtual void ComputeMassAndInertia(float density, float& mass, float& inertia);
+
+	private:
+		Aabb ComputeChildBounds(unsigned child);
+		int BuildNode(unsigned begin, unsigned end);
+
+		//Leaves hold one child, inner nodes two nodes. Bounds are in body space.
+		struct Node
+		{
+			Aabb Bounds;
+			int Left;
+			int Right;
+			int ChildIndex;
+		};
+		std::vector<Node> Nodes;
+		//Children ordered by the tree build
+		std::vector<unsigned> Order;
+		std::vector<Vec2> Centers;
+	};
+}
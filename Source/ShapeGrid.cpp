@@ -0,0 +1,558 @@
+///////////////////////////////////////////////////////////////////////////////////////
+//
+//	ShapeGrid.cpp
+//
+//	Authors: Chris Peters
+//	Copyright 2011, Digipen Institute of Technology
+//
+///////////////////////////////////////////////////////////////////////////////////////
+#include "Precompiled.h"
+#include "ShapeGrid.h"
+#include "Body.h"
+#include "DebugDraw.h"
+
+namespace Framework
+{
+	static const Vec2 FaceNormals[ShapeGrid::FaceCount] = { Vec2(1,0), Vec2(-1,0), Vec2(0,1), Vec2(0,-1) };
+
+	//Side faces run along y, top and bottom faces along x
+	static Vec2 FaceTangent(unsigned face)
+	{
+		return face < ShapeGrid::FaceTop ? Vec2(0,1) : Vec2(1,0);
+	}
+
+	//Position of the face plane along its normal
+	static float FaceCoordinate(const Aabb& box, unsigned face)
+	{
+		switch( face )
+		{
+		case ShapeGrid::FaceRight: return box.Max.x;
+		case ShapeGrid::FaceLeft: return -box.Min.x;
+		case ShapeGrid::FaceTop: return box.Max.y;
+		default: return -box.Min.y;
+		}
+	}
+
+	//Contacts of every cell are merged per face direction. Only the two
+	//points furthest apart along the face are kept, as if the cells were
+	//one long edge.
+	struct GridContacts
+	{
+		enum { MaxCorners = 4 };
+
+		GridContacts() : CornerCount(0)
+		{
+			for(unsigned f=0;f<ShapeGrid::FaceCount;++f)
+				Count[f] = 0;
+		}
+
+		void Add(unsigned face, Vec2Param gridPoint, Vec2Param shapePoint, float depth)
+		{
+			Manifold::ContactPoint point;
+			point.Points[0] = gridPoint;
+			point.Points[1] = shapePoint;
+			point.Depth = depth;
+			float t = Dot(shapePoint, FaceTangent(face));
+			if( Count[face] == 0 || t < LowT[face] )
+			{
+				Low[face] = point;
+				LowT[face] = t;
+			}
+			if( Count[face] == 0 || t > HighT[face] )
+			{
+				High[face] = point;
+				HighT[face] = t;
+			}
+			++Count[face];
+		}
+
+		void AddCorner(Vec2Param normal, Vec2Param gridPoint, Vec2Param shapePoint, float depth)
+		{
+			if( CornerCount == MaxCorners )
+				return;
+			CornerNormals[CornerCount] = normal;
+			Corners[CornerCount].Points[0] = gridPoint;
+			Corners[CornerCount].Points[1] = shapePoint;
+			Corners[CornerCount].Depth = depth;
+			++CornerCount;
+		}
+
+		unsigned Write(Manifold* manifolds, unsigned maxManifolds)
+		{
+			unsigned written = 0;
+			for(unsigned f=0;f<ShapeGrid::FaceCount && written<maxManifolds;++f)
+			{
+				if( Count[f] == 0 )
+					continue;
+				Manifold& m = manifolds[written++];
+				m.Normal = FaceNormals[f];
+				m.Points[0] = Low[f];
+				m.PointCount = 1;
+				if( HighT[f] > LowT[f] )
+				{
+					m.Points[1] = High[f];
+					m.PointCount = 2;
+				}
+			}
+			for(unsigned c=0;c<CornerCount && written<maxManifolds;++c)
+			{
+				Manifold& m = manifolds[written++];
+				m.Normal = CornerNormals[c];
+				m.Points[0] = Corners[c];
+				m.PointCount = 1;
+			}
+			return written;
+		}
+
+		unsigned Count[ShapeGrid::FaceCount];
+		Manifold::ContactPoint Low[ShapeGrid::FaceCount];
+		Manifold::ContactPoint High[ShapeGrid::FaceCount];
+		float LowT[ShapeGrid::FaceCount];
+		float HighT[ShapeGrid::FaceCount];
+		unsigned CornerCount;
+		Vec2 CornerNormals[MaxCorners];
+		Manifold::ContactPoint Corners[MaxCorners];
+	};
+
+	//Push a circle out through one face of a cell
+	static void AddCircleFace(GridContacts& contacts, const Aabb& box, unsigned face, Vec2Param center, float radius)
+	{
+		Vec2 normal = FaceNormals[face];
+		Vec2 point = center - normal * radius;
+		float depth = FaceCoordinate(box, face) - Dot(point, normal);
+		if( depth > 0.0f )
+			contacts.Add(face, point + normal * depth, point, depth);
+	}
+
+	//Clip the segment to the part between spanMin and spanMax along the
+	//tangent. Returns false if none of it is inside.
+	static bool ClipSegment(Vec2* points, Vec2Param tangent, float spanMin, float spanMax)
+	{
+		float t0 = Dot(points[0], tangent);
+		float t1 = Dot(points[1], tangent);
+		if( t0 > t1 )
+		{
+			std::swap(points[0], points[1]);
+			std::swap(t0, t1);
+		}
+		if( t1 < spanMin || t0 > spanMax )
+			return false;
+
+		//A segment along the normal has nothing to clip
+		if( t1 - t0 > 0.0f )
+		{
+			Vec2 start = points[0];
+			Vec2 end = points[1];
+			if( t0 < spanMin )
+				points[0] = start + (end - start) * ((spanMin - t0) / (t1 - t0));
+			if( t1 > spanMax )
+				points[1] = start + (end - start) * ((spanMax - t0) / (t1 - t0));
+		}
+		return true;
+	}
+
+	ShapeGrid::ShapeGrid() : Shape(SidGrid)
+	{
+		CellSize = 32.0f;
+		Width = 0;
+		Height = 0;
+		IsHeightfield = false;
+		MaxHeight = 0.0f;
+	}
+
+	void ShapeGrid::Serialize(ISerializer& stream)
+	{
+		StreamRead(stream,CellSize);
+		StreamRead(stream,Width);
+
+		if( IsHeightfield )
+		{
+			Heights.resize(Width);
+			for(int x=0;x<Width;++x)
+				StreamRead(stream,Heights[x]);
+		}
+		else
+		{
+			StreamRead(stream,Height);
+			Cells.assign(Width * Height, 0);
+
+			//Rows are listed top row first so the file looks like the level
+			for(int y=Height-1;y>=0;--y)
+			{
+				std::string row;
+				StreamRead(stream,row);
+				ErrorIf( (int)row.size() != Width , "Grid row %d has %d cells instead of %d.", y, row.size(), Width );
+				for(int x=0;x<Width && x<(int)row.size();++x)
+					Cells[y * Width + x] = row[x] == '#';
+			}
+		}
+
+		UpdateBounds();
+	}
+
+	void ShapeGrid::UpdateBounds()
+	{
+		MaxHeight = Height * CellSize;
+		if( IsHeightfield )
+		{
+			MaxHeight = 0.0f;
+			for(unsigned x=0;x<Heights.size();++x)
+				MaxHeight = std::max(MaxHeight, Heights[x]);
+		}
+	}
+
+	bool ShapeGrid::IsSolid(int x, int y)
+	{
+		if( x < 0 || x >= Width || y < 0 )
+			return false;
+		//A heightfield cell is solid if its column reaches into it
+		if( IsHeightfield )
+			return y * CellSize < Heights[x];
+		if( y >= Height )
+			return false;
+		return Cells[y * Width + x] != 0;
+	}
+
+	void ShapeGrid::SetSolid(int x, int y, bool solid)
+	{
+		ErrorIf( IsHeightfield , "Heightfield cells can not be set.");
+		if( x < 0 || x >= Width || y < 0 || y >= Height )
+			return;
+		Cells[y * Width + x] = solid;
+	}
+
+	bool ShapeGrid::GetSolidBox(int x, int y, Aabb& box)
+	{
+		Vec2 origin = body->Position;
+		if( IsHeightfield )
+		{
+			if( Heights[x] <= 0.0f )
+				return false;
+			box.Min = origin + Vec2(x * CellSize, 0.0f);
+			box.Max = origin + Vec2((x + 1) * CellSize, Heights[x]);
+			return true;
+		}
+
+		if( !IsSolid(x,y) )
+			return false;
+		box.Min = origin + Vec2(x * CellSize, y * CellSize);
+		box.Max = box.Min + Vec2(CellSize, CellSize);
+		return true;
+	}
+
+	bool ShapeGrid::GetExposedFace(int x, int y, unsigned face, const Aabb& box, float& spanMin, float& spanMax)
+	{
+		bool side = face < FaceTop;
+		spanMin = side ? box.Min.y : box.Min.x;
+		spanMax = side ? box.Max.y : box.Max.x;
+
+		if( IsHeightfield )
+		{
+			if( !side )
+				return true;
+			//Only the part of a side above the next column is exposed
+			int neighbor = face == FaceRight ? x + 1 : x - 1;
+			float neighborHeight = neighbor >= 0 && neighbor < Width ? Heights[neighbor] : 0.0f;
+			spanMin = std::max(spanMin, body->Position.y + neighborHeight);
+			return spanMin < spanMax;
+		}
+
+		static const int offsets[FaceCount][2] = { {1,0}, {-1,0}, {0,1}, {0,-1} };
+		return !IsSolid(x + offsets[face][0], y + offsets[face][1]);
+	}
+
+	bool ShapeGrid::GetCellRange(const Aabb& bounds, int& minX, int& minY, int& maxX, int& maxY)
+	{
+		Vec2 origin = body->Position;
+		minX = (int)floor((bounds.Min.x - origin.x) / CellSize);
+		maxX = (int)floor((bounds.Max.x - origin.x) / CellSize);
+
+		int rows = Height;
+		if( IsHeightfield )
+		{
+			//Columns span the whole height
+			if( bounds.Min.y > origin.y + MaxHeight || bounds.Max.y < origin.y )
+				return false;
+			rows = 1;
+			minY = 0;
+			maxY = 0;
+		}
+		else
+		{
+			minY = (int)floor((bounds.Min.y - origin.y) / CellSize);
+			maxY = (int)floor((bounds.Max.y - origin.y) / CellSize);
+		}
+
+		if( maxX < 0 || minX >= Width || maxY < 0 || minY >= rows )
+			return false;
+
+		minX = std::max(minX, 0);
+		minY = std::max(minY, 0);
+		maxX = std::min(maxX, Width - 1);
+		maxY = std::min(maxY, rows - 1);
+		return true;
+	}
+
+	unsigned ShapeGrid::CollideCircle(Vec2Param center, float radius, Manifold* manifolds, unsigned maxManifolds)
+	{
+		Aabb bounds;
+		bounds.Min = center - Vec2(radius,radius);
+		bounds.Max = center + Vec2(radius,radius);
+		int minX, minY, maxX, maxY;
+		if( !GetCellRange(bounds, minX, minY, maxX, maxY) )
+			return 0;
+
+		GridContacts contacts;
+		for(int y=minY;y<=maxY;++y)
+		{
+			for(int x=minX;x<=maxX;++x)
+			{
+				Aabb box;
+				if( !GetSolidBox(x, y, box) )
+					continue;
+
+				Vec2 closest( Clamp(center.x, box.Min.x, box.Max.x) , Clamp(center.y, box.Min.y, box.Max.y) );
+				Vec2 offset = center - closest;
+				float distanceSq = LengthSquared(offset);
+				if( distanceSq >= radius * radius )
+					continue;
+
+				if( manifolds == NULL )
+					return 1;
+
+				float spanMin, spanMax;
+				bool outsideX = center.x < box.Min.x || center.x > box.Max.x;
+				bool outsideY = center.y < box.Min.y || center.y > box.Max.y;
+				if( outsideX && outsideY )
+				{
+					//Near a corner. Only a corner between two exposed faces
+					//pushes away from the corner, otherwise the circle is
+					//pushed out of the exposed face.
+					unsigned faceX = center.x > box.Max.x ? FaceRight : FaceLeft;
+					unsigned faceY = center.y > box.Max.y ? FaceTop : FaceBottom;
+					bool exposedX = GetExposedFace(x, y, faceX, box, spanMin, spanMax) && closest.y >= spanMin && closest.y <= spanMax;
+					bool exposedY = GetExposedFace(x, y, faceY, box, spanMin, spanMax) && closest.x >= spanMin && closest.x <= spanMax;
+					if( exposedX && exposedY )
+					{
+						float distance = sqrt(distanceSq);
+						Vec2 normal = offset / distance;
+						contacts.AddCorner(normal, closest, center - normal * radius, radius - distance);
+					}
+					else if( exposedX )
+						AddCircleFace(contacts, box, faceX, center, radius);
+					else if( exposedY )
+						AddCircleFace(contacts, box, faceY, center, radius);
+					continue;
+				}
+
+				//Push out through the exposed face with the least overlap
+				unsigned best = FaceCount;
+				float bestDepth = PositiveMax();
+				for(unsigned f=0;f<FaceCount;++f)
+				{
+					if( !GetExposedFace(x, y, f, box, spanMin, spanMax) )
+						continue;
+					Vec2 point = center - FaceNormals[f] * radius;
+					float t = Dot(point, FaceTangent(f));
+					if( t < spanMin || t > spanMax )
+						continue;
+					float depth = FaceCoordinate(box, f) - Dot(point, FaceNormals[f]);
+					if( depth < bestDepth )
+					{
+						best = f;
+						bestDepth = depth;
+					}
+				}
+
+				if( best != FaceCount )
+					AddCircleFace(contacts, box, best, center, radius);
+			}
+		}
+
+		return contacts.Write(manifolds, maxManifolds);
+	}
+
+	unsigned ShapeGrid::CollideBox(Vec2Param center, Vec2Param extents, const Vec2* axes, Manifold* manifolds, unsigned maxManifolds)
+	{
+		Vec2 half( fabs(axes[0].x) * extents.x + fabs(axes[1].x) * extents.y ,
+		           fabs(axes[0].y) * extents.x + fabs(axes[1].y) * extents.y );
+		Aabb bounds;
+		bounds.Min = center - half;
+		bounds.Max = center + half;
+		int minX, minY, maxX, maxY;
+		if( !GetCellRange(bounds, minX, minY, maxX, maxY) )
+			return 0;
+
+		const Vec2 gridAxes[2] = { Vec2(1,0), Vec2(0,1) };
+		GridContacts contacts;
+		for(int y=minY;y<=maxY;++y)
+		{
+			for(int x=minX;x<=maxX;++x)
+			{
+				Aabb box;
+				if( !GetSolidBox(x, y, box) )
+					continue;
+
+				Vec2 cellCenter = (box.Min + box.Max) * 0.5f;
+				Vec2 cellHalf = (box.Max - box.Min) * 0.5f;
+				if( !BoxBox(cellCenter, cellHalf, gridAxes, center, extents, axes, NULL) )
+					continue;
+
+				if( manifolds == NULL )
+					return 1;
+
+				//Push out through the exposed face with the least overlap
+				unsigned best = FaceCount;
+				float bestDepth = PositiveMax();
+				float bestMin = 0.0f;
+				float bestMax = 0.0f;
+				for(unsigned f=0;f<FaceCount;++f)
+				{
+					float spanMin, spanMax;
+					if( !GetExposedFace(x, y, f, box, spanMin, spanMax) )
+						continue;
+					Vec2 normal = FaceNormals[f];
+					float support = Dot(center, normal) - fabs(Dot(axes[0], normal)) * extents.x - fabs(Dot(axes[1], normal)) * extents.y;
+					float depth = FaceCoordinate(box, f) - support;
+					if( depth < bestDepth )
+					{
+						best = f;
+						bestDepth = depth;
+						bestMin = spanMin;
+						bestMax = spanMax;
+					}
+				}
+
+				if( best == FaceCount )
+					continue;
+
+				//Clip the edge of the box facing the cell to the exposed part
+				//of the face, keeping the points that are below it
+				Vec2 normal = FaceNormals[best];
+				unsigned edgeAxis = fabs(Dot(axes[0], normal)) > fabs(Dot(axes[1], normal)) ? 0 : 1;
+				Vec2 toEdge = axes[edgeAxis] * extents[edgeAxis];
+				if( Dot(toEdge, normal) > 0.0f )
+					toEdge = -toEdge;
+				Vec2 alongEdge = axes[1 - edgeAxis] * extents[1 - edgeAxis];
+				Vec2 points[2] = { center + toEdge + alongEdge , center + toEdge - alongEdge };
+				if( !ClipSegment(points, FaceTangent(best), bestMin, bestMax) )
+					continue;
+
+				float faceCoordinate = FaceCoordinate(box, best);
+				for(unsigned p=0;p<2;++p)
+				{
+					float depth = faceCoordinate - Dot(points[p], normal);
+					if( depth > 0.0f )
+						contacts.Add(best, points[p] + normal * depth, points[p], depth);
+				}
+			}
+		}
+
+		return contacts.Write(manifolds, maxManifolds);
+	}
+
+	void ShapeGrid::Draw()
+	{
+		//Very large grids only draw their bounds
+		const int MaxDrawnCells = 128 * 128;
+		int rows = IsHeightfield ? 1 : Height;
+		if( Width * rows > MaxDrawnCells )
+		{
+			Aabb bounds = ComputeAabb();
+			Drawer::Instance.MoveTo( bounds.Max );
+			Drawer::Instance.LineTo( Vec2(bounds.Min.x, bounds.Max.y) );
+			Drawer::Instance.LineTo( bounds.Min );
+			Drawer::Instance.LineTo( Vec2(bounds.Max.x, bounds.Min.y) );
+			Drawer::Instance.LineTo( bounds.Max );
+			return;
+		}
+
+		//Only the faces that can be collided with
+		for(int y=0;y<rows;++y)
+		{
+			for(int x=0;x<Width;++x)
+			{
+				Aabb box;
+				if( !GetSolidBox(x, y, box) )
+					continue;
+				for(unsigned f=0;f<FaceCount;++f)
+				{
+					float spanMin, spanMax;
+					if( !GetExposedFace(x, y, f, box, spanMin, spanMax) )
+						continue;
+					if( f == FaceRight )
+						Drawer::Instance.DrawSegment( Vec2(box.Max.x, spanMin) , Vec2(box.Max.x, spanMax) );
+					else if( f == FaceLeft )
+						Drawer::Instance.DrawSegment( Vec2(box.Min.x, spanMin) , Vec2(box.Min.x, spanMax) );
+					else if( f == FaceTop )
+						Drawer::Instance.DrawSegment( Vec2(spanMin, box.Max.y) , Vec2(spanMax, box.Max.y) );
+					else
+						Drawer::Instance.DrawSegment( Vec2(spanMin, box.Min.y) , Vec2(spanMax, box.Min.y) );
+				}
+			}
+		}
+	}
+
+	bool ShapeGrid::TestPoint(Vec2 testPoint)
+	{
+		Vec2 local = testPoint - body->Position;
+		int x = (int)floor(local.x / CellSize);
+		if( IsHeightfield )
+			return x >= 0 && x < Width && local.y >= 0.0f && local.y < Heights[x];
+		return IsSolid(x, (int)floor(local.y / CellSize));
+	}
+
+	bool ShapeGrid::TestSegment(Vec2 start, Vec2 end)
+	{
+		//Walk the cells the segment passes through (Amanatides and Woo)
+		Vec2 from = (start - body->Position) / CellSize;
+		Vec2 to = (end - body->Position) / CellSize;
+		int x = (int)floor(from.x);
+		int y = (int)floor(from.y);
+		int endX = (int)floor(to.x);
+		int endY = (int)floor(to.y);
+		Vec2 delta = to - from;
+
+		int stepX = delta.x > 0.0f ? 1 : -1;
+		int stepY = delta.y > 0.0f ? 1 : -1;
+		float deltaTX = delta.x != 0.0f ? fabs(1.0f / delta.x) : PositiveMax();
+		float deltaTY = delta.y != 0.0f ? fabs(1.0f / delta.y) : PositiveMax();
+		float nextTX = delta.x > 0.0f ? (x + 1 - from.x) * deltaTX : delta.x < 0.0f ? (from.x - x) * deltaTX : PositiveMax();
+		float nextTY = delta.y > 0.0f ? (y + 1 - from.y) * deltaTY : delta.y < 0.0f ? (from.y - y) * deltaTY : PositiveMax();
+
+		int steps = abs(endX - x) + abs(endY - y);
+		for(int i=0;i<=steps;++i)
+		{
+			if( IsSolid(x,y) )
+				return true;
+			if( nextTX < nextTY )
+			{
+				nextTX += deltaTX;
+				x += stepX;
+			}
+			else
+			{
+				nextTY += deltaTY;
+				y += stepY;
+			}
+		}
+		return false;
+	}
+
+	Aabb ShapeGrid::ComputeAabb()
+	{
+		Aabb box;
+		box.Min = body->Position;
+		box.Max = body->Position + Vec2(Width * CellSize, MaxHeight);
+		return box;
+	}
+
+	void ShapeGrid::ComputeMassAndInertia(float density, float& mass, float& inertia)
+	{
+		//A grid can not move. Zero mass tells the body to be static.
+		if( density > 0.0f )
+			LogPrint("Grid shapes can only be used by static bodies, the body is made static.");
+		mass = 0.0f;
+		inertia = 0.0f;
+	}
+}
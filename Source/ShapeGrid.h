@@ -0,0 +1,81 @@
+///////////////////////////////////////////////////////////////////////////////////////
+///
+///	\file ShapeGrid.h
+///	Static tile grid and heightfield collision shape for large levels.
+///
+///	Authors: Chris Peters
+///	Copyright 2011, Digipen Institute of Technology
+///
+///////////////////////////////////////////////////////////////////////////////////////
+#pragma once //Makes sure this header is only included once
+
+#include "Collision.h"
+
+namespace Framework
+{
+	///Grid of solid and empty square cells, or a heightfield of solid columns,
+	///held by a single static body. The lower left corner of the grid is at
+	///the body position and grids are never rotated.
+	///Cells under a shape are found directly from its bounds. Only faces
+	///that border empty space can produce contacts, so bodies slide across
+	///the seams between cells without catching on them. The contacts of all
+	///cells pushing in the same direction are merged into one manifold.
+	class ShapeGrid : public Shape
+	{
+	public:
+		ShapeGrid();
+
+		///Faces of a cell, also the index of their normal direction.
+		enum Face
+		{
+			FaceRight,
+			FaceLeft,
+			FaceTop,
+			FaceBottom,
+			FaceCount
+		};
+
+		///Cell size in world units.
+		float CellSize;
+		///Number of columns and rows. Heightfields only use Width.
+		int Width;
+		int Height;
+		///Heightfields store a height per column instead of cells.
+		bool IsHeightfield;
+		///Solid flags, row major starting with the bottom row.
+		std::vector<unsigned char> Cells;
+		///Column heights in world units.
+		std::vector<float> Heights;
+
+		///Read the grid from a data file. Cell rows are listed top row first
+		///as strings of '#' (solid) and '.' (empty). Heightfields list one
+		///height per column.
+		void Serialize(ISerializer& stream);
+		///Recompute the cached bounds after changing the heights.
+		void UpdateBounds();
+
+		bool IsSolid(int x, int y);
+		void SetSolid(int x, int y, bool solid);
+
+		///Collide a circle or box with the grid. The manifold normals point
+		///from the grid to the shape.
+		unsigned CollideCircle(Vec2Param center, float radius, Manifold* manifolds, unsigned maxManifolds);
+		unsigned CollideBox(Vec2Param center, Vec2Param extents, const Vec2* axes, Manifold* manifolds, unsigned maxManifolds);
+
+		virtual void Draw();
+		virtual bool TestPoint(Vec2);
+		virtual bool TestSegment(Vec2 start, Vec2 end);
+		virtual Aabb ComputeAabb();
+		virtual void ComputeMassAndInertia(float density, float& mass, float& inertia);
+
+	private:
+		///World box of a solid cell or column. False if it is empty.
+		bool GetSolidBox(int x, int y, Aabb& box);
+		///Range along the face of the part of it that borders empty space.
+		///False if the whole face is internal.
+		bool GetExposedFace(int x, int y, unsigned face, const Aabb& box, float& spanMin, float& spanMax);
+		///Cells touched by the bounds. False if the bounds miss the grid.
+		bool GetCellRange(const Aabb& bounds, int& minX, int& minY, int& maxX, int& maxY);
+		float MaxHeight;
+	};
+}
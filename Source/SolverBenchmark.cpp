@@ -0,0 +1,228 @@
+///////////////////////////////////////////////////////////////////////////////////////
+///
+///	\file SolverBenchmark.cpp
+///	Compares the contact solvers on stiff stacks and ladders.
+///	
+///	Authors: Chris Peters
+///	Copyright 2011, Digipen Institute of Technology
+///
+///////////////////////////////////////////////////////////////////////////////////////
+#include "Precompiled.h"
+#include "SolverBenchmark.h"
+#include "Factory.h"
+#include "Transform.h"
+#include "FrameTiming.h"
+
+namespace Framework
+{
+	//Size of the pyramid boxes, the ladder joints and the ladder's spacing
+	const float BoxHalfSize = 20.0f;
+	const Vec2 JointExtents(5.0f, 5.0f);
+	const float RungLength = 60.0f;
+	const float RailLength = 40.0f;
+	const Vec2 RopeJointExtents(2.0f, 2.0f);
+	const float RopeLinkLength = 10.0f;
+
+	SolverBenchmark::SolverBenchmark()
+	{
+		PyramidRows = 12;
+		LadderRungs = 20;
+		RopeLinks = 500;
+		StepCount = 240;
+		TimeStep = 1.0f / 60.0f;
+	}
+
+	void SolverBenchmark::BeginScene(Scene& scene, Physics::ContactSolverType solver, unsigned substeps)
+	{
+		scene.World = new Physics();
+		scene.World->InitializeWorld(1);
+		scene.World->ContactSolver = solver;
+		scene.World->Substeps = substeps;
+		//Every body is simulated every step
+		scene.World->LodEnabled = false;
+		scene.Objects.clear();
+	}
+
+	void SolverBenchmark::EndScene(Scene& scene)
+	{
+		for(unsigned i=0;i<scene.Objects.size();++i)
+		{
+			//Leave the world now so the body does not reach back into it
+			//when the factory deletes the object later
+			Body * body = scene.Objects[i]->has(Body);
+			scene.World->RemoveBody(body);
+			body->World = NULL;
+			FACTORY->Destroy(scene.Objects[i]);
+		}
+		scene.Objects.clear();
+		delete scene.World;
+		scene.World = NULL;
+	}
+
+	Body * SolverBenchmark::AddBox(Scene& scene, Vec2Param position, Vec2Param extents, float density)
+	{
+		GOC * object = FACTORY->CreateEmptyComposition();
+		Transform * transform = new Transform();
+		transform->Position = position;
+		object->AddComponent(CT_Transform, transform);
+
+		Body * body = new Body(scene.World);
+		body->Density = density;
+		body->Friction = 0.6f;
+		body->Restitution = 0.0f;
+		ShapeAAB * box = new ShapeAAB();
+		box->Extents = extents;
+		body->BodyShape = box;
+		object->AddComponent(CT_Body, body);
+
+		object->Initialize();
+		scene.Objects.push_back(object);
+		return body;
+	}
+
+	float SolverBenchmark::StepScene(Scene& scene)
+	{
+		TimeNs start = GetTimeNs();
+		for(unsigned i=0;i<StepCount;++i)
+		{
+			scene.World->Step(TimeStep);
+			scene.World->DeliverEvents();
+		}
+		return NsToMilliseconds(GetTimeNs() - start);
+	}
+
+	SolverBenchmark::Result SolverBenchmark::Run(Physics::ContactSolverType solver, unsigned substeps)
+	{
+		Result result;
+		Scene scene;
+
+		//Pyramid resting on a static ground, built just touching so it
+		//starts at rest. Box against box gives a single contact point that
+		//moves between corners, which rocks a box that can turn under any
+		//solver, so the blocks can not rotate and only the stacking is
+		//measured.
+		BeginScene(scene, solver, substeps);
+		AddBox(scene, Vec2(0, -BoxHalfSize * 2.0f), Vec2(BoxHalfSize * PyramidRows * 2.0f, BoxHalfSize), 0.0f);
+		std::vector<Body*> blocks;
+		std::vector<Vec2> starts;
+		for(unsigned row=0;row<PyramidRows;++row)
+		{
+			unsigned count = PyramidRows - row;
+			float left = -float(count - 1) * BoxHalfSize;
+			for(unsigned i=0;i<count;++i)
+			{
+				Vec2 position(left + i * BoxHalfSize * 2.0f, row * BoxHalfSize * 2.0f);
+				Body * block = AddBox(scene, position, Vec2(BoxHalfSize, BoxHalfSize), 3.0f);
+				block->InvInertia = 0.0f;
+				blocks.push_back(block);
+				starts.push_back(position);
+			}
+		}
+
+		result.PyramidMilliseconds = StepScene(scene);
+		result.PyramidMaxDrift = 0.0f;
+		result.PyramidAverageDrift = 0.0f;
+		for(unsigned i=0;i<blocks.size();++i)
+		{
+			float drift = sqrt( LengthSquared(blocks[i]->Position - starts[i]) );
+			result.PyramidMaxDrift = Max(result.PyramidMaxDrift, drift);
+			result.PyramidAverageDrift += drift;
+		}
+		if( !blocks.empty() )
+			result.PyramidAverageDrift /= float(blocks.size());
+		EndScene(scene);
+
+		//Ladder hanging from two static anchors. Each rung is a stick
+		//between a pair of joints and the rails are sticks between the
+		//rungs, so every rung closes a loop. The bottom rung is much
+		//heavier than the others, which is the hard case for iterative
+		//solvers.
+		BeginScene(scene, solver, substeps);
+		std::vector<Body*> stickBodies;
+		std::vector<float> stickLengths;
+		Vec2 halfRung(RungLength * 0.5f, 0.0f);
+		Body * left = AddBox(scene, -halfRung, JointExtents, 0.0f);
+		Body * right = AddBox(scene, halfRung, JointExtents, 0.0f);
+		for(unsigned i=0;i<LadderRungs;++i)
+		{
+			Vec2 center(0.0f, -(i + 1.0f) * RailLength);
+			float density = i + 1 == LadderRungs ? 30.0f : 1.0f;
+			Body * nextLeft = AddBox(scene, center - halfRung, JointExtents, density);
+			Body * nextRight = AddBox(scene, center + halfRung, JointExtents, density);
+
+			Body * ends[3][2] = { {left, nextLeft}, {right, nextRight}, {nextLeft, nextRight} };
+			float lengths[3] = { RailLength, RailLength, RungLength };
+			for(unsigned k=0;k<3;++k)
+			{
+				StickConstraint * stick = new StickConstraint();
+				stick->SetBodies(ends[k][0], ends[k][1]);
+				stick->SetBodyPoints(Vec2(0,0), Vec2(0,0));
+				stick->SetDistance(lengths[k]);
+				scene.World->AddConstraint(stick);
+				stickBodies.push_back(ends[k][0]);
+				stickBodies.push_back(ends[k][1]);
+				stickLengths.push_back(lengths[k]);
+			}
+
+			left = nextLeft;
+			right = nextRight;
+		}
+
+		result.LadderMilliseconds = StepScene(scene);
+		result.LadderMaxStretch = MaxStretch(stickBodies, stickLengths);
+		//The world deletes the sticks with the bodies
+		EndScene(scene);
+
+		//Rope of light links pinned at one end, released horizontally so
+		//it swings. It is a tree, so it is solved directly.
+		BeginScene(scene, solver, substeps);
+		stickBodies.clear();
+		stickLengths.clear();
+		Body * previous = AddBox(scene, Vec2(0,0), RopeJointExtents, 0.0f);
+		for(unsigned i=0;i<RopeLinks;++i)
+		{
+			Body * link = AddBox(scene, Vec2((i + 1.0f) * RopeLinkLength, 0.0f), RopeJointExtents, 1.0f);
+			StickConstraint * stick = new StickConstraint();
+			stick->SetBodies(previous, link);
+			stick->SetBodyPoints(Vec2(0,0), Vec2(0,0));
+			stick->SetDistance(RopeLinkLength);
+			scene.World->AddConstraint(stick);
+			stickBodies.push_back(previous);
+			stickBodies.push_back(link);
+			stickLengths.push_back(RopeLinkLength);
+			previous = link;
+		}
+
+		result.RopeMilliseconds = StepScene(scene);
+		result.RopeMaxStretch = MaxStretch(stickBodies, stickLengths);
+		EndScene(scene);
+
+		return result;
+	}
+
+	float SolverBenchmark::MaxStretch(const std::vector<Body*>& bodies, const std::vector<float>& lengths)
+	{
+		float stretch = 0.0f;
+		for(unsigned i=0;i<lengths.size();++i)
+		{
+			Vec2 offset = bodies[i * 2 + 1]->Position - bodies[i * 2]->Position;
+			stretch = Max(stretch, fabs( sqrt( LengthSquared(offset) ) - lengths[i] ));
+		}
+		return stretch;
+	}
+
+	void SolverBenchmark::PrintResult(const char * name, const Result& result)
+	{
+		LogPrint("%s: pyramid %.2f ms drift max %.3f avg %.3f, ladder %.2f ms stretch %.3f, rope %.2f ms stretch %.3f",
+			name, result.PyramidMilliseconds, result.PyramidMaxDrift, result.PyramidAverageDrift,
+			result.LadderMilliseconds, result.LadderMaxStretch, result.RopeMilliseconds, result.RopeMaxStretch);
+	}
+
+	void SolverBenchmark::RunComparison()
+	{
+		LogPrint("Solver comparison: %u pyramid rows, %u ladder rungs, %u rope links, %u steps", PyramidRows, LadderRungs, RopeLinks, StepCount);
+		PrintResult("Iterative", Run(Physics::SolverConstraints, 1));
+		PrintResult("Substepped x4", Run(Physics::SolverSubstepped, 4));
+		PrintResult("Substepped x8", Run(Physics::SolverSubstepped, 8));
+	}
+}
@@ -0,0 +1,72 @@
+///////////////////////////////////////////////////////////////////////////////////////
+///
+///	\file SolverBenchmark.h
+///	Compares the contact solvers on stiff stacks and ladders.
+///
+///	Authors: Chris Peters
+///	Copyright 2011, Digipen Institute of Technology
+///
+///////////////////////////////////////////////////////////////////////////////////////
+#pragma once //Makes sure this header is only included once
+
+#include "Physics.h"
+
+namespace Framework
+{
+	///Builds a box pyramid and a hanging ladder in worlds of their own and
+	///steps them with a solver, measuring how far they drift from the
+	///correct answer and how long the steps take. The pyramid should stay
+	///exactly where it was built and the ladder's sticks should stay at
+	///their lengths, so any motion or stretch is solver error. The ladder's
+	///rails and rungs form loops, so unlike a chain it can not be handed
+	///to the direct tree solver and both scenes exercise the solver under
+	///test. A long rope, which is a tree, measures the direct solver.
+	class SolverBenchmark
+	{
+	public:
+		SolverBenchmark();
+
+		struct Result
+		{
+			///Time spent stepping the pyramid, the ladder and the rope.
+			float PyramidMilliseconds;
+			float LadderMilliseconds;
+			float RopeMilliseconds;
+			///Largest and average distance a pyramid box moved from its start.
+			float PyramidMaxDrift;
+			float PyramidAverageDrift;
+			///Largest distance between ladder joints beyond the stick length.
+			float LadderMaxStretch;
+			///Largest distance between rope links beyond the link length.
+			float RopeMaxStretch;
+		};
+
+		///Run the scenes with a solver. The substep count is only used
+		///by the substepped solver.
+		Result Run(Physics::ContactSolverType solver, unsigned substeps);
+		///Run the iterative and substepped solvers and print the results.
+		void RunComparison();
+
+		unsigned PyramidRows;
+		unsigned LadderRungs;
+		unsigned RopeLinks;
+		unsigned StepCount;
+		float TimeStep;
+
+	private:
+		//Objects created for one scene. They are removed from the world
+		//before it is deleted.
+		struct Scene
+		{
+			Physics * World;
+			std::vector<GOC*> Objects;
+		};
+		void BeginScene(Scene& scene, Physics::ContactSolverType solver, unsigned substeps);
+		void EndScene(Scene& scene);
+		Body * AddBox(Scene& scene, Vec2Param position, Vec2Param extents, float density);
+		float StepScene(Scene& scene);
+		//Largest error of the sticks, given as pairs of bodies and lengths
+		float MaxStretch(const std::vector<Body*>& bodies, const std::vector<float>& lengths);
+		void PrintResult(const char * name, const Result& result);
+	};
+}
@@ -10,7 +10,6 @@
 #include "Precompiled.h"
 #include "Sprite.h"
 #include "Transform.h"
-#include "VertexTypes.h"
 #include "Graphics.h"
 
 namespace Framework
@@ -44,38 +43,12 @@ namespace Framework
 	}
 
 
-	void Sprite::Draw(IDirect3DDevice9*	pDevice,ID3DXEffect* shader)
+	void Sprite::Extract(SpriteInstance& instance)
 	{
-
-		//Transform the sprite.
-		Mat4 matSprite, matTranslate, matRotate;
-		//First, scale it to the proper width and height.
-		D3DXMatrixScaling(&matSprite, Size.x, Size.y, 1.0f);
-		//Then, rotate it to the proper angle.
-		D3DXMatrixRotationZ(&matRotate, transform->Rotation);
-		D3DXMatrixMultiply(&matSprite, &matSprite, &matRotate);
-		//Finally, move it to the proper location (note the floor functions on the positions).
-		D3DXMatrixTranslation(&matTranslate, floor(transform->Position.x), floor(transform->Position.y), 0.0f);
-		D3DXMatrixMultiply(&matSprite, &matSprite, &matTranslate);
-		
-		//Override the normal world transform and use the transform for this sprite.
-		shader->SetTechnique("Technique0");
-		pDevice->SetStreamSource(0, GRAPHICS->pQuadVertexBuffer, 0, sizeof(Vertex2D));
-		pDevice->SetFVF(VERTEX2D_FVF);
-
-		Mat4 worldViewProj = matSprite * GRAPHICS->ViewProjMatrix;
-		UINT numberOfPasses = 0;
-		shader->SetMatrix( "WorldViewProj", &worldViewProj );
-		shader->Begin(&numberOfPasses,0);
-		shader->SetTexture( "texture0" , pTexture );
-		shader->SetVector( "color" , &Color );
-		for(UINT pass=0;pass<numberOfPasses;++pass)
-		{
-			shader->BeginPass(pass);
-			pDevice->DrawPrimitive(D3DPT_TRIANGLESTRIP, 0, 2);
-			shader->EndPass();
-		}
-		shader->End();
+		instance.Position = transform->Position;
+		instance.Rotation = transform->Rotation;
+		instance.Size = Size;
+		instance.Color = Color;
+		instance.pTexture = pTexture;
 	}
-
 }
\ No newline at end of file
@@ -12,10 +12,29 @@
 #include "Composition.h"
 #include "VMath.h"
 
+//Direct3D types are only used through pointers so the
+//component does not need DirectX in headless builds
+struct IDirect3DDevice9;
+struct IDirect3DTexture9;
+struct ID3DXEffect;
+
 namespace Framework
 {
 	class Transform;
 
+	///What the renderer needs to draw a sprite. Copied from the sprite and
+	///its transform once a frame so rendering never reads live components.
+	struct SpriteInstance
+	{
+		Vec2 Position;
+		float Rotation;
+		Vec2 Size;
+		Vec4 Color;
+		IDirect3DTexture9*pTexture;
+		//Draw the sprite to the screen. Implemented by the renderer.
+		void Draw(IDirect3DDevice9*pDevice,ID3DXEffect* shader,const Mat4& viewProj);
+	};
+
 	/// A two-dimensional hardware accelerated sprite class using textures.
 	/// Has color, size, and a sprite texture name.
 	/// Depends on Transform.
@@ -40,7 +59,7 @@ namespace Framework
 		std::string SpriteName;
 		//Blend color of this sprite
 		Vec4 Color;
-		//Draw the sprite to the screen
-		void Draw(IDirect3DDevice9*pDevice,ID3DXEffect* shader);
+		//Copy the current state of the sprite for rendering
+		void Extract(SpriteInstance& instance);
 	};
 }
\ No newline at end of file
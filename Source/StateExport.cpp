@@ -0,0 +1,139 @@
+///////////////////////////////////////////////////////////////////////////////////////
+//
+//	StateExport.cpp
+//
+//	Authors: Chris Peters
+//	Copyright 2011, Digipen Institute of Technology
+//
+///////////////////////////////////////////////////////////////////////////////////////
+#include "Precompiled.h"
+#include "StateExport.h"
+#include "Body.h"
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstring>
+//Full fence, the same as the windows macro
+#define MemoryBarrier() __sync_synchronize()
+#endif
+
+namespace Framework
+{
+	using namespace StateExport;
+
+	StateExporter::StateExporter()
+	{
+		Mapping = NULL;
+		MappedSize = 0;
+		View = NULL;
+		BlockHeader = NULL;
+		StepNumber = 0;
+	}
+
+	StateExporter::~StateExporter()
+	{
+		Shutdown();
+	}
+
+	bool StateExporter::Initialize(const std::string& name, unsigned maxBodies, unsigned slotCount)
+	{
+		ErrorIf(slotCount == 0, "State export needs at least one slot.");
+
+		unsigned slotSize = sizeof(SlotHeader) + maxBodies * sizeof(BodyState);
+		unsigned totalSize = sizeof(Header) + slotCount * slotSize;
+
+#ifdef _WIN32
+		Mapping = CreateFileMapping(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, totalSize, name.c_str());
+		if( Mapping == NULL )
+			return false;
+
+		View = (char*)MapViewOfFile((HANDLE)Mapping, FILE_MAP_ALL_ACCESS, 0, 0, totalSize);
+#else
+		//Posix shared memory names start with a slash and the block
+		//shows up as /dev/shm/<name> on linux
+		int file = shm_open(("/" + name).c_str(), O_CREAT | O_RDWR, 0644);
+		if( file < 0 )
+			return false;
+		if( ftruncate(file, totalSize) == 0 )
+		{
+			void * view = mmap(NULL, totalSize, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+			View = view == MAP_FAILED ? NULL : (char*)view;
+		}
+		//The mapping keeps the memory alive without the file
+		close(file);
+#endif
+		if( View == NULL )
+		{
+			Shutdown();
+			return false;
+		}
+		MappedSize = totalSize;
+
+		memset(View, 0, totalSize);
+		BlockHeader = (Header*)View;
+		BlockHeader->SlotCount = slotCount;
+		BlockHeader->MaxBodies = maxBodies;
+		BlockHeader->SlotSize = slotSize;
+		BlockHeader->Version = Version;
+		//Magic is written last so readers never see a half set up header
+		MemoryBarrier();
+		BlockHeader->Magic = Magic;
+		return true;
+	}
+
+	void StateExporter::Shutdown()
+	{
+#ifdef _WIN32
+		if( View )
+			UnmapViewOfFile(View);
+		if( Mapping )
+			CloseHandle((HANDLE)Mapping);
+#else
+		if( View )
+			munmap(View, MappedSize);
+#endif
+		View = NULL;
+		Mapping = NULL;
+		MappedSize = 0;
+		BlockHeader = NULL;
+	}
+
+	void StateExporter::Publish(ObjectLinkList<Body>& bodies, float dt)
+	{
+		if( BlockHeader == NULL )
+			return;
+
+		++StepNumber;
+		unsigned slotIndex = StepNumber % BlockHeader->SlotCount;
+		SlotHeader * slot = (SlotHeader*)(View + sizeof(Header) + slotIndex * BlockHeader->SlotSize);
+		BodyState * states = (BodyState*)(slot + 1);
+
+		//Odd sequence marks the slot as being written
+		++slot->Sequence;
+		MemoryBarrier();
+
+		unsigned count = 0;
+		for(ObjectLinkList<Body>::iterator it=bodies.begin();it!=bodies.end() && count < BlockHeader->MaxBodies;++it)
+		{
+			BodyState& state = states[count++];
+			state.ObjectId = it->GetOwner()->GetId();
+			state.PositionX = it->Position.x;
+			state.PositionY = it->Position.y;
+			state.Rotation = it->Rotation;
+			state.VelocityX = it->Velocity.x;
+			state.VelocityY = it->Velocity.y;
+			state.AngularVelocity = it->AngularVelocity;
+			state.ContactCount = it->ContactCount;
+		}
+		slot->StepNumber = StepNumber;
+		slot->BodyCount = count;
+		slot->StepTime = dt;
+
+		//Even sequence marks the slot as complete
+		MemoryBarrier();
+		++slot->Sequence;
+		MemoryBarrier();
+		BlockHeader->LatestStep = StepNumber;
+	}
+}
@@ -0,0 +1,43 @@
+///////////////////////////////////////////////////////////////////////////////////////
+///
+///	\file StateExport.h
+///	Publishes per body state each physics step to a shared memory ring
+///	buffer so external tools can watch a live simulation.
+///
+///	Authors: Chris Peters
+///	Copyright 2011, Digipen Institute of Technology
+///
+///////////////////////////////////////////////////////////////////////////////////////
+#pragma once //Makes sure this header is only included once
+
+#include "StateExportLayout.h"
+
+namespace Framework
+{
+	class Body;
+
+	///Writes body state into a named shared memory block. See
+	///StateExportLayout.h for the layout and the reading protocol.
+	///Publishing never waits on readers.
+	class StateExporter
+	{
+	public:
+		StateExporter();
+		~StateExporter();
+
+		///Create the shared memory block. Bodies past maxBodies are not
+		///exported. Returns false if the block could not be created.
+		bool Initialize(const std::string& name, unsigned maxBodies, unsigned slotCount);
+		void Shutdown();
+
+		///Write the state of all the bodies as the next step.
+		void Publish(ObjectLinkList<Body>& bodies, float dt);
+
+	private:
+		void* Mapping;
+		unsigned MappedSize;
+		char* View;
+		StateExport::Header* BlockHeader;
+		unsigned StepNumber;
+	};
+}
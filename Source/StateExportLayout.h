@@ -0,0 +1,77 @@
+///////////////////////////////////////////////////////////////////////////////////////
+///
+///	\file StateExportLayout.h
+///	Layout of the shared memory block written by the StateExporter. This
+///	header has no engine dependencies so external tools can include it.
+///
+///	The block is a Header followed by SlotCount slots of SlotSize bytes.
+///	Each slot is a SlotHeader followed by MaxBodies BodyStates, of which
+///	the first BodyCount are valid. Step n is written to slot n % SlotCount.
+///
+///	Writing a slot (seqlock):
+///		Sequence is incremented to an odd value, the slot is written, then
+///		Sequence is incremented to an even value. Header::LatestStep is then
+///		set to the step number.
+///	Reading a slot:
+///		Read Sequence. If odd the slot is being written, try again. Copy
+///		the slot, then read Sequence again. If it changed the copy is torn
+///		and must be retried. Readers never block the writer.
+///
+///	Authors: Chris Peters
+///	Copyright 2011, Digipen Institute of Technology
+///
+///////////////////////////////////////////////////////////////////////////////////////
+#pragma once //Makes sure this header is only included once
+
+namespace Framework
+{
+	namespace StateExport
+	{
+		///Default name of the file mapping.
+		static const char DefaultName[] = "GameEngineState";
+		///'PHYS' in memory on little endian machines.
+		const unsigned Magic = 0x53594850;
+		const unsigned Version = 1;
+
+		///Start of the block. 64 bytes.
+		struct Header
+		{
+			unsigned Magic;
+			unsigned Version;
+			unsigned SlotCount;
+			unsigned MaxBodies;
+			///Bytes per slot, including the slot header.
+			unsigned SlotSize;
+			///Step number of the newest complete slot. Zero until the first
+			///step is written. Step numbers start at one.
+			volatile unsigned LatestStep;
+			unsigned Reserved[10];
+		};
+
+		///Start of each slot. 16 bytes.
+		struct SlotHeader
+		{
+			///Odd while the slot is being written.
+			volatile unsigned Sequence;
+			unsigned StepNumber;
+			unsigned BodyCount;
+			///Length of the step in seconds.
+			float StepTime;
+		};
+
+		///State of one body after the step. 32 bytes.
+		struct BodyState
+		{
+			///Id of the object that owns the body.
+			unsigned ObjectId;
+			float PositionX;
+			float PositionY;
+			float Rotation;
+			float VelocityX;
+			float VelocityY;
+			float AngularVelocity;
+			///Number of contacts the body had during the step.
+			unsigned ContactCount;
+		};
+	}
+}
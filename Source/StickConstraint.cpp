@@ -18,9 +18,9 @@ namespace Framework
 {
 
   /*
-    C   : .5(p2 - p1)^2 - L^2 = 0
-    cDot: (p2 - p1) * (v2 + cross(w2,r2) - v1 - cross(w1,r1) = 0
-    Let : d = p2 - p1
+    C   : |p2 - p1| - L = 0
+    Let : d = (p2 - p1) / |p2 - p1|
+    cDot: d * (v2 + cross(w2,r2) - v1 - cross(w1,r1)) = 0
     cDot: dot(d,v2) + dot(d,cross(w2,r2)) - dot(d,v1) - dot(d,cross(w1,r1)) = 0
     cDot: dot(d,v2) + dot(w2,cross(r2,d)) - dot(d,v1) - dot(w1,cross(r1,d)) = 0
     J   : [-d,-cross(r1,d),d,cross(r2,d)]
@@ -51,13 +51,21 @@ namespace Framework
 
     Vec2 p2p1 = worldPoint2 - worldPoint1;
     float distance = Normalize(p2p1);
-    Bias = .5f * distance * distance - Distance * Distance;
+    //Coincident points have no direction, any axis will push them apart
+    if(distance == 0.0f)
+      p2p1 = Vec2(1.0f, 0.0f);
+    //Like the contacts the bias is the raw position error
+    Bias = distance - Distance;
     //the jacobian is ( -d, -r1 x d, d, r2 x d)
     StickJacobian.Set(-p2p1,-Cross2D(worldR1,p2p1),
                        p2p1, Cross2D(worldR2,p2p1));
     EffectiveMass = CalculateEffectiveMass(StickJacobian);
+  }
 
-
+  void StickConstraint::DebugDraw()
+  {
+    Vec2 worldPoint1 = Bodies[0]->GetWorldPointFromBodyPoint(BodyRs[0]);
+    Vec2 worldPoint2 = Bodies[1]->GetWorldPointFromBodyPoint(BodyRs[1]);
     Drawer::Instance.DrawSegment( worldPoint1 , worldPoint2 );
   }
 
@@ -79,6 +87,17 @@ namespace Framework
     ApplyConstraintImpulse(StickJacobian,lambda);
   }
 
+  void StickConstraint::WarmStart(float scale)
+  {
+    AccumulatedImpulse *= scale;
+    ApplyConstraintImpulse(StickJacobian,AccumulatedImpulse);
+  }
+
+  void StickConstraint::ClearImpulse()
+  {
+    AccumulatedImpulse = 0;
+  }
+
   void StickConstraint::SetBodyPoints(Vec2Param body1Point, Vec2Param body2Point)
   {
     BodyRs[0] = body1Point;
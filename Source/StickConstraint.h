@@ -25,11 +25,17 @@ namespace Framework
 
     virtual void Update(float dt);
     virtual void SolveIteration(float dt);
+    virtual void WarmStart(float scale);
+    virtual void ClearImpulse();
+    virtual void DebugDraw();
+    virtual bool IsStick() { return true; }
 
     void SetBodyPoints(Vec2Param body1Point, Vec2Param body2Point);
     void SetDistance(float distance);
 
   private:
+    friend class ConstraintSolver;
+
     // We can cache the mass that the constraint feels since it
     // doesn't change during each iteration of one frame.
     float EffectiveMass;
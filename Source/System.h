@@ -12,13 +12,39 @@
 
 namespace Framework
 {
+	///Engine data a system may use during Update. The core only updates two
+	///systems at the same time if neither writes data the other reads or
+	///writes. A broadcast reaches its subscribers right away, so a system
+	///that broadcasts during Update (writes Messages) runs alone. Queued
+	///messages are delivered after all systems update and need no flag.
+	namespace SystemData
+	{
+		enum Flags
+		{
+			///The window and input state.
+			Input = 1 << 0,
+			///Broadcasting messages through the core.
+			Messages = 1 << 1,
+			///Creating, destroying and sending messages to game objects.
+			Objects = 1 << 2,
+			Transforms = 1 << 3,
+			///Bodies, constraints and particles.
+			Bodies = 1 << 4,
+			///Sprites, cameras and the graphics device.
+			Sprites = 1 << 5,
+			///Debug lines queued for drawing.
+			DebugLines = 1 << 6,
+			All = 0xffffffff
+		};
+	}
+
 	///System is a pure virtual base class (which is to say, an interface) that is
 	///the base class for all systems used by the game. 
 	class ISystem
 	{
 	public:
-		///Systems can receive all message send to the Core. 
-		///See Message.h for details.
+		///Systems receive the messages sent to the Core with the ids they
+		///subscribe to (CoreEngine::Subscribe). See Message.h for details.
 		virtual void SendMessage(Message* message) {};
 
 		///All systems are updated every game frame.
@@ -29,6 +55,19 @@ namespace Framework
 
 		///Initialize the system.
 		virtual void Initialize(){};
+
+		///Called on the main thread at the end of every frame, after the
+		///queued messages are delivered, while no system is updating.
+		///Copy out state here that other threads read during the next frame.
+		virtual void EndFrame(){};
+
+		///Data read and written by Update (SystemData flags). Systems that
+		///do not say are assumed to use everything and run in add order.
+		virtual unsigned GetReads(){return SystemData::All;}
+		virtual unsigned GetWrites(){return SystemData::All;}
+		///Systems bound to the main thread (windows, graphics devices) are
+		///never updated on a worker.
+		virtual bool RunsOnMainThread(){return false;}
 		
 		///All systems need a virtual destructor to have their destructor called 
 		virtual ~ISystem(){}						
@@ -10,12 +10,20 @@
 
 #include "Precompiled.h"
 #include "TextSerialization.h"
+#include <algorithm>
 
 namespace Framework
 {
 	bool TextSerializer::Open(const std::string& file)
 	{
+#ifdef _WIN32
 		stream.open(file.c_str());
+#else
+		//Data files name each other with windows paths
+		std::string path = file;
+		std::replace(path.begin(), path.end(), '\\', '/');
+		stream.open(path.c_str());
+#endif
 		return stream.is_open();
 	}
 
@@ -0,0 +1,410 @@
+///////////////////////////////////////////////////////////////////////////////////////
+//
+//	Threading.cpp
+//
+//	Authors: Chris Peters
+//	Copyright 2011, Digipen Institute of Technology
+//
+///////////////////////////////////////////////////////////////////////////////////////
+#include "Precompiled.h"
+#include "Threading.h"
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+namespace Framework
+{
+	//Data handed to the new thread so it can call the engine thread function
+	struct ThreadStartData
+	{
+		ThreadFunction Function;
+		void * Data;
+	};
+
+#ifdef _WIN32
+
+	//Entry point with the signature _beginthreadex requires
+	unsigned __stdcall ThreadEntry(void * data)
+	{
+		ThreadStartData start = *(ThreadStartData*)data;
+		delete (ThreadStartData*)data;
+		return start.Function(start.Data);
+	}
+
+	Thread::Thread()
+	{
+		Handle = NULL;
+	}
+
+	Thread::~Thread()
+	{
+		ErrorIf(Handle!=NULL,"Thread was not joined before it was destroyed.");
+	}
+
+	bool Thread::Start(ThreadFunction function, void* data)
+	{
+		ThreadStartData * start = new ThreadStartData();
+		start->Function = function;
+		start->Data = data;
+
+		//Use _beginthreadex instead of CreateThread so the CRT
+		//is initialized correctly for the new thread
+		Handle = (void*)_beginthreadex(NULL, 0, ThreadEntry, start, 0, NULL);
+		if( Handle == NULL )
+		{
+			delete start;
+			return false;
+		}
+		return true;
+	}
+
+	void Thread::Join()
+	{
+		if( Handle == NULL ) return;
+		WaitForSingleObject((HANDLE)Handle, INFINITE);
+		CloseHandle((HANDLE)Handle);
+		Handle = NULL;
+	}
+
+	ThreadEvent::ThreadEvent()
+	{
+		//Auto reset and not signaled
+		Handle = CreateEvent(NULL, FALSE, FALSE, NULL);
+	}
+
+	ThreadEvent::~ThreadEvent()
+	{
+		CloseHandle((HANDLE)Handle);
+	}
+
+	void ThreadEvent::Signal()
+	{
+		SetEvent((HANDLE)Handle);
+	}
+
+	void ThreadEvent::Wait()
+	{
+		WaitForSingleObject((HANDLE)Handle, INFINITE);
+	}
+
+	ThreadSemaphore::ThreadSemaphore()
+	{
+		Handle = CreateSemaphore(NULL, 0, LONG_MAX, NULL);
+	}
+
+	ThreadSemaphore::~ThreadSemaphore()
+	{
+		CloseHandle((HANDLE)Handle);
+	}
+
+	void ThreadSemaphore::Release(unsigned count)
+	{
+		if( count > 0 )
+			ReleaseSemaphore((HANDLE)Handle, count, NULL);
+	}
+
+	void ThreadSemaphore::Wait()
+	{
+		WaitForSingleObject((HANDLE)Handle, INFINITE);
+	}
+
+	Mutex::Mutex()
+	{
+		CRITICAL_SECTION * section = new CRITICAL_SECTION;
+		//Spin briefly before sleeping since the locks are held for very short times
+		InitializeCriticalSectionAndSpinCount(section, 1000);
+		Section = section;
+	}
+
+	Mutex::~Mutex()
+	{
+		DeleteCriticalSection((CRITICAL_SECTION*)Section);
+		delete (CRITICAL_SECTION*)Section;
+	}
+
+	void Mutex::Lock()
+	{
+		EnterCriticalSection((CRITICAL_SECTION*)Section);
+	}
+
+	void Mutex::Unlock()
+	{
+		LeaveCriticalSection((CRITICAL_SECTION*)Section);
+	}
+
+	ThreadLocal::ThreadLocal()
+	{
+		Index = TlsAlloc();
+		ErrorIf(Index==TLS_OUT_OF_INDEXES,"Out of thread local storage slots.");
+	}
+
+	ThreadLocal::~ThreadLocal()
+	{
+		TlsFree(Index);
+	}
+
+	void ThreadLocal::Set(void* value)
+	{
+		TlsSetValue(Index, value);
+	}
+
+	void* ThreadLocal::Get()
+	{
+		return TlsGetValue(Index);
+	}
+
+	unsigned GetHardwareThreadCount()
+	{
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+		return info.dwNumberOfProcessors > 0 ? info.dwNumberOfProcessors : 1;
+	}
+
+	long AtomicIncrement(volatile long* value)
+	{
+		return InterlockedIncrement(value);
+	}
+
+	long AtomicDecrement(volatile long* value)
+	{
+		return InterlockedDecrement(value);
+	}
+
+	long AtomicCompareExchange(volatile long* value, long exchange, long comparand)
+	{
+		return InterlockedCompareExchange(value, exchange, comparand);
+	}
+
+	long AtomicLoadAcquire(volatile long* value)
+	{
+		//An exchange that never changes the value is a locked read
+		return InterlockedCompareExchange(value, 0, 0);
+	}
+
+	void MemoryFence()
+	{
+		MemoryBarrier();
+	}
+
+	void YieldThread()
+	{
+		SwitchToThread();
+	}
+
+#else
+
+	//Entry point with the signature pthread_create requires
+	void* ThreadEntry(void * data)
+	{
+		ThreadStartData start = *(ThreadStartData*)data;
+		delete (ThreadStartData*)data;
+		start.Function(start.Data);
+		return NULL;
+	}
+
+	Thread::Thread()
+	{
+		Handle = NULL;
+	}
+
+	Thread::~Thread()
+	{
+		ErrorIf(Handle!=NULL,"Thread was not joined before it was destroyed.");
+	}
+
+	bool Thread::Start(ThreadFunction function, void* data)
+	{
+		ThreadStartData * start = new ThreadStartData();
+		start->Function = function;
+		start->Data = data;
+
+		pthread_t * thread = new pthread_t;
+		if( pthread_create(thread, NULL, ThreadEntry, start) != 0 )
+		{
+			delete thread;
+			delete start;
+			return false;
+		}
+		Handle = thread;
+		return true;
+	}
+
+	void Thread::Join()
+	{
+		if( Handle == NULL ) return;
+		pthread_join(*(pthread_t*)Handle, NULL);
+		delete (pthread_t*)Handle;
+		Handle = NULL;
+	}
+
+	//Events and semaphores are both a count guarded by a condition
+	struct WaitCount
+	{
+		pthread_mutex_t Lock;
+		pthread_cond_t Changed;
+		unsigned Count;
+
+		WaitCount()
+		{
+			pthread_mutex_init(&Lock, NULL);
+			pthread_cond_init(&Changed, NULL);
+			Count = 0;
+		}
+
+		~WaitCount()
+		{
+			pthread_cond_destroy(&Changed);
+			pthread_mutex_destroy(&Lock);
+		}
+
+		//Add to the count, or with a limit set it no higher than the limit
+		void Release(unsigned count, unsigned limit)
+		{
+			pthread_mutex_lock(&Lock);
+			Count += count;
+			if( limit && Count > limit )
+				Count = limit;
+			pthread_cond_broadcast(&Changed);
+			pthread_mutex_unlock(&Lock);
+		}
+
+		void Wait()
+		{
+			pthread_mutex_lock(&Lock);
+			while( Count == 0 )
+				pthread_cond_wait(&Changed, &Lock);
+			--Count;
+			pthread_mutex_unlock(&Lock);
+		}
+	};
+
+	ThreadEvent::ThreadEvent()
+	{
+		Handle = new WaitCount();
+	}
+
+	ThreadEvent::~ThreadEvent()
+	{
+		delete (WaitCount*)Handle;
+	}
+
+	void ThreadEvent::Signal()
+	{
+		//An auto reset event stays signaled until one wait takes it
+		((WaitCount*)Handle)->Release(1, 1);
+	}
+
+	void ThreadEvent::Wait()
+	{
+		((WaitCount*)Handle)->Wait();
+	}
+
+	ThreadSemaphore::ThreadSemaphore()
+	{
+		Handle = new WaitCount();
+	}
+
+	ThreadSemaphore::~ThreadSemaphore()
+	{
+		delete (WaitCount*)Handle;
+	}
+
+	void ThreadSemaphore::Release(unsigned count)
+	{
+		if( count > 0 )
+			((WaitCount*)Handle)->Release(count, 0);
+	}
+
+	void ThreadSemaphore::Wait()
+	{
+		((WaitCount*)Handle)->Wait();
+	}
+
+	Mutex::Mutex()
+	{
+		pthread_mutex_t * mutex = new pthread_mutex_t;
+		pthread_mutex_init(mutex, NULL);
+		Section = mutex;
+	}
+
+	Mutex::~Mutex()
+	{
+		pthread_mutex_destroy((pthread_mutex_t*)Section);
+		delete (pthread_mutex_t*)Section;
+	}
+
+	void Mutex::Lock()
+	{
+		pthread_mutex_lock((pthread_mutex_t*)Section);
+	}
+
+	void Mutex::Unlock()
+	{
+		pthread_mutex_unlock((pthread_mutex_t*)Section);
+	}
+
+	ThreadLocal::ThreadLocal()
+	{
+		pthread_key_t key = 0;
+		if( pthread_key_create(&key, NULL) != 0 )
+			ErrorIf(true,"Out of thread local storage slots.");
+		Index = (unsigned long)key;
+	}
+
+	ThreadLocal::~ThreadLocal()
+	{
+		pthread_key_delete((pthread_key_t)Index);
+	}
+
+	void ThreadLocal::Set(void* value)
+	{
+		pthread_setspecific((pthread_key_t)Index, value);
+	}
+
+	void* ThreadLocal::Get()
+	{
+		return pthread_getspecific((pthread_key_t)Index);
+	}
+
+	unsigned GetHardwareThreadCount()
+	{
+		long count = sysconf(_SC_NPROCESSORS_ONLN);
+		return count > 0 ? (unsigned)count : 1;
+	}
+
+	long AtomicIncrement(volatile long* value)
+	{
+		return __sync_add_and_fetch(value, 1);
+	}
+
+	long AtomicDecrement(volatile long* value)
+	{
+		return __sync_sub_and_fetch(value, 1);
+	}
+
+	long AtomicCompareExchange(volatile long* value, long exchange, long comparand)
+	{
+		return __sync_val_compare_and_swap(value, comparand, exchange);
+	}
+
+	long AtomicLoadAcquire(volatile long* value)
+	{
+		return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+	}
+
+	void MemoryFence()
+	{
+		__sync_synchronize();
+	}
+
+	void YieldThread()
+	{
+		sched_yield();
+	}
+
+#endif
+}
@@ -0,0 +1,126 @@
+///////////////////////////////////////////////////////////////////////////////////////
+///
+///	\file Threading.h
+///	Thin wrappers around the operating system threading primitives used by
+///	the engine (threads, events, locks and thread local values).
+///
+///	Authors: Chris Peters
+///	Copyright 2011, Digipen Institute of Technology
+///
+///////////////////////////////////////////////////////////////////////////////////////
+#pragma once //Makes sure this header is only included once
+
+namespace Framework
+{
+	///Function run by a thread. The return value is the thread's exit code.
+	typedef unsigned (*ThreadFunction)(void* data);
+
+	///A single operating system thread.
+	class Thread
+	{
+	public:
+		Thread();
+		~Thread();
+		///Start running the function on a new thread.
+		bool Start(ThreadFunction function, void* data);
+		///Wait for the thread to finish and release it.
+		void Join();
+		bool IsRunning(){return Handle != NULL;}
+	private:
+		//Threads can not be copied
+		Thread(const Thread&);
+		Thread& operator=(const Thread&);
+		void* Handle;
+	};
+
+	///An auto reset event. Each Signal releases one Wait.
+	class ThreadEvent
+	{
+	public:
+		ThreadEvent();
+		~ThreadEvent();
+		void Signal();
+		void Wait();
+	private:
+		ThreadEvent(const ThreadEvent&);
+		ThreadEvent& operator=(const ThreadEvent&);
+		void* Handle;
+	};
+
+	///A counting semaphore. Each Release of n lets n Waits through.
+	class ThreadSemaphore
+	{
+	public:
+		ThreadSemaphore();
+		~ThreadSemaphore();
+		void Release(unsigned count);
+		void Wait();
+	private:
+		ThreadSemaphore(const ThreadSemaphore&);
+		ThreadSemaphore& operator=(const ThreadSemaphore&);
+		void* Handle;
+	};
+
+	///A lock that one thread holds at a time. Short critical sections only.
+	class Mutex
+	{
+	public:
+		Mutex();
+		~Mutex();
+		void Lock();
+		void Unlock();
+	private:
+		Mutex(const Mutex&);
+		Mutex& operator=(const Mutex&);
+		void* Section;
+	};
+
+	///Locks a mutex for the lifetime of the scope.
+	class ScopedLock
+	{
+	public:
+		ScopedLock(Mutex& mutex) : LockedMutex(mutex) { LockedMutex.Lock(); }
+		~ScopedLock() { LockedMutex.Unlock(); }
+	private:
+		ScopedLock(const ScopedLock&);
+		ScopedLock& operator=(const ScopedLock&);
+		Mutex& LockedMutex;
+	};
+
+	///A pointer sized value with a separate copy for each thread.
+	///Every thread starts with NULL.
+	class ThreadLocal
+	{
+	public:
+		ThreadLocal();
+		~ThreadLocal();
+		void Set(void* value);
+		void* Get();
+	private:
+		ThreadLocal(const ThreadLocal&);
+		ThreadLocal& operator=(const ThreadLocal&);
+		unsigned long Index;
+	};
+
+	///Number of hardware threads (cores) available to the process.
+	unsigned GetHardwareThreadCount();
+
+	///Atomically add one to the value and return the new value. Like all
+	///the read-modify-write operations it is a full memory barrier.
+	long AtomicIncrement(volatile long* value);
+	///Atomically subtract one from the value and return the new value.
+	long AtomicDecrement(volatile long* value);
+	///Atomically set the value to exchange if it equals comparand. Returns
+	///the value it had before either way.
+	long AtomicCompareExchange(volatile long* value, long exchange, long comparand);
+	///Read a value written by other threads with acquire semantics. Memory
+	///accesses after it are not moved before it, so everything written
+	///before the write that produced the value is seen.
+	long AtomicLoadAcquire(volatile long* value);
+	///Full memory barrier. Memory accesses before it are seen by other
+	///threads before any of the accesses after it.
+	void MemoryFence();
+
+	///Give the rest of this thread's time slice to another thread.
+	void YieldThread();
+}
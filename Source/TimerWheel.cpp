@@ -0,0 +1,206 @@
+///////////////////////////////////////////////////////////////////////////////////////
+//
+//	TimerWheel.cpp
+//
+//	Authors: Chris Peters
+//	Copyright 2011, Digipen Institute of Technology
+//
+///////////////////////////////////////////////////////////////////////////////////////
+#include "Precompiled.h"
+#include "TimerWheel.h"
+#include "Factory.h"
+#include <cmath>
+
+namespace Framework
+{
+	TimerWheel* TIMERS = NULL;
+
+	//The same rate physics steps at
+	const float TimerWheel::TickTime = 1.0f / 60.0f;
+
+	TimerWheel::TimerWheel()
+	{
+		FreeList = -1;
+		for(unsigned i=0;i<=DueList;++i)
+			Slots[i] = -1;
+		CurrentTick = 0;
+		Accumulator = 0.0f;
+		PendingCount = 0;
+	}
+
+	TimerId TimerWheel::Schedule(float delay, GOCId object, TimerFunction function, void* data)
+	{
+		int index = FreeList;
+		if( index != -1 )
+		{
+			FreeList = Timers[index].Next;
+		}
+		else
+		{
+			ErrorIf(Timers.size() + 1 >= (1u << IndexBits), "Too many timers.");
+			index = Timers.size();
+			Timers.push_back(Timer());
+			Timers.back().Generation = 0;
+		}
+
+		//Fire on the first tick that reaches the delay, and never on
+		//the tick being run so timers scheduled by timers wait a tick
+		Tick ticks = Tick( ceil(delay / TickTime) );
+		if( delay <= 0.0f || ticks == 0 )
+			ticks = 1;
+
+		Timer& timer = Timers[index];
+		timer.Expire = CurrentTick + ticks - 1;
+		timer.Object = object;
+		timer.Function = function;
+		timer.Data = data;
+		Place(index);
+		++PendingCount;
+
+		unsigned generation = timer.Generation & ((1u << (32 - IndexBits)) - 1);
+		return (generation << IndexBits) | unsigned(index + 1);
+	}
+
+	void TimerWheel::Cancel(TimerId timer)
+	{
+		int index = Find(timer);
+		if( index == -1 )
+			return;
+		Unlink(index);
+		Release(index);
+	}
+
+	void TimerWheel::Advance(float dt)
+	{
+		Accumulator += dt;
+		while( Accumulator >= TickTime )
+		{
+			Accumulator -= TickTime;
+			ProcessTick();
+		}
+	}
+
+	double TimerWheel::GetTime()
+	{
+		return double(CurrentTick) * TickTime;
+	}
+
+	void TimerWheel::Place(int index)
+	{
+		Timer& timer = Timers[index];
+
+		//The wheel is picked by how far away the timer is, so it always
+		//comes up within one turn of that wheel. Timers too far away for
+		//the last wheel wait in its furthest slot and are placed again
+		//from there, so a timer only reaches the first wheel once it is
+		//due within a turn of it.
+		Tick base = CurrentTick;
+		Tick expire = timer.Expire > base ? timer.Expire : base;
+		if( expire - base >= MaxDelayTicks )
+			expire = base + MaxDelayTicks - 1;
+		Tick delta = expire - base;
+
+		unsigned wheel = 0;
+		while( wheel < WheelCount - 1 && delta >= (Tick(1) << (SlotBits * (wheel + 1))) )
+			++wheel;
+		int slot = wheel * SlotCount + int( (expire >> (SlotBits * wheel)) & (SlotCount - 1) );
+
+		timer.Slot = slot;
+		timer.Prev = -1;
+		timer.Next = Slots[slot];
+		if( timer.Next != -1 )
+			Timers[timer.Next].Prev = index;
+		Slots[slot] = index;
+	}
+
+	void TimerWheel::Unlink(int index)
+	{
+		Timer& timer = Timers[index];
+		if( timer.Prev != -1 )
+			Timers[timer.Prev].Next = timer.Next;
+		else
+			Slots[timer.Slot] = timer.Next;
+		if( timer.Next != -1 )
+			Timers[timer.Next].Prev = timer.Prev;
+	}
+
+	void TimerWheel::Release(int index)
+	{
+		//A new generation makes the old handle stale
+		Timer& timer = Timers[index];
+		timer.Slot = -1;
+		++timer.Generation;
+		timer.Next = FreeList;
+		FreeList = index;
+		--PendingCount;
+	}
+
+	void TimerWheel::Cascade(unsigned wheel)
+	{
+		//Every timer in the slot that has come up is closer than one turn
+		//of the wheel below, so they all move down
+		int slot = wheel * SlotCount + int( (CurrentTick >> (SlotBits * wheel)) & (SlotCount - 1) );
+		int index = Slots[slot];
+		Slots[slot] = -1;
+		while( index != -1 )
+		{
+			int next = Timers[index].Next;
+			Place(index);
+			index = next;
+		}
+	}
+
+	void TimerWheel::ProcessTick()
+	{
+		//When a wheel finishes a turn the next slot of the wheel above comes up
+		for(unsigned wheel=1;wheel<WheelCount;++wheel)
+		{
+			if( (CurrentTick & ((Tick(1) << (SlotBits * wheel)) - 1)) != 0 )
+				break;
+			Cascade(wheel);
+		}
+
+		Tick tick = CurrentTick;
+		++CurrentTick;
+
+		//Move the whole slot to the due list first. A timer scheduled by
+		//one of these a full turn ahead goes in this slot and must not
+		//fire now. Due timers can still be canceled before they fire.
+		int slot = int(tick & (SlotCount - 1));
+		for(int index = Slots[slot]; index != -1; index = Timers[index].Next)
+			Timers[index].Slot = DueList;
+		Slots[DueList] = Slots[slot];
+		Slots[slot] = -1;
+
+		while( Slots[DueList] != -1 )
+		{
+			//Release before calling so the function can schedule
+			//and cancel timers freely
+			int index = Slots[DueList];
+			Unlink(index);
+			Timer timer = Timers[index];
+			Release(index);
+
+			GOC * object = NULL;
+			if( timer.Object != 0 )
+			{
+				object = FACTORY->GetObjectWithId(timer.Object);
+				//The object was destroyed so the timer is dropped
+				if( object == NULL )
+					continue;
+			}
+			timer.Function(object, timer.Data);
+		}
+	}
+
+	int TimerWheel::Find(TimerId timer)
+	{
+		int index = int(timer & ((1u << IndexBits) - 1)) - 1;
+		if( index < 0 || index >= (int)Timers.size() || Timers[index].Slot == -1 )
+			return -1;
+		unsigned generation = Timers[index].Generation & ((1u << (32 - IndexBits)) - 1);
+		if( (timer >> IndexBits) != generation )
+			return -1;
+		return index;
+	}
+}
@@ -0,0 +1,102 @@
+///////////////////////////////////////////////////////////////////////////////////////
+///
+///	\file TimerWheel.h
+///	Hierarchical timer wheel for delayed actions on game objects.
+///
+///	Authors: Chris Peters
+///	Copyright 2011, Digipen Institute of Technology
+///
+///////////////////////////////////////////////////////////////////////////////////////
+#pragma once //Makes sure this header is only included once
+
+#include "Composition.h"
+
+namespace Framework
+{
+	///Function called when a timer fires. The object is the one the timer
+	///was scheduled for, or NULL for timers not tied to an object.
+	typedef void (*TimerFunction)(GOC* object, void* data);
+
+	///Handle of a scheduled timer. Zero is never a valid timer.
+	typedef unsigned TimerId;
+
+	///Runs functions after a delay of game time. Time only moves when
+	///Advance is called, once a frame by the core with the frame's time
+	///step, so timers follow the simulation and replays are repeatable.
+	///Timers are kept in four wheels of 64 slots. The first wheel has a
+	///slot per tick, each slot of the next covers a whole turn of the one
+	///below. Scheduling and canceling are constant time, and a timer is
+	///only touched when its slot comes up: once per wheel it moves down
+	///through and once when it fires.
+	///Timers are addressed by object id, so a timer whose object has been
+	///destroyed is dropped instead of firing.
+	class TimerWheel
+	{
+	public:
+		TimerWheel();
+
+		///Length of a tick in seconds. Delays are rounded up to whole ticks.
+		static const float TickTime;
+
+		///Call the function after delay seconds with the object, if it still
+		///exists then. Pass zero as the object for timers not tied to one.
+		TimerId Schedule(float delay, GOCId object, TimerFunction function, void* data = NULL);
+		///Stop a timer from firing. Timers that fired or were already
+		///canceled are ignored, so handles never need to be cleared.
+		void Cancel(TimerId timer);
+		///Move time forward and fire the timers that come due, tick by tick.
+		void Advance(float dt);
+
+		///Game time in seconds of the last tick.
+		double GetTime();
+		///Number of timers waiting to fire.
+		unsigned GetPendingCount(){return PendingCount;}
+
+	private:
+		enum
+		{
+			SlotBits = 6,
+			SlotCount = 1 << SlotBits,
+			WheelCount = 4,
+			//Ticks beyond the last wheel are held in it until they come closer
+			MaxDelayTicks = 1 << (SlotBits * WheelCount),
+			//Timer handles are the index plus one and a generation count
+			IndexBits = 20,
+			//List of the timers firing this tick, after the wheel slots
+			DueList = WheelCount * SlotCount
+		};
+
+		typedef unsigned long long Tick;
+
+		struct Timer
+		{
+			Tick Expire;
+			GOCId Object;
+			TimerFunction Function;
+			void * Data;
+			//Links in the slot list, or the next free timer
+			int Prev;
+			int Next;
+			//Slot the timer is in, -1 when it is free
+			int Slot;
+			unsigned Generation;
+		};
+
+		void Place(int index);
+		void Unlink(int index);
+		void Release(int index);
+		void Cascade(unsigned wheel);
+		void ProcessTick();
+		int Find(TimerId timer);
+
+		std::vector<Timer> Timers;
+		int FreeList;
+		int Slots[WheelCount * SlotCount + 1];
+		Tick CurrentTick;
+		float Accumulator;
+		unsigned PendingCount;
+	};
+
+	//A global pointer to the core's timer wheel
+	extern TimerWheel* TIMERS;
+}
@@ -1,7 +1,8 @@
 ///////////////////////////////////////////////////////////////////////////////////////
 ///
 ///	\file VMath.h
-///	Typedefs the DirectX Extension math library and provides some utility functions.
+///	Includes the engine math types and provides some utility functions.
+///	Does not depend on DirectX so it can be used by headless builds.
 ///
 ///	Authors: Chris Peters
 ///	Copyright 2010, Digipen Institute of Technology
@@ -10,20 +11,14 @@
 #pragma once //Makes sure this header is only included once
 
 //Include our math headers
-#include <d3dx9.h>
 #include <cmath>
+#include <cfloat>
 #include "Serialization.h"
 #include "Vector2.hpp"
 #include "Vector3.hpp"
+#include "Vector4.hpp"
 #include "Matrix2.hpp"
-
-//#include "Vector2.hpp"
-//typedef D3DXVECTOR2 Vec2;
-//typedef D3DXVECTOR3 Vec3;
-typedef D3DXVECTOR4 Vec4;
-typedef D3DXMATRIXA16 Mat4;
-typedef D3DXVECTOR2 DxVec2;
-typedef D3DXVECTOR3 DxVec3;
+#include "Matrix4.hpp"
 
 namespace Framework
 {
@@ -121,4 +116,6 @@ namespace Framework
 	}
 
 	typedef unsigned int uint;
+
+	const float Pi = 3.14159265358979f;
 }
@@ -0,0 +1,76 @@
+#pragma once
+
+namespace Framework
+{
+
+  ///Four component vector used for colors and homogeneous points.
+  ///Laid out like D3DXVECTOR4 so the renderer can pass it straight through.
+  struct Vector4
+  {
+    Vector4()
+    {
+      x = y = z = w = 0.0f;
+    }
+
+    Vector4(float xx, float yy, float zz, float ww)
+    {
+      x = xx;
+      y = yy;
+      z = zz;
+      w = ww;
+    }
+
+    float& operator[](unsigned int index)
+    {
+      return data[index];
+    }
+
+    float operator[](unsigned int index) const
+    {
+      return data[index];
+    }
+
+    Vector4& operator+=(const Vector4& rhs)
+    {
+      x += rhs.x;
+      y += rhs.y;
+      z += rhs.z;
+      w += rhs.w;
+      return *this;
+    }
+
+    Vector4& operator*=(float rhs)
+    {
+      x *= rhs;
+      y *= rhs;
+      z *= rhs;
+      w *= rhs;
+      return *this;
+    }
+
+    Vector4 operator+(const Vector4& rhs) const
+    {
+      Vector4 ret = *this;
+      ret += rhs;
+      return ret;
+    }
+
+    Vector4 operator*(float rhs) const
+    {
+      Vector4 ret = *this;
+      ret *= rhs;
+      return ret;
+    }
+
+    union
+    {
+      struct
+      {
+        float x,y,z,w;
+      };
+      struct {float data[4];};
+    };
+  };
+
+  typedef Vector4 Vec4;
+}
@@ -9,11 +9,16 @@
 ///////////////////////////////////////////////////////////////////////////////////////
 
 #include "Precompiled.h"
+
+#ifndef G_HEADLESS
+
 #include "Core.h"
 #include "WindowsSystem.h"
 #include "Graphics.h"
 #include "Physics.h"
 #include "GameLogic.h"
+#include "StateExport.h"
+#include "InputRecording.h"
 #include <shlwapi.h>
 
 using namespace Framework;
@@ -54,11 +59,27 @@ INT WINAPI WinMain(HINSTANCE hInst, HINSTANCE hPrevInstance, LPSTR, INT)
   }
 
   bool testMode = false;
+  bool exportState = false;
+  std::string recordFile;
 
   for(int i = 0; i < argCount; i++)
   {
     if( StrCmpW(szArgList[i], L"test") == 0)
       testMode = true;
+    if( StrCmpW(szArgList[i], L"export") == 0)
+      exportState = true;
+    //record [file] writes the session's input for headless replay
+    if( StrCmpW(szArgList[i], L"record") == 0)
+    {
+      recordFile = "Session.input";
+      if( i + 1 < argCount )
+      {
+        char name[MAX_PATH];
+        WideCharToMultiByte(CP_ACP, 0, szArgList[i + 1], -1, name, MAX_PATH, NULL, NULL);
+        recordFile = name;
+        ++i;
+      }
+    }
   }
 
 
@@ -74,15 +95,32 @@ INT WINAPI WinMain(HINSTANCE hInst, HINSTANCE hPrevInstance, LPSTR, INT)
 	Graphics*graphics = new Graphics();
 	graphics->SetWindwProperties(windows->hWnd, ClientWidth, ClientHeight);
 
+	GameLogic* logic = new GameLogic();
+
 	engine->AddSystem(windows);
+	//The recorder writes each frame's record at the end of the frame,
+	//once the input the windows system queued has been sent
+	if( !recordFile.empty() )
+	{
+		InputRecorder* recorder = new InputRecorder();
+		if( recorder->Open(recordFile, logic->LevelFile) )
+			engine->AddSystem(recorder);
+		else
+			delete recorder;
+	}
 	engine->AddSystem(new GameObjectFactory());
 	engine->AddSystem(graphics);
 	engine->AddSystem(new Physics());
-	engine->AddSystem(new GameLogic());
+	engine->AddSystem(logic);
 	//TODO: Add additional systems, such as audio, and possibly xinput, lua, etc.
 
 	engine->Initialize();
 
+	//Publish the body state for external tools (see StateExportLayout.h)
+	StateExporter exporter;
+	if( exportState && exporter.Initialize(StateExport::DefaultName, 4096, 8) )
+		PHYSICS->Exporter = &exporter;
+
 	//Everything is set up, so activate the window
 	windows->ActivateWindow();
 
@@ -100,6 +138,8 @@ INT WINAPI WinMain(HINSTANCE hInst, HINSTANCE hPrevInstance, LPSTR, INT)
     engine->GameLoop();
   }
 
+	PHYSICS->Exporter = NULL;
+
 	//Delete all the game objects
 	FACTORY->DestroyAllObjects();
 
@@ -158,3 +198,5 @@ bool SignalErrorHandler(const char * exp, const char * file, int line, const cha
 	//Do not debug break
 	return true;
 }
+
+#endif
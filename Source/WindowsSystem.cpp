@@ -7,6 +7,9 @@
 //
 ///////////////////////////////////////////////////////////////////////////////////////
 #include "Precompiled.h"
+
+#ifndef G_HEADLESS
+
 #include "WindowsSystem.h"
 #include "Core.h"
 
@@ -19,27 +22,41 @@ namespace Framework
 	//(it's needed for registering/creating/unregistering the window)
 	const char windowsClassName[] = "FrameworkEngineWindowClass";
 
-	//Process any windows messages and run the game until we get a quit message
-	//While we don't use the window handle, in other cases we might want to only process messages for this window
-	void WindowsSystem::Update(float dt)
+	//Sent to the window to run a function on its thread (see RunOnWindowThread)
+	const UINT WM_RUNFUNCTION = WM_APP;
+
+	//Reported when there is no windows system
+	static const InputState NoInput;
+
+	//Read the keys on the input thread, whose key state matches
+	//the messages it has handled so far
+	static unsigned PollHeldKeys()
 	{
-		MSG msg;
-		//Look for any pending windows messages, remove them, then handle them
-		//The second parameter is the window handle--NULL just means get any message from the current thread
-		//The third and forth parameters are the start and end message types to process
-		//The last parameter determines whether or not the message is removed
-		while (PeekMessage(&msg, NULL, 0U, 0U, PM_REMOVE)) //It is important to get all windows messages available not just one
-		{
-			TranslateMessage(&msg);	//Makes sure WM_CHAR and similar messages are generated
-			DispatchMessage(&msg);	//Calls the message procedure (see below) with this message
+		unsigned keys = 0;
+		if( GetKeyState(VK_LSHIFT) < 0 || GetKeyState( VK_RSHIFT ) < 0 ) keys |= HeldKey::Shift;
+		if( GetKeyState(VK_LCONTROL) < 0 || GetKeyState( VK_RCONTROL ) < 0 ) keys |= HeldKey::Ctrl;
+		if( GetKeyState(VK_LMENU) < 0 || GetKeyState( VK_RMENU ) < 0 ) keys |= HeldKey::Alt;
+		if( GetKeyState( VK_UP ) < 0 ) keys |= HeldKey::Up;
+		if( GetKeyState( VK_DOWN ) < 0 ) keys |= HeldKey::Down;
+		if( GetKeyState( VK_LEFT ) < 0 ) keys |= HeldKey::Left;
+		if( GetKeyState( VK_RIGHT ) < 0 ) keys |= HeldKey::Right;
+		return keys;
+	}
 
-			//If we get a quit message, broadcast it to all systems
-			if (msg.message == WM_QUIT)
-			{
-				MessageQuit q;
-				CORE->BroadcastMessage(&q);
-			}
-		}
+	//Stamp an event with the current time and hand it to the main thread
+	static void PushEvent(InputEvent event)
+	{
+		event.Time = GetTimeNs();
+		WINDOWSSYSTEM->Events.Push(event);
+	}
+
+	//Deliver the input read by the input thread since the last frame
+	void WindowsSystem::Update(float dt)
+	{
+		//Start a new frame of input
+		Input.NewFrame();
+		//Events read after the frame started belong to the next one
+		Events.Deliver(Input, CORE->GetFrameStartTime());
 	}
 
 	//The message handling procedure for the game
@@ -53,59 +70,99 @@ namespace Framework
 		{
 		case WM_CHAR: //A character key was pressed
 			{
-				//Create a key message
-				MessageCharacterKey key;
+				//Create a key event
+				InputEvent e(InputEvent::Key, 0);
 				//Set the character pressed (the wParam is the ascii value)
-				key.character = wParam;
-				//Broadcast the message to all systems
-				CORE->BroadcastMessage(&key);
+				e.Value = wParam;
+				//Queue it to be broadcast to all systems
+				PushEvent(e);
 				break;
 			}
 		case WM_LBUTTONDOWN:
 			{
-				MouseButton m(MouseButton::LeftMouse,true,Vec2(WINDOWSSYSTEM->MousePosition.x,WINDOWSSYSTEM->MousePosition.y));
-				CORE->BroadcastMessage(&m);
+				InputEvent e(InputEvent::Button, 0);
+				e.Value = MouseButton::LeftMouse;
+				e.Pressed = true;
+				POINTS position = MAKEPOINTS( lParam );
+				e.Position = Vec2(position.x,position.y);
+				PushEvent(e);
 				break;
 			}
 		case WM_RBUTTONDOWN:
 			{
-				MouseButton m(MouseButton::RightMouse,true,Vec2(WINDOWSSYSTEM->MousePosition.x,WINDOWSSYSTEM->MousePosition.y));
-				CORE->BroadcastMessage(&m);
+				InputEvent e(InputEvent::Button, 0);
+				e.Value = MouseButton::RightMouse;
+				e.Pressed = true;
+				POINTS position = MAKEPOINTS( lParam );
+				e.Position = Vec2(position.x,position.y);
+				PushEvent(e);
 				break;
 			}
 		case WM_LBUTTONUP:
 			{
-				MouseButton m(MouseButton::LeftMouse,false,Vec2(WINDOWSSYSTEM->MousePosition.x,WINDOWSSYSTEM->MousePosition.y));
-				CORE->BroadcastMessage(&m);
+				InputEvent e(InputEvent::Button, 0);
+				e.Value = MouseButton::LeftMouse;
+				e.Pressed = false;
+				POINTS position = MAKEPOINTS( lParam );
+				e.Position = Vec2(position.x,position.y);
+				PushEvent(e);
 				break;
 			}
 		case WM_RBUTTONUP:
 			{
-				MouseButton m(MouseButton::RightMouse,false,Vec2(WINDOWSSYSTEM->MousePosition.x,WINDOWSSYSTEM->MousePosition.y));
-				CORE->BroadcastMessage(&m);
+				InputEvent e(InputEvent::Button, 0);
+				e.Value = MouseButton::RightMouse;
+				e.Pressed = false;
+				POINTS position = MAKEPOINTS( lParam );
+				e.Position = Vec2(position.x,position.y);
+				PushEvent(e);
 				break;
 			}
 		case WM_MOUSEMOVE:
 			{
-				WINDOWSSYSTEM->MousePosition = MAKEPOINTS( lParam );
-				MouseMove m(Vec2(WINDOWSSYSTEM->MousePosition.x,WINDOWSSYSTEM->MousePosition.y));
-				CORE->BroadcastMessage(&m);
+				//The queue folds it into a move that is still waiting
+				InputEvent e(InputEvent::Move, 0);
+				POINTS position = MAKEPOINTS( lParam );
+				e.Position = Vec2(position.x,position.y);
+				PushEvent(e);
 				break;
 			}
 		case WM_KEYDOWN: //A key was pressed
-			//TODO: Handle any key logic you might need for game controls
-			//Use virtual key codes (VK_LEFT, VK_RIGHT, VK_UP, VK_DOWN, VK_SPACE, etc.)
-			//to detect specific keys (the wParam is the key pressed) and then
-			//broadcast whatever message you need
-			break;
 		case WM_KEYUP: //A key was released
-			//TODO: Handle any key logic you might need for game controls
-			break;
-		case WM_DESTROY: //A destroy message--time to kill the game
-			//Make sure we shut everything down properly by telling Windows
-			//to post a WM_QUIT message (the parameter is the exit code).
+		case WM_SYSKEYUP:
+			{
+				//Send the keys held from now on
+				InputEvent e(InputEvent::Keys, 0);
+				e.Value = PollHeldKeys();
+				PushEvent(e);
+				break;
+			}
+		case WM_KILLFOCUS:
+			{
+				//Keys released in another window are never seen here
+				InputEvent e(InputEvent::Keys, 0);
+				PushEvent(e);
+				break;
+			}
+		case WM_CLOSE: //The user closed the window--time to kill the game
+			{
+				//Tell all the systems to quit. The window is destroyed
+				//with the windows system, after the graphics are released.
+				PushEvent(InputEvent(InputEvent::Quit, 0));
+				return 0;
+			}
+		case WM_DESTROY: //The windows system is being destroyed
+			//End the input thread by telling Windows to post a
+			//WM_QUIT message (the parameter is the exit code).
 			PostQuitMessage(0);
 			return 0;
+		case WM_RUNFUNCTION:
+			{
+				//Another thread is waiting in RunOnWindowThread
+				WindowsSystem::WindowThreadFunction function = (WindowsSystem::WindowThreadFunction)wParam;
+				function((void*)lParam);
+				return 0;
+			}
 		case WM_DROPFILES:
 			{
 				uint itemCount = DragQueryFile((HDROP)wParam, 0xFFFFFFFF,0,0);
@@ -116,13 +173,18 @@ namespace Framework
 					DragFinish((HDROP)wParam);
 
 
-					FileDrop drop(buffer);
-					CORE->BroadcastMessage(&drop);
+					InputEvent e(InputEvent::Drop, 0);
+					e.FileName = new std::string(buffer);
+					PushEvent(e);
 				}
 				return 0;
 			}
 		case WM_SYSKEYDOWN:
 			{
+				InputEvent e(InputEvent::Keys, 0);
+				e.Value = PollHeldKeys();
+				PushEvent(e);
+
 				//Eat the WM_SYSKEYDOWN message to prevent freezing the game when
 				//the alt key is pressed
 				switch( wParam )
@@ -134,7 +196,7 @@ namespace Framework
 					//Check for Alt F4
 					DWORD dwAltKeyMask = ( 1 << 29 );
 					if( ( lParam & dwAltKeyMask ) != 0 )
-						PostQuitMessage(0);
+						PushEvent(InputEvent(InputEvent::Quit, 0));
 					return 0;
 				}
 				return 0;//
@@ -146,6 +208,24 @@ namespace Framework
 		return DefWindowProc(hWnd, msg, wParam, lParam);
 	}
 
+	unsigned WindowsSystem::InputThreadMain(void* data)
+	{
+		WindowsSystem * windows = (WindowsSystem*)data;
+		//Messages for a window go to the thread that created it
+		windows->CreateGameWindow();
+		windows->WindowCreated.Signal();
+
+		//Wait for each message and handle it as soon as it arrives
+		//GetMessage returns zero on the quit message
+		MSG msg;
+		while (GetMessage(&msg, NULL, 0U, 0U) > 0)
+		{
+			TranslateMessage(&msg);	//Makes sure WM_CHAR and similar messages are generated
+			DispatchMessage(&msg);	//Calls the message procedure (see above) with this message
+		}
+		return 0;
+	}
+
 	WindowsSystem::WindowsSystem(const char* windowTitle, int ClientWidth, int ClientHeight)
 	{
 		//Check to make sure the windows system is created before the factory
@@ -154,9 +234,21 @@ namespace Framework
 		//Set the global pointer to the windows system
 		WINDOWSSYSTEM = this;
 
+		WindowTitle = windowTitle;
+		WindowWidth = ClientWidth;
+		WindowHeight = ClientHeight;
+		hWnd = NULL;
+
+		//The window is made and owned by the input thread
+		InputThread.Start(InputThreadMain, this);
+		WindowCreated.Wait();
+	}
+
+	void WindowsSystem::CreateGameWindow()
+	{
 		//The size passed to CreateWindow is the full size including the windows border and caption 
 		//AdjustWindowRect will adjust the provided rect so that the client size of the window is the desired size
-		RECT fullWinRect = {0, 0, ClientWidth, ClientHeight};
+		RECT fullWinRect = {0, 0, WindowWidth, WindowHeight};
 		AdjustWindowRect(&fullWinRect,			//The rectangle for the full size of the window
 						WS_OVERLAPPEDWINDOW,	//The style of the window, which must match what is passed in to CreateWindow below
 						FALSE);					//Does this window have a menu?
@@ -179,7 +271,7 @@ namespace Framework
 
 		//Create the game's window
 		hWnd = CreateWindow(windowsClassName,	//The class name
-			windowTitle,						//The name for the title bar
+			WindowTitle.c_str(),				//The name for the title bar
 			WS_OVERLAPPEDWINDOW,				//The style of the window (WS_BORDER, WS_MINIMIZEBOX, WS_MAXIMIZE, etc.)
 			CW_USEDEFAULT, CW_USEDEFAULT,		//The x and y position of the window (screen coords for base windows, relative coords for child windows)
 			fullWinRect.right-fullWinRect.left,	//Width of the window, including borders
@@ -190,11 +282,30 @@ namespace Framework
 			NULL);								//The lParam for the WM_CREATE message of this window
 
 		DragAcceptFiles( hWnd, true );
+	}
 
+	void WindowsSystem::RunOnWindowThread(WindowThreadFunction function, void* data)
+	{
+		//A message sent from another thread is handled by the thread that
+		//owns the window, even inside a modal loop, and SendMessage waits
+		//for it. The input thread never waits on other threads, so this
+		//can not deadlock.
+		::SendMessage(hWnd, WM_RUNFUNCTION, (WPARAM)function, (LPARAM)data);
+	}
+
+	void WindowsSystem::DestroyGameWindow(void* data)
+	{
+		WindowsSystem * windows = (WindowsSystem*)data;
+		DestroyWindow(windows->hWnd);
 	}
 
 	WindowsSystem::~WindowsSystem()
 	{
+		//Destroying the window ends the input thread. Only the thread
+		//that created a window can destroy it.
+		RunOnWindowThread(DestroyGameWindow, this);
+		InputThread.Join();
+
 		//Unregister the window class
 		UnregisterClass(windowsClassName, hInstance);
 	}
@@ -208,23 +319,10 @@ namespace Framework
 	}
 
 
-	bool IsShiftHeld()
-	{
-		return GetKeyState(VK_LSHIFT) < 0 || GetKeyState( VK_RSHIFT ) < 0;
-	}
-
-	bool IsCtrlHeld()
-	{
-		return GetKeyState(VK_LCONTROL) < 0 || GetKeyState( VK_RCONTROL ) < 0;
-	}
-
-	bool IsAltHeld()
+	const InputState& GetInput()
 	{
-		return GetKeyState(VK_LMENU) < 0 || GetKeyState( VK_RMENU ) < 0;
+		return WINDOWSSYSTEM ? WINDOWSSYSTEM->Input : NoInput;
 	}
-
-	bool IsUpHeld(){ return GetKeyState( VK_UP ) < 0; }
-	bool IsDownHeld(){ return GetKeyState( VK_DOWN ) < 0; }
-	bool IsLeftHeld(){ return GetKeyState( VK_LEFT ) < 0; }
-	bool IsRightHeld(){ return GetKeyState( VK_RIGHT ) < 0; }
 }
+
+#endif
@@ -11,74 +11,56 @@
 #pragma once //Makes sure this header is only included once
 
 #include "Engine.h"
+#include "Input.h"
+#include "InputQueue.h"
+#include "Threading.h"
 
 namespace Framework
 {
-	///Basic manager for windows. Implements the windows message pump and
-	///broadcasts user input messages to all the systems.
+	///Basic manager for windows. The window is created by a dedicated input
+	///thread that pumps the windows messages, so input is read and
+	///timestamped as it arrives however long a frame takes, and a flood of
+	///messages never holds up a frame. The events reach the main thread
+	///through a lock free queue and Update queues them as user input
+	///messages for all the systems. Mouse moves are only folded into the
+	///frame's InputState and sent once per frame.
+	///Closing the window only queues a quit message. The window lives until
+	///the system is destroyed, so the graphics can still release their
+	///device on the window's thread.
 	class WindowsSystem : public ISystem
 	{
 	public:
-		WindowsSystem(const char* windowTitle, int ClientWidth, int ClientHeight);	//The constructor
+		typedef void (*WindowThreadFunction)(void* data);
+
+		WindowsSystem(const char* windowTitle, int ClientWidth, int ClientHeight);	//The constructor, returns once the window exists
 		~WindowsSystem();															//The destructor
 
 		void ActivateWindow();								//Activate the game window so it is actually visible
+		///Run the function on the thread that owns the window and wait for it
+		///to return. Direct3D expects its device to be created, reset and
+		///released on that thread.
+		void RunOnWindowThread(WindowThreadFunction function, void* data);
 		virtual void Update(float dt);						//Update the system every frame
 		virtual std::string GetName() {return "Windows";}	//Get the string name of the system
+		virtual unsigned GetReads() {return SystemData::Input;}
+		virtual unsigned GetWrites() {return SystemData::Input;}	//Input messages are queued, not broadcast
+		virtual bool RunsOnMainThread() {return true;}		//The input queue has a single consumer, the main thread
 
 		HWND hWnd;											//The handle to the game window
 		HINSTANCE hInstance;								//The handle to the instance
-		POINTS MousePosition;
-	};
-
-	///Message signaling that a key is pressed.
-	class MessageCharacterKey : public Message
-	{
-	public:
-		MessageCharacterKey() : Message(Mid::CharacterKey) {};	
-		int character;
-	};
-
-	///Message signaling that a mouse button state has changed.
-	class MouseButton: public Message
-	{
-	public:
-		enum MouseButtonIndexId
-		{
-			LeftMouse,
-			RightMouse
-		};
-		MouseButton(MouseButtonIndexId button,bool state,Vec2 position) 
-			: Message(Mid::MouseButton) ,  MouseButtonIndex(button) , ButtonIsPressed(state), MousePosition(position) {};
+		InputState Input;									//The input gathered this frame
+		InputQueue Events;									//Events read by the input thread, waiting to be delivered
 
-		MouseButtonIndexId MouseButtonIndex;
-		bool ButtonIsPressed;
-		Vec2 MousePosition;
+	private:
+		static unsigned InputThreadMain(void* data);		//Creates the window and pumps its messages until it is destroyed
+		static void DestroyGameWindow(void* data);
+		void CreateGameWindow();
+		std::string WindowTitle;
+		int WindowWidth;
+		int WindowHeight;
+		Thread InputThread;
+		ThreadEvent WindowCreated;
 	};
 
-	///Message signaling that the mouse has moved.
-	class MouseMove: public Message
-	{
-	public:
-		MouseMove(Vec2 position) : Message(Mid::MouseMove) , MousePosition(position) {};	
-		Vec2 MousePosition;
-	};
-
-	///Message signaling that a file was dropped onto the window.
-	class FileDrop: public Message
-	{
-	public:
-		FileDrop(std::string filename) : Message(Mid::FileDrop) , FileName(filename) {};	
-		std::string FileName;
-	};
-
-	bool IsShiftHeld();
-	bool IsCtrlHeld();
-	bool IsAltHeld();
-	bool IsUpHeld();
-	bool IsDownHeld();
-	bool IsLeftHeld();
-	bool IsRightHeld();
-
 	extern WindowsSystem* WINDOWSSYSTEM;
 }
\ No newline at end of file
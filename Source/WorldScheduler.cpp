@@ -0,0 +1,92 @@
+///////////////////////////////////////////////////////////////////////////////////////
+//
+//	WorldScheduler.cpp
+//
+//	Authors: Chris Peters
+//	Copyright 2011, Digipen Institute of Technology
+//
+///////////////////////////////////////////////////////////////////////////////////////
+#include "Precompiled.h"
+#include "WorldScheduler.h"
+#include <algorithm>
+
+namespace Framework
+{
+	WorldScheduler::WorldScheduler()
+	{
+		StepTime = 0.0f;
+		TimeAccumulation = 0.0f;
+	}
+
+	WorldScheduler::~WorldScheduler()
+	{
+		for(unsigned i=0;i<Worlds.size();++i)
+			delete Worlds[i];
+	}
+
+	Physics* WorldScheduler::CreateWorld()
+	{
+		Physics * world = new Physics();
+		world->InitializeWorld(1);
+		Worlds.push_back(world);
+		return world;
+	}
+
+	void WorldScheduler::DestroyWorld(Physics* world)
+	{
+		Worlds.erase( std::remove(Worlds.begin(), Worlds.end(), world) , Worlds.end() );
+		delete world;
+	}
+
+	void WorldScheduler::StepWorld(void* data)
+	{
+		WorldJob * job = (WorldJob*)data;
+		job->World->Step(job->Owner->StepTime);
+	}
+
+	void WorldScheduler::Step(float dt)
+	{
+		if( Worlds.empty() )
+			return;
+
+		StepTime = dt;
+
+		if( JOBS == NULL || JOBS->GetThreadCount() == 0 )
+		{
+			for(unsigned i=0;i<Worlds.size();++i)
+				Worlds[i]->Step(dt);
+		}
+		else
+		{
+			//Filled before submitting so the array never moves under a job
+			Jobs.resize(Worlds.size());
+			for(unsigned i=0;i<Worlds.size();++i)
+			{
+				Jobs[i].Owner = this;
+				Jobs[i].World = Worlds[i];
+			}
+
+			JobCounter counter;
+			for(unsigned i=0;i<Jobs.size();++i)
+				JOBS->Submit(StepWorld, &Jobs[i], &counter);
+			JOBS->Wait(&counter);
+		}
+
+		//Messages go out in world order after every world is done
+		for(unsigned i=0;i<Worlds.size();++i)
+			Worlds[i]->DeliverEvents();
+	}
+
+	void WorldScheduler::Update(float dt)
+	{
+		//The same fixed step and catch up limit as the default world
+		const float TimeStep = 1.0f / 60.0f;
+		TimeAccumulation += dt;
+		TimeAccumulation = std::min( TimeAccumulation , TimeStep * 5 );
+		if( TimeAccumulation > TimeStep )
+		{
+			TimeAccumulation -= TimeStep;
+			Step( TimeStep );
+		}
+	}
+}
@@ -0,0 +1,80 @@
+///////////////////////////////////////////////////////////////////////////////////////
+///
+///	\file WorldScheduler.h
+///	Steps many independent physics worlds across all the cores.
+///
+///	Authors: Chris Peters
+///	Copyright 2011, Digipen Institute of Technology
+///
+///////////////////////////////////////////////////////////////////////////////////////
+#pragma once //Makes sure this header is only included once
+
+#include "Physics.h"
+#include "JobSystem.h"
+
+namespace Framework
+{
+	///System that steps a set of physics worlds at the fixed physics rate,
+	///for hosting many matches or sandboxes in one process. A world's step
+	///only writes its own bodies, constraints and their transforms, so each
+	///one is stepped whole as a single job on the engine job system, and
+	///idle threads steal worlds from busy ones, which balances worlds of
+	///different sizes. Once every world is done their collision and sensor
+	///messages are sent from the thread updating the scheduler, so game
+	///logic never runs on the workers.
+	///
+	///What the worlds still share:
+	///- Their objects live in the one FACTORY. Ids, the object map and the
+	///  component creators are not locked, so create and destroy objects
+	///  only from the thread updating the scheduler, never during Step.
+	///  Create objects with Physics::CreateObject so their bodies are given
+	///  the world.
+	///- Messages look objects up in FACTORY, which is why they wait for
+	///  DeliverEvents.
+	///- The job system and the heap. Worlds allocate while they step and
+	///  contend on the heap lock.
+	///- Nothing else global is touched. Scheduled worlds are never debug
+	///  drawn and never read the camera, so only their interest points
+	///  drive level of detail.
+	///The default world (PHYSICS) is stepped by its own system as before.
+	class WorldScheduler : public ISystem
+	{
+	public:
+		WorldScheduler();
+		///Deletes the worlds. Destroy their objects first.
+		~WorldScheduler();
+
+		///Create a world stepped by the scheduler. It runs single threaded
+		///since the scheduler already uses every core, and it is owned by
+		///the scheduler.
+		Physics* CreateWorld();
+		///Delete a world created by CreateWorld.
+		void DestroyWorld(Physics* world);
+
+		///Step every world once by dt and send their messages. Returns when
+		///all worlds are done.
+		void Step(float dt);
+
+		virtual void Update(float dt);
+		virtual std::string GetName(){return "WorldScheduler";}
+		///Moves the bodies and transforms of the worlds' objects and sends
+		///them collision messages.
+		virtual unsigned GetReads(){return SystemData::Bodies | SystemData::Transforms;}
+		virtual unsigned GetWrites(){return SystemData::Bodies | SystemData::Transforms | SystemData::Objects;}
+		///Messages are sent where the core runs main thread systems.
+		virtual bool RunsOnMainThread(){return true;}
+
+		std::vector<Physics*> Worlds;
+
+	private:
+		struct WorldJob
+		{
+			WorldScheduler * Owner;
+			Physics * World;
+		};
+		static void StepWorld(void* data);
+		std::vector<WorldJob> Jobs;
+		float StepTime;
+		float TimeAccumulation;
+	};
+}
@@ -0,0 +1,103 @@
+///////////////////////////////////////////////////////////////////////////////////////
+//
+//	StateReader.cpp
+//	Sample reader for the shared memory state export. Run the game with the
+//	"export" argument, then run this tool to print the newest step as it is
+//	published. Build from a Visual Studio command prompt with:
+//		cl /EHsc /I..\..\Source StateReader.cpp
+//
+//	Authors: Chris Peters
+//	Copyright 2011, Digipen Institute of Technology
+//
+///////////////////////////////////////////////////////////////////////////////////////
+#include <windows.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "StateExportLayout.h"
+
+using namespace Framework::StateExport;
+
+//Copy a slot using the seqlock protocol. Returns false if the slot was
+//being written or changed while it was copied.
+bool ReadSlot(const char* slotMemory, unsigned slotSize, std::vector<char>& copy)
+{
+	const SlotHeader * slot = (const SlotHeader*)slotMemory;
+	unsigned before = slot->Sequence;
+	if( before & 1 )
+		return false;
+	MemoryBarrier();
+
+	memcpy(&copy[0], slotMemory, slotSize);
+
+	MemoryBarrier();
+	unsigned after = slot->Sequence;
+	return before == after;
+}
+
+int main(int argc, char** argv)
+{
+	const char * name = argc > 1 ? argv[1] : DefaultName;
+
+	HANDLE mapping = OpenFileMapping(FILE_MAP_READ, FALSE, name);
+	if( mapping == NULL )
+	{
+		printf("Could not open '%s'. Is the game running with the export argument?\n", name);
+		return 1;
+	}
+
+	const char * view = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if( view == NULL )
+	{
+		CloseHandle(mapping);
+		return 1;
+	}
+
+	const Header * header = (const Header*)view;
+	if( header->Magic != Magic || header->Version != Version )
+	{
+		printf("Unknown state export format.\n");
+		UnmapViewOfFile(view);
+		CloseHandle(mapping);
+		return 1;
+	}
+
+	printf("%u slots, %u bodies max\n", header->SlotCount, header->MaxBodies);
+
+	std::vector<char> copy(header->SlotSize);
+	unsigned lastStep = 0;
+	unsigned missedSteps = 0;
+
+	for(;;)
+	{
+		unsigned latest = header->LatestStep;
+		if( latest == lastStep )
+		{
+			Sleep(1);
+			continue;
+		}
+
+		const char * slotMemory = view + sizeof(Header) + (latest % header->SlotCount) * header->SlotSize;
+		if( !ReadSlot(slotMemory, header->SlotSize, copy) )
+			continue;
+
+		const SlotHeader * slot = (const SlotHeader*)&copy[0];
+		const BodyState * bodies = (const BodyState*)(slot + 1);
+
+		//Slow readers skip steps rather than slowing the game down
+		if( lastStep != 0 && slot->StepNumber > lastStep + 1 )
+			missedSteps += slot->StepNumber - lastStep - 1;
+		lastStep = slot->StepNumber;
+
+		unsigned totalContacts = 0;
+		for(unsigned i=0;i<slot->BodyCount;++i)
+			totalContacts += bodies[i].ContactCount;
+
+		printf("step %u: %u bodies, %u contacts, %u missed", slot->StepNumber, slot->BodyCount, totalContacts, missedSteps);
+		if( slot->BodyCount > 0 )
+			printf(", object %u at (%.1f, %.1f)", bodies[0].ObjectId, bodies[0].PositionX, bodies[0].PositionY);
+		printf("\n");
+	}
+
+	return 0;
+}